@@ -60,6 +60,8 @@ void performacnceTest() {
 	
 	std::cout << " in " << duration.count() << " sec " << std::endl;
 	std::cout << "Cache Write Throughput: " << db.getWriteThroughput() << "Mb/s" << std::endl;
+	std::cout << "Storage Read I/O: " << db.getStats(CachedFileStats::STORAGE_BYTES_READ) / (1024 * 1024) << "Mb, ";
+	std::cout << "fetches skipped on write: " << db.getStats(CachedFileStats::SKIPPED_FETCHES) << std::endl;
 
 	// even number
 	uint64_t ID = 621923; 
@@ -10,6 +10,7 @@
 *  - Support cursors for linear records traversal.
 *  - Support for on-disk as well in-memory databases.
 *  - Support Terabyte sized databases.
+*  - Online compaction that shrinks database file.
 *
 *  (C) Boson Database, Bolat Basheyev 2022-2024
 *
@@ -25,7 +26,8 @@ using namespace Boson;
 *  @brief Boson API constructructor
 */
 BosonAPI::BosonAPI() {
-    cachedFile = nullptr;
+    storageFile = nullptr;
+    storageDevice = nullptr;
     recordFile = nullptr;
     balancedIndex = nullptr;
     isReadOnly = false;
@@ -36,8 +38,8 @@ BosonAPI::BosonAPI() {
 *  @brief Boson API destructructor
 */
 BosonAPI::~BosonAPI() {
-    if (cachedFile != nullptr) {
-        if (cachedFile->isOpen()) close();
+    if (storageFile != nullptr) {
+        if (storageFile->isOpen()) close();
     }
 }
 
@@ -46,22 +48,73 @@ BosonAPI::~BosonAPI() {
 *  @brief Opens database file and allocate required resources
 *  @param filename - path to file (C-style string)
 *  @param readOnly - true to open with read only rights, false to write permission (default)
+*  @param cacheSize - cache size in bytes (cached file storage)
+*  @param storage - storage implementation: user-space page cache (default), memory mapped file
+*  or in-memory database (filename is not used, data is released on close)
+*  @param pageSize - page size of new database (existing database keeps its page size)
 *  @return true if database file successfuly opened, false if not
 */
-bool BosonAPI::open(char* filename, bool readOnly, size_t cacheSize) {
+bool BosonAPI::open(char* filename, bool readOnly, size_t cacheSize, StorageType storage, size_t pageSize) {
+    if (!isValidPageSize(pageSize)) return false;
     isReadOnly = readOnly;
-    cachedFile = new CachedFileIO();
-    if (!cachedFile->open(filename, cacheSize, readOnly)) {
-        delete cachedFile;
-        cachedFile = nullptr;
+    bool isOpen = false;
+    if (storage == StorageType::MAPPED_FILE) {
+        MappedFileIO* mappedFile = new MappedFileIO();
+        mappedFile->setPageSize(pageSize);
+        isOpen = mappedFile->open(filename, readOnly);
+        storageFile = mappedFile;
+    } else {
+        CachedFileIO* cachedFile = new CachedFileIO();
+        cachedFile->setPageSize(pageSize);
+        if (storage == StorageType::IN_MEMORY) {
+            storageDevice = new MemoryDevice();
+            cachedFile->setStorageDevice(storageDevice);
+        }
+        isOpen = cachedFile->open(filename, cacheSize, readOnly);
+        storageFile = cachedFile;
+    }
+    if (!isOpen) {
+        delete storageFile;
+        storageFile = nullptr;
+        if (storageDevice != nullptr) delete storageDevice;
+        storageDevice = nullptr;
         return false;
     }
-    recordFile = new RecordFileIO(*cachedFile);
+    recordFile = new RecordFileIO(*storageFile);
     balancedIndex = new BalancedIndex(*recordFile);    
     return true;
 }
 
 
+/*
+*  @brief Opens database file drawing cache pages from the pool shared with
+*  other open databases (one memory cap for all of them)
+*  @param filename - path to file (C-style string)
+*  @param pool - allocated pages pool, page size of new database is pool
+*  page size (database of another page size is not opened)
+*  @param readOnly - true to open with read only rights, false to write permission (default)
+*  @return true if database file successfuly opened, false if not
+*/
+bool BosonAPI::open(char* filename, BufferPool& pool, bool readOnly) {
+    isReadOnly = readOnly;
+    CachedFileIO* cachedFile = new CachedFileIO();
+    if (!cachedFile->open(filename, pool, readOnly)) {
+        delete cachedFile;
+        return false;
+    }
+    storageFile = cachedFile;
+    try {
+        recordFile = new RecordFileIO(*storageFile);
+    } catch (std::runtime_error&) {
+        // database page size differs from pool page size
+        close();
+        return false;
+    }
+    balancedIndex = new BalancedIndex(*recordFile);
+    return true;
+}
+
+
 /*
 *  @brief Close database file and release resources
 *  @return true if file was closed, false if it wasn't open
@@ -70,11 +123,13 @@ bool BosonAPI::close() {
     if (balancedIndex != nullptr) delete balancedIndex;            
     if (recordFile != nullptr) delete recordFile;    
     bool wasOpen = false;
-    if (cachedFile != nullptr) {
-        wasOpen = cachedFile->close();
-        delete cachedFile;        
+    if (storageFile != nullptr) {
+        wasOpen = storageFile->close();
+        delete storageFile;        
     }    
-    cachedFile = nullptr;
+    if (storageDevice != nullptr) delete storageDevice;
+    storageFile = nullptr;
+    storageDevice = nullptr;
     recordFile = nullptr;
     balancedIndex = nullptr;
     return wasOpen;
@@ -197,8 +252,8 @@ std::pair<uint64_t, std::shared_ptr<std::string>> BosonAPI::previous() {
 *  @return percent of cache hits on read/write operations
 */
 double BosonAPI::getCacheHits() {
-    if (cachedFile == nullptr) return 0;
-    return cachedFile->getStats(CachedFileStats::CACHE_HITS_RATE);
+    if (storageFile == nullptr) return 0;
+    return storageFile->getStats(CachedFileStats::CACHE_HITS_RATE);
 }
 
 
@@ -206,20 +261,89 @@ double BosonAPI::getCacheHits() {
 *  @brief writes all cached data to storage
 */
 void BosonAPI::flush() {
-    if (cachedFile == nullptr) return;
-    cachedFile->flush();
+    if (storageFile == nullptr) return;
+    storageFile->flush();
+}
+
+
+/*
+*  @brief Runs one step of online compaction: moves records toward the
+*  beginning of database file, shrinks file when compaction pass is over
+*  @param maxRecords records examined by the step
+*  @return true if compaction is complete or nothing to compact (database
+*  is not open or read only), false if more steps needed
+*/
+bool BosonAPI::compact(uint32_t maxRecords) {
+    if (balancedIndex == nullptr || isReadOnly) return true;
+    return balancedIndex->compact(maxRecords);
+}
+
+
+/*
+*  @brief Return progress of running or the last compaction pass
+*  @return share of entries visited by compaction pass (0.0 - 1.0)
+*/
+double BosonAPI::getCompactionProgress() {
+    if (balancedIndex == nullptr) return 0;
+    return balancedIndex->getCompactionProgress();
+}
+
+
+/*
+*  @brief Return bytes reclaimed by running or the last compaction pass
+*  @return decrease of database file size in bytes
+*/
+uint64_t BosonAPI::getReclaimedBytes() {
+    if (balancedIndex == nullptr) return 0;
+    return balancedIndex->getReclaimedBytes();
 }
 
 
 double BosonAPI::getReadThroughput() {
-    if (cachedFile == nullptr) return 0;
-    return cachedFile->getStats(CachedFileStats::READ_THROUGHPUT);
+    if (storageFile == nullptr) return 0;
+    return storageFile->getStats(CachedFileStats::READ_THROUGHPUT);
 }
 
 
 double BosonAPI::getWriteThroughput() {
+    if (storageFile == nullptr) return 0;
+    return storageFile->getStats(CachedFileStats::WRITE_THROUGHPUT);
+}
+
+
+/*
+*  @brief Return storage file statistics
+*  @param type - requested stats type
+*  @return value of stats
+*/
+double BosonAPI::getStats(CachedFileStats type) {
+    if (storageFile == nullptr) return 0;
+    return storageFile->getStats(type);
+}
+
+
+/*
+*  @brief Takes structured snapshot of storage file statistics: counters
+*  and latency percentiles (empty snapshot if database is not open)
+*  @param stats - statistics snapshot
+*/
+void BosonAPI::getStatsSnapshot(FileIOStats& stats) {
+    stats = {};
+    if (storageFile == nullptr) return;
+    storageFile->getStatsSnapshot(stats);
+}
+
+
+/*
+*  @brief Resizes cache of open database keeping cached pages
+*  (memory mapped storage is cached by OS and is not resized)
+*  @param cacheSize - new cache size in bytes
+*  @return actual cache size in bytes or 0 if storage has no cache
+*/
+size_t BosonAPI::setCacheSize(size_t cacheSize) {
+    CachedFileIO* cachedFile = dynamic_cast<CachedFileIO*>(storageFile);
     if (cachedFile == nullptr) return 0;
-    return cachedFile->getStats(CachedFileStats::WRITE_THROUGHPUT);
+    return cachedFile->setCacheSize(cacheSize);
 }
 
 
@@ -18,6 +18,7 @@
 #pragma once
 
 #include "CachedFileIO.h"
+#include "MappedFileIO.h"
 #include "RecordFileIO.h"
 #include "BalancedIndex.h"
 
@@ -30,7 +31,8 @@ namespace Boson {
         BosonAPI();
         ~BosonAPI();
 
-        bool open(char* filename, bool readOnly = false, size_t cacheSize = DEFAULT_CACHE);
+        bool open(char* filename, bool readOnly = false, size_t cacheSize = DEFAULT_CACHE, StorageType storage = StorageType::CACHED_FILE, size_t pageSize = PAGE_SIZE);
+        bool open(char* filename, BufferPool& pool, bool readOnly = false);
         bool close();
 
         uint64_t size();
@@ -48,15 +50,23 @@ namespace Boson {
 
         void flush();
 
+        bool     compact(uint32_t maxRecords = COMPACT_STEP_RECORDS);
+        double   getCompactionProgress();
+        uint64_t getReclaimedBytes();
+
         double getCacheHits();
         double getReadThroughput();
         double getWriteThroughput();
+        double getStats(CachedFileStats type);
+        void   getStatsSnapshot(FileIOStats& stats);
+        size_t setCacheSize(size_t cacheSize);
 
 
         void printTreeState();
 
     private:
-        CachedFileIO* cachedFile;
+        FileIO* storageFile;
+        StorageDevice* storageDevice;
         RecordFileIO* recordFile;
         BalancedIndex* balancedIndex;
         bool isReadOnly;
@@ -40,6 +40,10 @@ BalancedIndex::BalancedIndex(RecordFileIO& rf) : recordsFile(rf) {
     cursorIndex = KEY_NOT_FOUND;
     // set like if tree changed to protect call to next(), previous() before first(), last()
     isTreeChanged = true;
+    // compaction is not running
+    compactionKey = NOT_FOUND;
+    compactedEntries = 0;
+    compactionStartSize = 0;
 }
 
 
@@ -73,7 +77,7 @@ uint64_t BalancedIndex::getNextIndexCounter() {
 
 
 /*
-*  @brief Searches LeafNode that contains the key
+*  @brief Searches LeafNode that contains the key (point access)
 *  @param key to search
 *  @return leaf node that possibly contains the key
 */
@@ -83,6 +87,9 @@ std::shared_ptr<LeafNode> BalancedIndex::findLeafNode(uint64_t key) {
     std::shared_ptr<InnerNode> innerNode;
     uint32_t childIndex;
 
+    // Tree traversal from the root is point access, cursor sets scan hint itself
+    recordsFile.setAccessHint(AccessHint::NORMAL);
+
 #ifdef _DEBUG
     std::cout << std::endl;
     std::cout << "Searching for a leaf node starting from root node (" << root->position << ")" << std::endl;
@@ -253,7 +260,10 @@ bool BalancedIndex::erase(uint64_t key) {
             uint64_t newRootPos = leaf->dealUnderflow();
             // if root changed
             if (newRootPos != NOT_FOUND) {                
+                uint64_t oldRootPos = indexHeader.rootPosition;
                 updateRoot(newRootPos);
+                // release collapsed old root, nothing references it
+                if (oldRootPos != newRootPos) Node::deleteNode(*this, oldRootPos);
             } else {
                 // update the root anyway if the data possibly changed
                 root = Node::loadNode(*this, indexHeader.rootPosition);
@@ -291,6 +301,8 @@ std::pair<uint64_t, std::shared_ptr<std::string>> BalancedIndex::first() {
     std::shared_ptr<LeafNode> leaf = findLeafNode(0); 
     cursorNode = leaf;
     cursorIndex = 0;
+    // Cursor traversal reads leaves and values as sequential scan
+    recordsFile.setAccessHint(AccessHint::SEQUENTIAL);
 
     // if no entries then return empty pair
     if (cursorNode->getKeyCount() == 0) {
@@ -317,6 +329,8 @@ std::pair<uint64_t, std::shared_ptr<std::string>> BalancedIndex::last() {
     // NOT_FOUND is maximal key value for uint64_t so it would be the last node
     std::shared_ptr<LeafNode> leaf = findLeafNode(NOT_FOUND);
     cursorNode = leaf;
+    // Cursor traversal reads leaves and values as sequential scan
+    recordsFile.setAccessHint(AccessHint::SEQUENTIAL);
     
     // if no entries then return empty pair
     if (cursorNode->getKeyCount() == 0) {
@@ -347,6 +361,9 @@ std::pair<uint64_t, std::shared_ptr<std::string>> BalancedIndex::next() {
     // check if cursor node and index are valid or return empty pair
     if (cursorNode == nullptr || cursorIndex == KEY_NOT_FOUND || isTreeChanged) return empty;
 
+    // Cursor traversal reads leaves and values as sequential scan
+    recordsFile.setAccessHint(AccessHint::SEQUENTIAL);
+
     // increment index
     cursorIndex++;
     
@@ -381,6 +398,9 @@ std::pair<uint64_t, std::shared_ptr<std::string>> BalancedIndex::previous() {
     // check if cursor node and index are valid or return empty pair
     if (cursorNode == nullptr || isTreeChanged) return empty;
 
+    // Cursor traversal reads leaves and values as sequential scan
+    recordsFile.setAccessHint(AccessHint::SEQUENTIAL);
+
     // decrement index
     cursorIndex--;
 
@@ -403,6 +423,171 @@ std::pair<uint64_t, std::shared_ptr<std::string>> BalancedIndex::previous() {
 }
 
 
+/*
+*  @brief Runs one step of incremental compaction: values and nodes located
+*  beyond compact size of the file are moved to free space below it, leaf
+*  values, node children, siblings and parents referencing moved records are
+*  updated. Steps interleave with other operations, every step resumes pass
+*  from the next leaf. When pass is over free space at the end is cut off.
+*  @param maxRecords - records examined by the step (at least one leaf)
+*  @return true if compaction pass is complete, false if more steps needed
+*/
+bool BalancedIndex::compact(uint32_t maxRecords) {
+    // start new pass from the index header (the first record)
+    if (compactionKey == NOT_FOUND) {
+        compactionKey = 0;
+        compactedEntries = 0;
+        compactionStartSize = recordsFile.getEndOfFile();
+        if (recordsFile.first()) {
+            recordsFile.moveRecord(recordsFile.getPosition(), recordsFile.getCompactSize());
+        }
+    }
+
+    bool isPassOver = false;
+    bool isMoved = false;
+    uint32_t examined = 0;
+    recordsFile.setAccessHint(AccessHint::NORMAL);
+
+    do {
+        uint64_t limit = recordsFile.getCompactSize();
+
+        // drill down to the leaf of the next key moving inner nodes on the path
+        std::shared_ptr<Node> node = Node::loadNode(*this, indexHeader.rootPosition);
+        uint64_t parentPosition = NOT_FOUND;
+        while (node->getNodeType() == NodeType::INNER) {
+            if (moveNode(node, parentPosition, limit) != NOT_FOUND) isMoved = true;
+            parentPosition = node->position;
+            std::shared_ptr<InnerNode> innerNode = std::dynamic_pointer_cast<InnerNode>(node);
+            node = Node::loadNode(*this, innerNode->getChildAt(innerNode->search(compactionKey)));
+            examined++;
+        }
+        std::shared_ptr<LeafNode> leaf = std::dynamic_pointer_cast<LeafNode>(node);
+
+        // move values of the leaf, then the leaf itself
+        bool isLeafChanged = false;
+        for (uint32_t i = 0; i < leaf->data.valuesCount; i++) {
+            uint64_t valuePosition = leaf->data.values[i];
+            if (valuePosition < limit) continue;
+            uint64_t newPosition = recordsFile.moveRecord(valuePosition, limit);
+            if (newPosition == NOT_FOUND || newPosition == valuePosition) continue;
+            leaf->data.values[i] = newPosition;
+            isLeafChanged = true;
+        }
+        if (isLeafChanged) {
+            leaf->persist();
+            isMoved = true;
+        }
+        if (moveNode(leaf, parentPosition, limit) != NOT_FOUND) isMoved = true;
+        examined += leaf->data.valuesCount + 1;
+        compactedEntries += leaf->getKeyCount();
+
+        // resume from the first key of the right sibling (next leaf), it
+        // could be greater than separator of this leaf in the parent, keys
+        // must grow to finish pass even if leaves are inconsistent
+        if (leaf->getRightSibling() != NOT_FOUND) {
+            std::shared_ptr<Node> nextLeaf = Node::loadNode(*this, leaf->getRightSibling());
+            if (nextLeaf->getKeyCount() > 0 && nextLeaf->getKeyAt(0) > compactionKey) {
+                compactionKey = nextLeaf->getKeyAt(0);
+            } else isPassOver = true;
+        } else isPassOver = true;
+    } while (!isPassOver && examined < maxRecords);
+
+    if (isMoved) {
+        // in memory root and cursor could reference moved records
+        root = Node::loadNode(*this, indexHeader.rootPosition);
+        isTreeChanged = true;
+    }
+    if (!isPassOver) return false;
+
+    // cut off free space at the end of file
+    recordsFile.shrinkFile();
+    compactionKey = NOT_FOUND;
+    return true;
+}
+
+
+/*
+*  @brief Returns progress of running or the last compaction pass
+*  @return share of entries visited by compaction pass (0.0 - 1.0)
+*/
+double BalancedIndex::getCompactionProgress() {
+    if (compactionStartSize == 0) return 0.0;
+    if (compactionKey == NOT_FOUND || size() == 0) return 1.0;
+    return std::min(1.0, double(compactedEntries) / double(size()));
+}
+
+
+/*
+*  @brief Returns bytes of the file reclaimed by running or the last
+*  compaction pass
+*  @return end of file decrease since compaction pass start in bytes
+*/
+uint64_t BalancedIndex::getReclaimedBytes() {
+    uint64_t endOfFile = recordsFile.getEndOfFile();
+    if (compactionStartSize <= endOfFile) return 0;
+    return compactionStartSize - endOfFile;
+}
+
+
+/*
+*  @brief Moves node located beyond the limit offset to free space below
+*  the limit and updates references to the node: parent's children (or
+*  index header root position), siblings and parent of node's children
+*  @param node loaded node
+*  @param parentPosition position of parent node (NOT_FOUND for root)
+*  @param limit offset of compact file end
+*  @return new node position or NOT_FOUND if node is not moved
+*/
+uint64_t BalancedIndex::moveNode(std::shared_ptr<Node> node, uint64_t parentPosition, uint64_t limit) {
+    uint64_t oldPosition = node->position;
+    if (oldPosition < limit) return NOT_FOUND;
+    uint64_t newPosition = recordsFile.moveRecord(oldPosition, limit);
+    if (newPosition == NOT_FOUND || newPosition == oldPosition) return NOT_FOUND;
+    node->position = newPosition;
+
+    // parent references node as a child, index header references root
+    if (parentPosition == NOT_FOUND) {
+        indexHeader.rootPosition = newPosition;
+        persistIndexHeader();
+    } else {
+        std::shared_ptr<Node> parent = Node::loadNode(*this, parentPosition);
+        for (uint32_t i = 0; i < parent->data.childrenCount; i++) {
+            if (parent->data.children[i] == oldPosition) {
+                parent->data.children[i] = newPosition;
+                parent->persist();
+                break;
+            }
+        }
+    }
+
+    // siblings reference node
+    if (node->getLeftSibling() != NOT_FOUND) {
+        std::shared_ptr<Node> sibling = Node::loadNode(*this, node->getLeftSibling());
+        if (sibling->getRightSibling() == oldPosition) {
+            sibling->setRightSibling(newPosition);
+            sibling->persist();
+        }
+    }
+    if (node->getRightSibling() != NOT_FOUND) {
+        std::shared_ptr<Node> sibling = Node::loadNode(*this, node->getRightSibling());
+        if (sibling->getLeftSibling() == oldPosition) {
+            sibling->setLeftSibling(newPosition);
+            sibling->persist();
+        }
+    }
+
+    // children of inner node reference it as parent
+    if (node->getNodeType() == NodeType::INNER) {
+        for (uint32_t i = 0; i < node->data.childrenCount; i++) {
+            std::shared_ptr<Node> child = Node::loadNode(*this, node->data.children[i]);
+            child->setParent(newPosition);
+            child->persist();
+        }
+    }
+    return newPosition;
+}
+
+
 /*
 *  @brief returns RecordFileIO object
 *  @return RecordFileIO object
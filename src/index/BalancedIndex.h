@@ -28,6 +28,7 @@ namespace Boson {
     constexpr uint64_t MAX_DEGREE = TREE_ORDER - 1;
     constexpr uint64_t MIN_DEGREE = TREE_ORDER / 2;
     constexpr uint32_t KEY_NOT_FOUND = -1;
+    constexpr uint32_t COMPACT_STEP_RECORDS = 256;     // Records examined by one compaction step
 
     typedef enum : uint32_t { INNER = 1, LEAF = 2 } NodeType;
     typedef enum : uint32_t { KEYS = 1, CHILDREN = 2, VALUES = 2 } NodeArray;
@@ -204,6 +205,10 @@ namespace Boson {
         std::pair<uint64_t, std::shared_ptr<std::string>> next();
         std::pair<uint64_t, std::shared_ptr<std::string>> previous();
 
+        bool     compact(uint32_t maxRecords = COMPACT_STEP_RECORDS);
+        double   getCompactionProgress();
+        uint64_t getReclaimedBytes();
+
         void printTree();        
 
     protected:
@@ -213,6 +218,7 @@ namespace Boson {
         std::shared_ptr<LeafNode> findLeafNode(uint64_t key);                
         void updateRoot(uint64_t newRootPosition);
         void persistIndexHeader();
+        uint64_t moveNode(std::shared_ptr<Node> node, uint64_t parentPosition, uint64_t limit);
         void printTreeLevel(std::shared_ptr<Node> node, int level);
 
     private:
@@ -223,6 +229,10 @@ namespace Boson {
         std::shared_ptr<LeafNode> cursorNode;
         uint32_t cursorIndex;
         bool isTreeChanged;
+
+        uint64_t compactionKey;       // next key of running compaction pass (NOT_FOUND if idle)
+        uint64_t compactedEntries;    // entries visited by compaction pass
+        uint64_t compactionStartSize; // end of file when compaction pass started (0 if never run)
     };
 
 
@@ -78,6 +78,14 @@ std::shared_ptr<std::string> LeafNode::getValueAt(uint32_t index) {
     uint64_t offsetInFile = data.values[index];
     recordsFile.setPosition(offsetInFile);    
 
+    // Value within one cache page is converted to C++ string directly from cache
+    PinnedPage pinnedValue = recordsFile.pinRecordData();
+    if (pinnedValue.isPinned()) {
+        // value is stored as C style string with null terminator
+        const char* cStr = (const char*) pinnedValue.data();
+        return std::make_shared<std::string>(cStr, strnlen(cStr, pinnedValue.length()));
+    }
+
     // load data from storage file record
     uint32_t valueLength = recordsFile.getDataLength() + 1;
     // allocate memory buffer to read value
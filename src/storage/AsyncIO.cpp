@@ -0,0 +1,279 @@
+/******************************************************************************
+*
+*  AsyncIO class implementation
+*
+*  AsyncIO submits group of file read/write requests to the kernel with one
+*  system call and waits for all of them to complete. On Linux it is based
+*  on io_uring (raw system calls, no liburing dependency). If io_uring is
+*  not supported by platform or kernel, AsyncIO is not available and
+*  callers use synchronous file I/O.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "AsyncIO.h"
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define BOSON_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+using namespace Boson;
+
+
+/**
+* @brief Constructor
+*/
+AsyncIO::AsyncIO() {
+	this->fileDescriptor = -1;
+	this->ringDescriptor = -1;
+	this->queueDepth = 0;
+	this->submitCalls = 0;
+	this->sqRing = nullptr;
+	this->cqRing = nullptr;
+	this->sqEntries = nullptr;
+	this->sqRingSize = 0;
+	this->cqRingSize = 0;
+	this->sqEntriesSize = 0;
+	this->sqHead = this->sqTail = this->sqMask = this->sqArray = nullptr;
+	this->cqHead = this->cqTail = this->cqMask = nullptr;
+	this->cqEntries = nullptr;
+}
+
+
+/**
+* @brief Destructor releases io_uring
+*/
+AsyncIO::~AsyncIO() {
+	close();
+}
+
+
+/**
+*
+*  @brief Sets up io_uring for the file
+*
+*  @param fileDescriptor - OS file descriptor of open file
+*  @param queueDepth - submission queue entries
+*
+*  @return true if io_uring is set up, false if it is not supported
+*
+*/
+bool AsyncIO::open(int fileDescriptor, uint32_t queueDepth) {
+	close();
+#ifdef BOSON_IO_URING
+	io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	int ring = (int) syscall(__NR_io_uring_setup, queueDepth, &params);
+	if (ring < 0) return false;
+
+	// Map submission and completion queue rings
+	sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+	sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+	if (sqRing == MAP_FAILED) {
+		sqRing = nullptr;
+		::close(ring);
+		return false;
+	}
+	if (singleMap) cqRing = sqRing;
+	else {
+		cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+		if (cqRing == MAP_FAILED) {
+			cqRing = nullptr;
+			munmap(sqRing, sqRingSize);
+			sqRing = nullptr;
+			::close(ring);
+			return false;
+		}
+	}
+	sqEntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+	sqEntries = mmap(nullptr, sqEntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+	if (sqEntries == MAP_FAILED) {
+		sqEntries = nullptr;
+		if (cqRing != sqRing) munmap(cqRing, cqRingSize);
+		munmap(sqRing, sqRingSize);
+		sqRing = cqRing = nullptr;
+		::close(ring);
+		return false;
+	}
+
+	// Resolve ring fields
+	uint8_t* sq = (uint8_t*) sqRing;
+	uint8_t* cq = (uint8_t*) cqRing;
+	sqHead = (uint32_t*) (sq + params.sq_off.head);
+	sqTail = (uint32_t*) (sq + params.sq_off.tail);
+	sqMask = (uint32_t*) (sq + params.sq_off.ring_mask);
+	sqArray = (uint32_t*) (sq + params.sq_off.array);
+	cqHead = (uint32_t*) (cq + params.cq_off.head);
+	cqTail = (uint32_t*) (cq + params.cq_off.tail);
+	cqMask = (uint32_t*) (cq + params.cq_off.ring_mask);
+	cqEntries = cq + params.cq_off.cqes;
+
+	this->ringDescriptor = ring;
+	this->fileDescriptor = fileDescriptor;
+	this->queueDepth = params.sq_entries;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+/**
+* @brief Releases io_uring
+*/
+void AsyncIO::close() {
+#ifdef BOSON_IO_URING
+	if (ringDescriptor < 0) return;
+	munmap(sqEntries, sqEntriesSize);
+	if (cqRing != sqRing) munmap(cqRing, cqRingSize);
+	munmap(sqRing, sqRingSize);
+	::close(ringDescriptor);
+#endif
+	sqRing = cqRing = sqEntries = nullptr;
+	ringDescriptor = -1;
+	fileDescriptor = -1;
+	requests.clear();
+	buffers.clear();
+}
+
+
+/**
+* @brief Checks if io_uring is set up
+* @return true if requests can be submitted, false otherwise
+*/
+bool AsyncIO::isAvailable() {
+	return ringDescriptor >= 0;
+}
+
+
+/**
+*
+*  @brief Queues vectored read of consecutive file range
+*
+*  @param offset - file offset
+*  @param buffers - buffers filled in order
+*  @param count - buffers count
+*
+*/
+void AsyncIO::queueRead(uint64_t offset, const AsyncBuffer* buffers, size_t count) {
+	requests.push_back({ AsyncRequestType::ASYNC_READ, offset, this->buffers.size(), count });
+	this->buffers.insert(this->buffers.end(), buffers, buffers + count);
+}
+
+
+/**
+*
+*  @brief Queues vectored write of consecutive file range
+*
+*  @param offset - file offset
+*  @param buffers - buffers written in order
+*  @param count - buffers count
+*
+*/
+void AsyncIO::queueWrite(uint64_t offset, const AsyncBuffer* buffers, size_t count) {
+	requests.push_back({ AsyncRequestType::ASYNC_WRITE, offset, this->buffers.size(), count });
+	this->buffers.insert(this->buffers.end(), buffers, buffers + count);
+}
+
+
+/**
+*
+*  @brief Submits queued requests and waits for completion of all of them
+*
+*  @param results - bytes transferred or negative error code per request
+*  (in the order requests were queued)
+*
+*  @return number of requests completed without errors
+*
+*/
+size_t AsyncIO::submit(std::vector<int64_t>& results) {
+	results.assign(requests.size(), -1);
+	size_t completed = 0;
+	if (isAvailable()) {
+		for (size_t first = 0; first < requests.size(); first += queueDepth) {
+			size_t count = std::min(size_t(queueDepth), requests.size() - first);
+			completed += submitBatch(first, count, results);
+		}
+	}
+	requests.clear();
+	buffers.clear();
+	return completed;
+}
+
+
+/**
+*
+*  @brief Submits batch of requests with one system call and reaps completions
+*
+*  @param first - first request index
+*  @param count - requests count (not more than queue depth)
+*  @param results - per request results
+*
+*  @return number of requests completed without errors
+*
+*/
+size_t AsyncIO::submitBatch(size_t first, size_t count, std::vector<int64_t>& results) {
+#ifdef BOSON_IO_URING
+	static_assert(sizeof(AsyncBuffer) == sizeof(iovec), "AsyncBuffer must match iovec layout");
+
+	// Fill submission queue entries
+	io_uring_sqe* sqes = (io_uring_sqe*) sqEntries;
+	uint32_t tail = *sqTail;
+	for (size_t i = 0; i < count; i++) {
+		AsyncRequest& request = requests[first + i];
+		uint32_t index = tail & *sqMask;
+		io_uring_sqe* sqe = &sqes[index];
+		memset(sqe, 0, sizeof(io_uring_sqe));
+		sqe->opcode = (request.type == AsyncRequestType::ASYNC_READ) ? IORING_OP_READV : IORING_OP_WRITEV;
+		sqe->fd = fileDescriptor;
+		sqe->off = request.offset;
+		sqe->addr = (uint64_t) (uintptr_t) &buffers[request.firstBuffer];
+		sqe->len = (uint32_t) request.buffersCount;
+		sqe->user_data = first + i;
+		sqArray[index] = index;
+		tail++;
+	}
+	__atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+	// Submit and wait for all completions
+	size_t reaped = 0, completed = 0;
+	uint32_t toSubmit = (uint32_t) count;
+	while (reaped < count) {
+		int result = (int) syscall(__NR_io_uring_enter, ringDescriptor, toSubmit, uint32_t(count - reaped), IORING_ENTER_GETEVENTS, nullptr, 0);
+		submitCalls++;
+		if (result < 0) {
+			if (errno == EINTR) continue;
+			break;
+		}
+		toSubmit -= std::min(toSubmit, uint32_t(result));
+		// Reap completions
+		uint32_t head = *cqHead;
+		uint32_t cqTailValue = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+		io_uring_cqe* cqes = (io_uring_cqe*) cqEntries;
+		while (head != cqTailValue) {
+			io_uring_cqe* cqe = &cqes[head & *cqMask];
+			results[cqe->user_data] = cqe->res;
+			if (cqe->res >= 0) completed++;
+			reaped++;
+			head++;
+		}
+		__atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+	}
+	return completed;
+#else
+	return 0;
+#endif
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+*
+*  AsyncIO class header
+*
+*  AsyncIO submits group of file read/write requests to the kernel with one
+*  system call and waits for all of them to complete. On Linux it is based
+*  on io_uring (raw system calls, no liburing dependency). If io_uring is
+*  not supported by platform or kernel, AsyncIO is not available and
+*  callers use synchronous file I/O.
+*
+*  Requests are vectored: one request reads or writes consecutive file
+*  range from/to several buffers (cache pages are not continuous in memory).
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <atomic>
+
+namespace Boson {
+
+	//-------------------------------------------------------------------------
+	constexpr uint32_t ASYNC_QUEUE_DEPTH = 64;        // Submission queue entries
+	//-------------------------------------------------------------------------
+
+	typedef struct {                            // Request buffer
+		void*    data;                          // Buffer pointer
+		size_t   length;                        // Buffer length
+	} AsyncBuffer;
+
+	typedef enum {                              // Request type
+		ASYNC_READ = 0,                         // Vectored read
+		ASYNC_WRITE = 1                         // Vectored write
+	} AsyncRequestType;
+
+	typedef struct {                            // Queued request
+		AsyncRequestType type;                  // Read or write
+		uint64_t  offset;                       // File offset
+		size_t    firstBuffer;                  // First buffer index
+		size_t    buffersCount;                 // Buffers count
+	} AsyncRequest;
+
+
+	//-------------------------------------------------------------------------
+	// Group file I/O requests submission (io_uring on Linux)
+	//-------------------------------------------------------------------------
+	class AsyncIO {
+	public:
+		AsyncIO();
+		AsyncIO(const AsyncIO&) = delete;
+		void operator=(const AsyncIO&) = delete;
+		~AsyncIO();
+
+		bool   open(int fileDescriptor, uint32_t queueDepth = ASYNC_QUEUE_DEPTH);
+		void   close();
+		bool   isAvailable();
+
+		void   queueRead(uint64_t offset, const AsyncBuffer* buffers, size_t count);
+		void   queueWrite(uint64_t offset, const AsyncBuffer* buffers, size_t count);
+		size_t submit(std::vector<int64_t>& results);
+		uint64_t getSubmitCalls() { return submitCalls; }
+		void   resetStats() { submitCalls = 0; }
+
+	private:
+		size_t submitBatch(size_t first, size_t count, std::vector<int64_t>& results);
+
+		int       fileDescriptor;               // File descriptor
+		int       ringDescriptor;               // io_uring descriptor
+		uint32_t  queueDepth;                   // Submission queue entries
+		std::atomic<uint64_t> submitCalls;      // Kernel submit calls counter
+
+		void*     sqRing;                       // Submission queue ring memory
+		void*     cqRing;                       // Completion queue ring memory
+		void*     sqEntries;                    // Submission queue entries memory
+		size_t    sqRingSize;                   // Submission queue ring size
+		size_t    cqRingSize;                   // Completion queue ring size
+		size_t    sqEntriesSize;                // Submission queue entries size
+
+		uint32_t* sqHead;                       // Submission queue head
+		uint32_t* sqTail;                       // Submission queue tail
+		uint32_t* sqMask;                       // Submission queue index mask
+		uint32_t* sqArray;                      // Submission queue index array
+		uint32_t* cqHead;                       // Completion queue head
+		uint32_t* cqTail;                       // Completion queue tail
+		uint32_t* cqMask;                       // Completion queue index mask
+		void*     cqEntries;                    // Completion queue entries
+
+		std::vector<AsyncRequest> requests;     // Queued requests
+		std::vector<AsyncBuffer>  buffers;      // Buffers of queued requests
+	};
+
+}
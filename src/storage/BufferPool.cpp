@@ -0,0 +1,784 @@
+/******************************************************************************
+*
+*  BufferPool class implementation
+*
+*  BufferPool is memory pool of cache pages used by CachedFileIO. Every
+*  cached file may own private pool (default), or many files opened in
+*  one process may draw pages from one shared pool with one global memory
+*  cap and replacement policy.
+*
+*  Pages are keyed by (file id, file page number). Victim page chosen by
+*  replacement policy may belong to any attached file: it is persisted by
+*  its own file (file latch is taken after shard latch).
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+#include <algorithm>
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace Boson;
+
+
+/**
+*
+* @brief Constructor (pool memory is allocated by allocate or on open
+* of the cached file that owns private pool)
+*
+*/
+BufferPool::BufferPool() {
+	this->maxPagesCount = 0;
+	this->pageSize = PAGE_SIZE;
+	this->pageShift = 0;
+	while ((size_t(1) << pageShift) < pageSize) pageShift++;
+	this->shardsCount = 0;
+	this->cachePolicy = CachePolicyType::LRU;
+	this->poolPagesCount = 0;
+	this->hugePagesEnabled = false;
+	this->poolHugePages = false;
+	this->poolMemorySize = 0;
+	this->nextFileId = 0;
+	for (size_t i = 0; i < MAX_SHARDS; i++) {
+		shards[i].policy = nullptr;
+		shards[i].poolPagesCount = 0;
+		shards[i].maxPagesCount = 0;
+		shards[i].dirtyPages = 0;
+	}
+}
+
+
+/**
+*
+* @brief Destructor releases pool memory (files must be closed before)
+*
+*/
+BufferPool::~BufferPool() {
+	std::lock_guard<std::mutex> lock(resizeLatch);
+	this->releasePool();
+}
+
+
+/**
+*
+*  @brief Allocates pool memory: splits pool to shards and allocates pool
+*  segments. Allocated pool is released first (no files must be attached).
+*
+*  @param[in] cacheSize - pool memory size (bytes)
+*  @param[in] policy    - cache replacement policy (LRU, CLOCK, CLOCK_PRO, TWO_QUEUE)
+*
+*  @return true if pool is allocated, false if files are attached or
+*  failed to allocate memory
+*
+*/
+bool BufferPool::allocate(size_t cacheSize, CachePolicyType policy) {
+	std::lock_guard<std::mutex> lock(resizeLatch);
+	if (getFilesCount() > 0) return false;
+	this->releasePool();
+
+	// Check minimal cache size and calculate pages count
+	if (cacheSize < MINIMAL_CACHE) cacheSize = MINIMAL_CACHE;
+	size_t pagesCount = cacheSize >> pageShift;
+
+	// Calculate shards count keeping at least SHARD_PAGES pages per shard
+	this->cachePolicy = policy;
+	this->shardsCount = std::max(uint64_t(1), std::min(MAX_SHARDS, pagesCount / SHARD_PAGES));
+	for (size_t i = 0; i < shardsCount; i++) {
+		CacheShard& shard = shards[i];
+		shard.freePages.clear();
+		shard.poolPagesCount = 0;
+		shard.maxPagesCount = 0;
+		shard.dirtyMap.clear();
+		shard.dirtyPages = 0;
+		shard.policy = CachePolicy::create(cachePolicy);
+	}
+
+	// Pool segments shared between shards
+	try {
+		this->growPool(pagesCount);
+	} catch (std::bad_alloc& ba) {
+		std::cout << "Can't allocate cache of size " << cacheSize << ": " << ba.what() << std::endl;
+		this->releasePool();
+		return false;
+	}
+	return true;
+}
+
+
+/**
+*
+*  @brief Releases pool memory (no files must be attached)
+*  @return true if pool is released, false if files are attached
+*
+*/
+bool BufferPool::release() {
+	std::lock_guard<std::mutex> lock(resizeLatch);
+	if (getFilesCount() > 0) return false;
+	this->releasePool();
+	return true;
+}
+
+
+/**
+* @brief Checks if pool memory is allocated
+* @return true if pool is allocated, false otherwise
+*/
+bool BufferPool::isAllocated() {
+	return shardsCount > 0;
+}
+
+
+/**
+*
+*  @brief Get pool capacity in bytes
+*  @return pool capacity in bytes
+*
+*/
+size_t BufferPool::getCacheSize() {
+	return this->maxPagesCount * pageSize;
+}
+
+
+/**
+*
+*  @brief Resize pool at runtime keeping resident pages: growing adds pool
+*  segments, shrinking evicts the coldest pages of every shard down to the
+*  new capacity and releases pool segments. May be called concurrently with
+*  read/write operations of attached files (shards are locked one by one),
+*  pinned pages are not moved and segments holding them are kept.
+*  @param cacheSize - new cache size
+*  @return actual cache size in bytes or NOT_FOUND if failed to allocate
+*  not allocated pool (pool is kept if it fails to grow)
+*
+*/
+size_t BufferPool::setCacheSize(size_t cacheSize) {
+
+	// Allocate pool if it is not allocated yet
+	if (!isAllocated()) {
+		if (!allocate(cacheSize, cachePolicy)) return NOT_FOUND;
+		return getCacheSize();
+	}
+
+	// Check minimal cache size
+	if (cacheSize < MINIMAL_CACHE) cacheSize = MINIMAL_CACHE;
+
+	// Calculate pages count
+	size_t pagesCount = cacheSize >> pageShift;
+
+	std::lock_guard<std::mutex> lock(resizeLatch);
+	try {
+		// Shards count is kept while pool is allocated: at least two pages per shard
+		pagesCount = std::max(pagesCount, size_t(shardsCount * 2));
+		if (pagesCount > maxPagesCount) this->growPool(pagesCount);
+		else if (pagesCount < maxPagesCount) this->shrinkPool(pagesCount);
+	} catch (std::bad_alloc& ba) {
+		// keep current cache if it failed to grow
+		std::cout << "Can't allocate cache of size " << cacheSize << ": " << ba.what() << std::endl;
+	}
+
+	// Return cache size in bytes
+	return this->maxPagesCount * pageSize;
+}
+
+
+/**
+*
+*  @brief Get page size in bytes
+*  @return page size in bytes
+*
+*/
+size_t BufferPool::getPageSize() {
+	return this->pageSize;
+}
+
+
+/**
+*
+*  @brief Sets page size of pool pages: power of 2 from MIN_PAGE_SIZE to
+*  MAX_PAGE_SIZE (pool must not be allocated)
+*  @param newPageSize - new page size in bytes
+*  @return true if page size is set, false if page size is invalid or
+*  pool is allocated for another page size
+*
+*/
+bool BufferPool::setPageSize(size_t newPageSize) {
+	if (!isValidPageSize(newPageSize)) return false;
+	if (newPageSize == this->pageSize) return true;
+	if (isAllocated()) return false;
+	this->pageSize = newPageSize;
+	this->pageShift = 0;
+	while ((size_t(1) << pageShift) < newPageSize) pageShift++;
+	return true;
+}
+
+
+/**
+*
+*  @brief Enables or disables huge pages backed pool
+*  (takes effect on next pool allocation or growth)
+*
+*  @param enabled - true to back pool with 2Mb huge pages
+*
+*/
+void BufferPool::setHugePages(bool enabled) {
+	this->hugePagesEnabled = enabled;
+}
+
+
+/**
+* @brief Checks if pool is mapped to explicit huge pages
+* @return true if pool is backed by huge pages, false otherwise
+*/
+bool BufferPool::isHugePages() {
+	return poolHugePages;
+}
+
+
+/**
+* @brief Returns memory allocated for pool pages
+* @return pool memory size in bytes
+*/
+size_t BufferPool::getMemorySize() {
+	return poolMemorySize;
+}
+
+
+/**
+* @brief Returns count of files drawing pages from the pool
+* @return attached files count
+*/
+size_t BufferPool::getFilesCount() {
+	std::lock_guard<std::mutex> lock(filesLatch);
+	return files.size();
+}
+
+
+/**
+*
+* @brief Attaches cached file to the pool and assigns file id (ids of
+* recently detached files are not reused, so their non-resident history
+* pages of replacement policies do not match new file pages)
+* @param file - cached file
+* @return file id of page keys
+*
+*/
+uint32_t BufferPool::attach(CachedFileIO* file) {
+	std::lock_guard<std::mutex> lock(filesLatch);
+	while (files.count(nextFileId) > 0) nextFileId = (nextFileId + 1) & MAX_FILE_ID;
+	uint32_t fileId = nextFileId;
+	nextFileId = (nextFileId + 1) & MAX_FILE_ID;
+	files[fileId] = file;
+	return fileId;
+}
+
+
+/**
+*
+* @brief Detaches cached file from the pool: drops pages of the file from
+* shards (changes of the file must be persisted by caller) and frees file id
+* @param fileId - file id
+*
+*/
+void BufferPool::detach(uint32_t fileId) {
+	dropPages(fileId, 0);
+	std::lock_guard<std::mutex> lock(filesLatch);
+	files.erase(fileId);
+}
+
+
+/**
+*
+* @brief Drops pages of the file starting from the page number from shards
+* without persisting them (pages of truncated or detached file)
+* @param fileId - file id
+* @param firstPageNo - first dropped file page
+*
+*/
+void BufferPool::dropPages(uint32_t fileId, size_t firstPageNo) {
+	for (size_t i = 0; i < shardsCount; i++) {
+		CacheShard& shard = shards[i];
+		std::lock_guard<std::mutex> lock(shard.latch);
+		for (auto it = shard.cacheMap.begin(); it != shard.cacheMap.end();) {
+			CachePage* page = it->second;
+			if (page->fileId != fileId || page->filePageNo < firstPageNo) {
+				it++;
+				continue;
+			}
+			page->file->markClean(shard, page);
+			shard.policy->erase(page);
+			page->filePageNo = NOT_FOUND;
+			page->availableDataLength = 0;
+			page->file = nullptr;
+			page->pinCount = 0;
+			page->prefetched = false;
+			shard.freePages.push_back(page);
+			it = shard.cacheMap.erase(it);
+		}
+	}
+}
+
+
+/**
+*
+* @brief Grows cache capacity: adds pool segments if pool has less pages
+* than requested and raises capacity of shards (resident pages are kept)
+* @param pagesCount - new cache capacity (pages)
+*
+*/
+void BufferPool::growPool(size_t pagesCount) {
+
+	// Allocate new segments before they are shared between shards
+	std::vector<PoolSegment> newSegments;
+	size_t newPoolPagesCount = poolPagesCount;
+	size_t segmentPages = POOL_SEGMENT_SIZE >> pageShift;
+	try {
+		while (newPoolPagesCount < pagesCount) {
+			PoolSegment segment = {};
+			segment.pagesCount = std::min(segmentPages, pagesCount - newPoolPagesCount);
+			segment.firstShard = newPoolPagesCount % shardsCount;
+			segment.pages = new CachePage[segment.pagesCount];
+			newSegments.push_back(segment);
+			allocatePoolMemory(newSegments.back(), segment.pagesCount * pageSize, hugePagesEnabled);
+			newPoolPagesCount += segment.pagesCount;
+		}
+	} catch (std::bad_alloc&) {
+		for (PoolSegment& segment : newSegments) releasePoolMemory(segment);
+		throw;
+	}
+
+	// Mark all pages as free, so replacement policies can sweep them
+	for (PoolSegment& segment : newSegments) {
+		for (size_t i = 0; i < segment.pagesCount; i++) {
+			CachePage& page = segment.pages[i];
+			page.filePageNo = NOT_FOUND;
+			page.state = PageState::CLEAN;
+			page.dirtySectors = 0;
+			page.availableDataLength = 0;
+			page.data = &segment.data[i * pageSize];
+			page.file = nullptr;
+			page.fileId = 0;
+			page.referenced = false;
+			page.hot = false;
+			page.inTest = false;
+			page.pinCount = 0;
+			page.prefetched = false;
+		}
+	}
+
+	// Share new pages between shards and raise shards capacity
+	for (size_t i = 0; i < shardsCount; i++) {
+		std::vector<CachePage*> pages;
+		for (PoolSegment& segment : newSegments) getSegmentPages(segment, i, pages);
+		CacheShard& shard = shards[i];
+		std::lock_guard<std::mutex> lock(shard.latch);
+		shard.freePages.insert(shard.freePages.end(), pages.begin(), pages.end());
+		shard.poolPagesCount += pages.size();
+		shard.policy->addPages(pages.data(), pages.size());
+		shard.maxPagesCount = getShardCapacity(pagesCount, i);
+		shard.policy->setCapacity(shard.maxPagesCount);
+		shard.cacheMap.reserve(shard.maxPagesCount);
+	}
+
+	segments.insert(segments.end(), newSegments.begin(), newSegments.end());
+	this->poolPagesCount = newPoolPagesCount;
+	this->maxPagesCount = pagesCount;
+	updatePoolStats();
+}
+
+
+/**
+*
+* @brief Shrinks cache capacity keeping the hottest pages: every shard evicts
+* pages chosen by replacement policy down to its new capacity, resident pages
+* of released tail segments are moved to free pages of kept segments and
+* memory of released segments is returned to OS. Segment with pinned page
+* is kept with all segments before it.
+* @param pagesCount - new cache capacity (pages)
+*
+*/
+void BufferPool::shrinkPool(size_t pagesCount) {
+
+	// Find tail segments which are not needed for new capacity
+	size_t keptSegments = segments.size();
+	size_t keptPagesCount = poolPagesCount;
+	while (keptSegments > 1 && keptPagesCount - segments[keptSegments - 1].pagesCount >= pagesCount) {
+		keptSegments--;
+		keptPagesCount -= segments[keptSegments].pagesCount;
+	}
+	auto isReleased = [this](CachePage* page, size_t firstSegment) {
+		for (size_t s = firstSegment; s < segments.size(); s++) {
+			PoolSegment& segment = segments[s];
+			if (page >= segment.pages && page < segment.pages + segment.pagesCount) return true;
+		}
+		return false;
+	};
+
+	std::vector<bool> busySegments(segments.size(), false);
+	std::vector<CachePage*> removedPages[MAX_SHARDS];
+
+	for (size_t i = 0; i < shardsCount; i++) {
+		CacheShard& shard = shards[i];
+		std::lock_guard<std::mutex> lock(shard.latch);
+
+		// Lower shard capacity and evict the coldest pages above it
+		shard.maxPagesCount = getShardCapacity(pagesCount, i);
+		shard.policy->setCapacity(shard.maxPagesCount);
+		while (shard.cacheMap.size() > shard.maxPagesCount) {
+			CachePage* victim = shard.policy->evict();
+			if (victim == nullptr) break;
+			clearCachePage(shard, victim);
+			shard.freePages.push_back(victim);
+		}
+
+		// Free pages of released segments leave the shard
+		std::vector<CachePage*> freePages;
+		for (CachePage* page : shard.freePages) {
+			if (isReleased(page, keptSegments)) removedPages[i].push_back(page);
+			else freePages.push_back(page);
+		}
+
+		// Move resident pages of released segments to free pages of kept segments
+		for (size_t s = keptSegments; s < segments.size(); s++) {
+			std::vector<CachePage*> segmentPages;
+			getSegmentPages(segments[s], i, segmentPages);
+			for (CachePage* page : segmentPages) {
+				if (page->filePageNo == NOT_FOUND) continue;
+				if (page->pinCount > 0) {
+					busySegments[s] = true;
+					continue;
+				}
+				// No free pages left in kept segments: evict the coldest page
+				while (freePages.empty() && page->filePageNo != NOT_FOUND) {
+					CachePage* victim = shard.policy->evict();
+					if (victim == nullptr) break;
+					clearCachePage(shard, victim);
+					if (isReleased(victim, keptSegments)) removedPages[i].push_back(victim);
+					else freePages.push_back(victim);
+				}
+				if (page->filePageNo == NOT_FOUND) continue;
+				if (freePages.empty()) {
+					busySegments[s] = true;
+					continue;
+				}
+				movePage(shard, page, freePages.back());
+				freePages.pop_back();
+				removedPages[i].push_back(page);
+			}
+		}
+
+		shard.freePages = freePages;
+		shard.poolPagesCount -= removedPages[i].size();
+		shard.policy->removePages(removedPages[i].data(), removedPages[i].size());
+	}
+	this->maxPagesCount = pagesCount;
+
+	// Segments with pages that can't be moved are kept with segments before them
+	size_t releasedSegments = keptSegments;
+	for (size_t s = keptSegments; s < segments.size(); s++) {
+		if (busySegments[s]) releasedSegments = s + 1;
+	}
+	if (releasedSegments > keptSegments) {
+		// Return free pages of kept segments to shards
+		for (size_t i = 0; i < shardsCount; i++) {
+			std::vector<CachePage*> pages;
+			for (CachePage* page : removedPages[i]) {
+				if (!isReleased(page, releasedSegments)) pages.push_back(page);
+			}
+			CacheShard& shard = shards[i];
+			std::lock_guard<std::mutex> lock(shard.latch);
+			shard.freePages.insert(shard.freePages.end(), pages.begin(), pages.end());
+			shard.poolPagesCount += pages.size();
+			shard.policy->addPages(pages.data(), pages.size());
+		}
+	}
+
+	// Release memory of segments, their pages are not used by shards anymore
+	for (size_t s = releasedSegments; s < segments.size(); s++) {
+		this->poolPagesCount -= segments[s].pagesCount;
+		releasePoolMemory(segments[s]);
+	}
+	segments.resize(releasedSegments);
+	updatePoolStats();
+}
+
+
+/**
+* @brief Returns capacity of the shard: cache capacity split between shards
+* @param pagesCount - cache capacity (pages)
+* @param shardIndex - shard index
+* @return shard capacity (pages)
+*/
+uint64_t BufferPool::getShardCapacity(size_t pagesCount, size_t shardIndex) {
+	return pagesCount / shardsCount + (shardIndex < pagesCount % shardsCount ? 1 : 0);
+}
+
+
+/**
+* @brief Collects pages of the segment that belong to the shard
+* (pages of segments are shared between shards round robin)
+* @param segment - pool segment
+* @param shardIndex - shard index
+* @param pages - vector where pages are added
+*/
+void BufferPool::getSegmentPages(const PoolSegment& segment, size_t shardIndex, std::vector<CachePage*>& pages) {
+	size_t first = (shardIndex + shardsCount - segment.firstShard) % shardsCount;
+	for (size_t i = first; i < segment.pagesCount; i += shardsCount) pages.push_back(&segment.pages[i]);
+}
+
+
+/**
+* @brief Releases memory pool (resize latch held by caller)
+*/
+void BufferPool::releasePool() {
+	this->maxPagesCount = 0;
+	for (size_t i = 0; i < shardsCount; i++) {
+		delete shards[i].policy;
+		shards[i].policy = nullptr;
+		shards[i].cacheMap.clear();
+		shards[i].dirtyMap.clear();
+		shards[i].freePages.clear();
+		shards[i].poolPagesCount = 0;
+		shards[i].maxPagesCount = 0;
+		shards[i].dirtyPages = 0;
+	}
+	this->shardsCount = 0;
+	for (PoolSegment& segment : segments) releasePoolMemory(segment);
+	segments.clear();
+	this->poolPagesCount = 0;
+	updatePoolStats();
+}
+
+
+/**
+*
+* @brief Allocates pool segment memory aligned for direct I/O. If huge pages
+* are requested, tries explicit 2Mb huge pages first, then asks OS to back
+* 2Mb aligned memory with transparent huge pages.
+*
+* @param segment - pool segment to allocate memory for
+* @param bytes - memory size
+* @param hugePages - try to back memory with huge pages
+* (throws std::bad_alloc on failure)
+*
+*/
+void BufferPool::allocatePoolMemory(PoolSegment& segment, size_t bytes, bool hugePages) {
+	void* memory = nullptr;
+	size_t alignment = IO_ALIGNMENT;
+	segment.hugePages = false;
+#ifdef _WIN32
+	memory = _aligned_malloc(bytes, alignment);
+#else
+	if (hugePages) {
+#ifdef MAP_HUGETLB
+		size_t hugeBytes = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+		memory = mmap(nullptr, hugeBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (memory != MAP_FAILED) {
+			segment.data = (uint8_t*) memory;
+			segment.hugePages = true;
+			segment.memorySize = hugeBytes;
+			return;
+		}
+		memory = nullptr;
+#endif
+		alignment = HUGE_PAGE_SIZE;
+	}
+	if (posix_memalign(&memory, alignment, bytes) != 0) memory = nullptr;
+#ifdef MADV_HUGEPAGE
+	if (memory != nullptr && hugePages) madvise(memory, bytes, MADV_HUGEPAGE);
+#endif
+#endif
+	if (memory == nullptr) throw std::bad_alloc();
+	segment.data = (uint8_t*) memory;
+	segment.memorySize = bytes;
+}
+
+
+/**
+* @brief Releases pages info and memory of pool segment
+* @param segment - pool segment
+*/
+void BufferPool::releasePoolMemory(PoolSegment& segment) {
+	delete[] segment.pages;
+	segment.pages = nullptr;
+	if (segment.data != nullptr) {
+#ifdef _WIN32
+		_aligned_free(segment.data);
+#else
+		if (segment.hugePages) munmap(segment.data, segment.memorySize);
+		else free(segment.data);
+#endif
+	}
+	segment.data = nullptr;
+	segment.pagesCount = 0;
+	segment.hugePages = false;
+	segment.memorySize = 0;
+}
+
+
+/**
+* @brief Updates pool memory size and huge pages flag when pool is changed
+*/
+void BufferPool::updatePoolStats() {
+	size_t memorySize = 0;
+	bool hugePages = !segments.empty();
+	for (PoolSegment& segment : segments) {
+		memorySize += segment.memorySize;
+		hugePages = hugePages && segment.hugePages;
+	}
+	this->poolMemorySize = memorySize;
+	this->poolHugePages = hugePages;
+}
+
+
+/**
+* @brief Returns shard index of the page key: pages of one file are spread
+* round robin and first pages of different files fall to different shards
+*/
+size_t BufferPool::getShardIndex(uint64_t pageKey) {
+	return (pageKey + (pageKey >> FILE_PAGE_BITS)) % shardsCount;
+}
+
+
+/**
+* @brief Returns cache shard of the page key
+*/
+CacheShard& BufferPool::getShard(uint64_t pageKey) {
+	return shards[getShardIndex(pageKey)];
+}
+
+
+/**
+* @brief Allocates cache page from free pool pages of the shard
+*/
+CachePage* BufferPool::allocatePage(CacheShard& shard) {
+
+	if (shard.freePages.empty()) return nullptr;
+
+	// Take free page of the shard
+	CachePage* newPage = shard.freePages.back();
+	shard.freePages.pop_back();
+	// Clear cache page info fields
+	newPage->filePageNo = NOT_FOUND;
+	newPage->state = PageState::CLEAN;
+	newPage->dirtySectors = 0;
+	newPage->availableDataLength = 0;
+	newPage->file = nullptr;
+	newPage->referenced = false;
+	newPage->hot = false;
+	newPage->inTest = false;
+	newPage->pinCount = 0;
+	newPage->prefetched = false;
+
+	return newPage;
+}
+
+
+/**
+*
+* @brief Returns free page: allocates new or evicts page chosen by replacement
+* policy (victim may belong to any attached file)
+* @return new allocated or evicted CachePage pointer or nullptr if all pages are pinned
+*
+*/
+CachePage* BufferPool::getFreeCachePage(CacheShard& shard) {
+	// pages in use (resident or being loaded) are below shard capacity
+	if (!shard.freePages.empty() && shard.poolPagesCount - shard.freePages.size() < shard.maxPagesCount) {
+		return allocatePage(shard);
+	} else {
+		// get victim page chosen by replacement policy (pinned pages are skipped)
+		CachePage* freePage = shard.policy->evict();
+		if (freePage == nullptr) return nullptr;
+		// clear page state
+		clearCachePage(shard, freePage);
+		// return page reference
+		return freePage;
+	}
+}
+
+
+/**
+*
+*  @brief Clears cache page state, persists it by its file if changed
+*  and removes from hashmap (shard latch held by caller)
+*
+*  @param shard - cache shard of the page
+*  @param pageInfo - cache page to clear
+*  @return true - if page cleared, false - if can't persist page to storage
+*
+*/
+bool BufferPool::clearCachePage(CacheShard& shard, CachePage* pageInfo) {
+
+	CachedFileIO* file = pageInfo->file;
+	bool persisted = true;
+
+	// if cache page has been rewritten persist page to storage device
+	if (pageInfo->state == PageState::DIRTY) {
+		file->dirtyEvictions++;
+		uint64_t startTime = getTimeNs();
+		persisted = file->persistCachePage(pageInfo);
+		file->evictionLatency.record(getTimeNs() - startTime);
+		// page is reused anyway, so it must leave dirty pages map
+		if (!persisted) file->markClean(shard, pageInfo);
+	}
+
+	// Prefetched page has never been requested
+	if (pageInfo->prefetched) {
+		pageInfo->prefetched = false;
+		file->readAheadWasted++;
+	}
+
+	// Remove from index hashmap
+	shard.cacheMap.erase(getPageKey(pageInfo->fileId, pageInfo->filePageNo));
+
+	// Clear cache page info fields
+	pageInfo->filePageNo = NOT_FOUND;
+	pageInfo->availableDataLength = 0;
+	pageInfo->file = nullptr;
+
+	// Cache page freed
+	return persisted;
+}
+
+
+/**
+*
+*  @brief Moves resident page to free pool page of the same shard: copies
+*  page data and state, replacement policy and maps point to the new page
+*  (shard latch held by caller)
+*
+*  @param shard - cache shard of the page
+*  @param from - resident cache page (not pinned)
+*  @param to - free cache page
+*
+*/
+void BufferPool::movePage(CacheShard& shard, CachePage* from, CachePage* to) {
+	memcpy(to->data, from->data, pageSize);
+	to->filePageNo = from->filePageNo;
+	to->file = from->file;
+	to->fileId = from->fileId;
+	to->state = from->state;
+	to->dirtySectors = from->dirtySectors;
+	to->availableDataLength = from->availableDataLength;
+	to->prefetched = from->prefetched;
+	to->pinCount = 0;
+	shard.policy->movePage(from, to);
+	uint64_t pageKey = getPageKey(to->fileId, to->filePageNo);
+	shard.cacheMap[pageKey] = to;
+	if (to->state == PageState::DIRTY) shard.dirtyMap[pageKey] = to;
+	from->filePageNo = NOT_FOUND;
+	from->file = nullptr;
+	from->state = PageState::CLEAN;
+	from->dirtySectors = 0;
+	from->availableDataLength = 0;
+	from->prefetched = false;
+}
@@ -0,0 +1,182 @@
+/******************************************************************************
+*
+*  BufferPool class header
+*
+*  BufferPool is memory pool of cache pages used by CachedFileIO. Every
+*  cached file may own private pool (default), or many files opened in
+*  one process may draw pages from one shared pool. Shared pool has one
+*  global memory cap and replacement policy, so pages of hot databases
+*  take place of idle pages of cold ones instead of memory being split
+*  between files statically.
+*
+*  Pages are keyed by (file id, file page number): file id assigned by the
+*  pool on attach is kept in upper bits of the page key. Pool is split into
+*  shards by page key, every shard has its own hashmap, replacement policy
+*  and latch.
+*
+*  Pool consists of segments (4Mb), so pool is resized online keeping
+*  resident pages: growing adds segments, shrinking evicts the coldest
+*  pages down to the new capacity, moves pages of the released segments
+*  to free pages and returns memory of these segments to OS.
+*
+*  Files must be closed before shared pool is released or destroyed.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <map>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+#include "FileIO.h"
+#include "CachePolicy.h"
+
+namespace Boson {
+
+	//-------------------------------------------------------------------------
+	constexpr uint64_t MINIMAL_CACHE  = 256 * 1024;   // 256Kb minimal cache
+	constexpr uint64_t DEFAULT_CACHE  = 1*1024*1024;  // 1Mb default cache
+	constexpr uint64_t MAX_SHARDS     = 16;           // Maximum cache shards count
+	constexpr uint64_t SHARD_PAGES    = 8;            // Minimal pages per shard
+	constexpr uint64_t IO_ALIGNMENT   = 4096;         // Direct I/O buffers alignment
+	constexpr uint64_t HUGE_PAGE_SIZE = 2*1024*1024;  // Huge page size of pages pool
+	constexpr uint64_t POOL_SEGMENT_SIZE = 4*1024*1024; // Pages pool segment size (4Mb)
+	constexpr uint64_t FILE_PAGE_BITS = 40;           // Page key bits of file page number
+	constexpr uint64_t MAX_FILE_PAGE  = (1ull << FILE_PAGE_BITS) - 1;        // Maximal file page number
+	constexpr uint64_t MAX_FILE_ID    = (1ull << (64 - FILE_PAGE_BITS)) - 1; // Maximal file id
+	//-------------------------------------------------------------------------
+
+	typedef enum {                              // Cache Page State
+		CLEAN = 0,                              // Page has not been changed
+		DIRTY = 1                               // Cache page is rewritten
+	} PageState;
+
+	class alignas(64) CachePage {               // Align to CPU cache line
+	public:
+		uint64_t  filePageNo;                   // Page number in file
+		uint64_t  availableDataLength;          // Available amount of data
+		uint8_t*  data;                         // Pointer to data (payload)
+		CacheLinkedList::iterator it;           // Cache list node iterator (LRU, 2Q)
+		uint64_t  dirtySectors;                 // Dirty sectors bitmask (up to 64 sectors)
+		CachedFileIO* file;                     // Cached file of the page
+		PageState state;                        // Current page state
+		uint32_t  pinCount;                     // Pins count (not evicted if pinned)
+		bool      referenced;                   // Reference bit (CLOCK)
+		bool      hot;                          // Hot page flag (CLOCK-Pro, 2Q)
+		bool      inTest;                       // Test period flag (CLOCK-Pro, 2Q)
+		bool      prefetched;                   // Loaded by read-ahead, not requested yet
+		uint32_t  fileId;                       // Pool file id of the page
+	};
+
+	typedef struct {                            // Pages pool segment
+		CachePage*  pages;                      // Pages info
+		uint8_t*    data;                       // Pages data (aligned)
+		uint64_t    pagesCount;                 // Pages count
+		uint64_t    firstShard;                 // Shard of the first page (next pages round robin)
+		size_t      memorySize;                 // Data memory size in bytes
+		bool        hugePages;                  // Data memory is mapped to huge pages
+	} PoolSegment;
+
+	//-------------------------------------------------------------------------
+
+	typedef                                     // Hashmap of cached pages
+		std::unordered_map<size_t, CachePage*>  // Page key -> CachePage*
+		CachedPagesMap;
+
+	typedef                                     // Ordered map of dirty pages
+		std::map<size_t, CachePage*>            // Page key -> CachePage*
+		DirtyPagesMap;
+
+	class alignas(64) CacheShard {              // Align to CPU cache line
+	public:
+		std::mutex      latch;                  // Shard latch
+		CachedPagesMap  cacheMap;               // Cached pages map
+		DirtyPagesMap   dirtyMap;               // Dirty pages ordered by page key
+		CachePolicy*    policy;                 // Cache replacement policy
+		std::vector<CachePage*> freePages;      // Free pool pages of the shard
+		uint64_t        poolPagesCount;         // Pool pages of the shard (free and used)
+		std::atomic<uint64_t> maxPagesCount;    // Shard capacity (pages, read without latch)
+		std::atomic<uint64_t> dirtyPages;       // Dirty pages count (read without latch)
+	};
+
+	//-------------------------------------------------------------------------
+
+	/**
+	* @brief Returns pool page key of the file page
+	* @param fileId - pool file id
+	* @param filePageNo - page number in file
+	*/
+	inline uint64_t getPageKey(uint64_t fileId, uint64_t filePageNo) {
+		return (fileId << FILE_PAGE_BITS) | filePageNo;
+	}
+
+
+	//-------------------------------------------------------------------------
+	// Cache pages memory pool (private or shared between cached files)
+	//-------------------------------------------------------------------------
+	class BufferPool {
+		friend class CachedFileIO;
+	public:
+		BufferPool();
+		BufferPool(const BufferPool&) = delete;
+		void operator=(const BufferPool&) = delete;
+		~BufferPool();
+
+		bool   allocate(size_t cacheSize = DEFAULT_CACHE, CachePolicyType policy = CachePolicyType::LRU);
+		bool   release();
+		bool   isAllocated();
+		size_t getCacheSize();
+		size_t setCacheSize(size_t cacheSize);
+		size_t getPageSize();
+		bool   setPageSize(size_t pageSize);
+		void   setHugePages(bool enabled);
+		bool   isHugePages();
+		size_t getMemorySize();
+		size_t getFilesCount();
+
+		static void allocatePoolMemory(PoolSegment& segment, size_t bytes, bool hugePages);
+		static void releasePoolMemory(PoolSegment& segment);
+
+	private:
+
+		uint32_t   attach(CachedFileIO* file);
+		void       detach(uint32_t fileId);
+		void       dropPages(uint32_t fileId, size_t firstPageNo);
+		void       growPool(size_t pagesCount);
+		void       shrinkPool(size_t pagesCount);
+		uint64_t   getShardCapacity(size_t pagesCount, size_t shardIndex);
+		void       getSegmentPages(const PoolSegment& segment, size_t shardIndex, std::vector<CachePage*>& pages);
+		void       releasePool();
+		void       updatePoolStats();
+		size_t     getShardIndex(uint64_t pageKey);
+		CacheShard& getShard(uint64_t pageKey);
+		CachePage* allocatePage(CacheShard& shard);
+		CachePage* getFreeCachePage(CacheShard& shard);
+		bool       clearCachePage(CacheShard& shard, CachePage* pageInfo);
+		void       movePage(CacheShard& shard, CachePage* from, CachePage* to);
+
+		std::atomic<uint64_t> maxPagesCount;     // Maximum cache capacity (pages)
+		size_t          pageSize;                // Page size (power of 2)
+		size_t          pageShift;               // log2(pageSize)
+		uint64_t        shardsCount;             // Cache shards count
+		CachePolicyType cachePolicy;             // Cache replacement policy type
+		CacheShard      shards[MAX_SHARDS];      // Cache shards
+		std::vector<PoolSegment> segments;       // Cache pages memory pool segments
+		uint64_t        poolPagesCount;          // Pages count of all pool segments
+		std::mutex      resizeLatch;             // Pool resize latch
+		bool            hugePagesEnabled;        // Huge pages backed pool is enabled
+		bool            poolHugePages;           // Pool is mapped to huge pages
+		std::atomic<size_t> poolMemorySize;      // Pool memory size in bytes
+
+		std::unordered_map<uint32_t, CachedFileIO*> files; // Attached files by file id
+		uint32_t        nextFileId;              // Next file id to assign
+		std::mutex      filesLatch;              // Attached files latch
+	};
+
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+*
+*  Cache replacement policy factory
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+using namespace Boson;
+
+
+/**
+*
+*  @brief Creates cache replacement policy of requested type. Pool pages
+*  and capacity of the shard are passed by addPages() and setCapacity()
+*
+*  @param type - replacement policy type
+*
+*  @return new replacement policy object
+*
+*/
+CachePolicy* CachePolicy::create(CachePolicyType type) {
+	switch (type) {
+	case CachePolicyType::CLOCK:
+		return new ClockPolicy();
+	case CachePolicyType::CLOCK_PRO:
+		return new ClockProPolicy();
+	case CachePolicyType::TWO_QUEUE:
+		return new TwoQueuePolicy();
+	default:
+		return new LRUPolicy();
+	}
+}
+
+
+
+/**
+*
+*  @brief Finds least recent page of the list that is not pinned
+*
+*  @param list - pages list (most recent page in front)
+*
+*  @return page that is closest to the back of the list and not pinned
+*  or nullptr if all pages are pinned
+*
+*/
+CachePage* CachePolicy::lastUnpinned(CacheLinkedList& list) {
+	for (auto it = list.rbegin(); it != list.rend(); it++) {
+		if ((*it)->pinCount == 0) return *it;
+	}
+	return nullptr;
+}
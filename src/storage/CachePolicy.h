@@ -0,0 +1,178 @@
+/******************************************************************************
+*
+*  Cache replacement policies header
+*
+*  Cache replacement policy decides which cached page to evict when cache
+*  shard is full. Policies work over the pages of the shard memory pool
+*  (pool pages and capacity of the shard change when cache is resized):
+*    - LRU       - least recently used page (linked list, hit moves page)
+*    - CLOCK     - second chance, hit only sets the reference bit
+*    - CLOCK_PRO - CLOCK with hot/cold pages and non-resident test pages,
+*                  adapts cold pages target to the workload reuse distance
+*    - TWO_QUEUE - 2Q: new pages wait in probationary FIFO queue and only
+*                  pages requested again after eviction enter main LRU
+*
+*  Callers pass access hint: pages read by sequential scan are not promoted
+*  and are evicted first, so full traversals do not flush hot pages.
+*  Pinned pages are never chosen as victims. Non-resident pages remembered
+*  by CLOCK-Pro and 2Q are identified by pool page key (file id, page No.).
+*  Policies list resident pages from the hottest to the coldest, so cache
+*  warm-up manifest keeps pages in recency order.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <vector>
+#include <unordered_map>
+
+namespace Boson {
+
+	class CachePage;
+
+	typedef                                     // Double linked list
+		std::list<CachePage*>                   // of cached pages pointers
+		CacheLinkedList;
+
+	typedef enum {                              // Cache replacement policy type
+		LRU = 0,                                // Least recently used
+		CLOCK = 1,                              // Second chance
+		CLOCK_PRO = 2,                          // Adaptive CLOCK-Pro
+		TWO_QUEUE = 3                           // Scan resistant 2Q
+	} CachePolicyType;
+
+	typedef enum {                              // Page access hint
+		NORMAL = 0,                             // Point (random) access
+		SEQUENTIAL = 1                          // Sequential scan access
+	} AccessHint;
+
+
+	//-------------------------------------------------------------------------
+	// Cache replacement policy interface (shard latch held by caller)
+	//-------------------------------------------------------------------------
+	class CachePolicy {
+	public:
+		virtual ~CachePolicy() {}
+		virtual void       insert(CachePage* page, AccessHint hint) = 0;
+		virtual void       access(CachePage* page, AccessHint hint) = 0;
+		virtual CachePage* evict() = 0;
+		virtual void       clear() = 0;
+		virtual void       addPages(CachePage** pages, uint64_t count) = 0;
+		virtual void       removePages(CachePage** pages, uint64_t count) = 0;
+		virtual void       movePage(CachePage* from, CachePage* to) = 0;
+		virtual void       setCapacity(uint64_t pagesCount) = 0;
+		virtual void       erase(CachePage* page) = 0;
+		virtual void       getResidentPages(std::vector<CachePage*>& resident) = 0;
+		static CachePolicy* create(CachePolicyType type);
+	protected:
+		static CachePage*  lastUnpinned(CacheLinkedList& list);
+	};
+
+
+	//-------------------------------------------------------------------------
+	// Least recently used policy
+	//-------------------------------------------------------------------------
+	class LRUPolicy : public CachePolicy {
+	public:
+		void       insert(CachePage* page, AccessHint hint);
+		void       access(CachePage* page, AccessHint hint);
+		CachePage* evict();
+		void       clear();
+		void       addPages(CachePage** pages, uint64_t count);
+		void       removePages(CachePage** pages, uint64_t count);
+		void       movePage(CachePage* from, CachePage* to);
+		void       setCapacity(uint64_t pagesCount);
+		void       erase(CachePage* page);
+		void       getResidentPages(std::vector<CachePage*>& resident);
+	private:
+		CacheLinkedList cacheList;              // Cached pages double linked list
+	};
+
+
+	//-------------------------------------------------------------------------
+	// CLOCK (second chance) policy
+	//-------------------------------------------------------------------------
+	class ClockPolicy : public CachePolicy {
+	public:
+		ClockPolicy();
+		void       insert(CachePage* page, AccessHint hint);
+		void       access(CachePage* page, AccessHint hint);
+		CachePage* evict();
+		void       clear();
+		void       addPages(CachePage** pages, uint64_t count);
+		void       removePages(CachePage** pages, uint64_t count);
+		void       movePage(CachePage* from, CachePage* to);
+		void       setCapacity(uint64_t pagesCount);
+		void       erase(CachePage* page);
+		void       getResidentPages(std::vector<CachePage*>& resident);
+	private:
+		std::vector<CachePage*> pages;          // Pages of shard memory pool (clock)
+		uint64_t   hand;                        // Clock hand position
+	};
+
+
+	//-------------------------------------------------------------------------
+	// CLOCK-Pro policy
+	//-------------------------------------------------------------------------
+	class ClockProPolicy : public CachePolicy {
+	public:
+		ClockProPolicy();
+		void       insert(CachePage* page, AccessHint hint);
+		void       access(CachePage* page, AccessHint hint);
+		CachePage* evict();
+		void       clear();
+		void       addPages(CachePage** pages, uint64_t count);
+		void       removePages(CachePage** pages, uint64_t count);
+		void       movePage(CachePage* from, CachePage* to);
+		void       setCapacity(uint64_t pagesCount);
+		void       erase(CachePage* page);
+		void       getResidentPages(std::vector<CachePage*>& resident);
+	private:
+		void       runHotHand();
+		void       addTestPage(uint64_t pageKey);
+
+		std::vector<CachePage*> pages;          // Pages of shard memory pool (clock)
+		uint64_t   pagesCount;                  // Shard capacity (pages)
+		uint64_t   coldHand;                    // Cold pages hand position
+		uint64_t   hotHand;                     // Hot pages hand position
+		uint64_t   hotPagesCount;               // Resident hot pages count
+		uint64_t   coldTarget;                  // Adaptive cold pages target
+
+		std::list<uint64_t> testPages;          // Non-resident test pages (FIFO)
+		std::unordered_map<uint64_t, std::list<uint64_t>::iterator> testPagesMap;
+	};
+
+
+	//-------------------------------------------------------------------------
+	// 2Q policy (probationary FIFO, ghost queue and main LRU)
+	//-------------------------------------------------------------------------
+	class TwoQueuePolicy : public CachePolicy {
+	public:
+		TwoQueuePolicy();
+		void       insert(CachePage* page, AccessHint hint);
+		void       access(CachePage* page, AccessHint hint);
+		CachePage* evict();
+		void       clear();
+		void       addPages(CachePage** pages, uint64_t count);
+		void       removePages(CachePage** pages, uint64_t count);
+		void       movePage(CachePage* from, CachePage* to);
+		void       setCapacity(uint64_t pagesCount);
+		void       erase(CachePage* page);
+		void       getResidentPages(std::vector<CachePage*>& resident);
+	private:
+		void       addGhostPage(uint64_t pageKey);
+
+		uint64_t        inTarget;               // Probationary queue target size
+		uint64_t        outTarget;              // Ghost queue maximum size
+		CacheLinkedList inQueue;                // Probationary pages FIFO (A1in)
+		CacheLinkedList mainQueue;              // Main pages LRU (Am)
+
+		std::list<uint64_t> ghostPages;         // Evicted probationary pages (A1out)
+		std::unordered_map<uint64_t, std::list<uint64_t>::iterator> ghostPagesMap;
+	};
+
+}
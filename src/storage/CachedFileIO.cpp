@@ -16,6 +16,37 @@
 *    - O(1) time complexity of page insert
 *    - O(1) time complexity of page remove
 *
+*  Replacement policy is selectable on open: LRU (default), CLOCK,
+*  CLOCK-Pro or 2Q. CLOCK policies only set reference bit on cache hit.
+*  Read operations accept access hint: pages of sequential scan are not
+*  promoted by replacement policies and are evicted first.
+*
+*  Data within one page can be accessed without copying through pinned
+*  page handle (PinnedPage), pinned pages are not evicted until released.
+*
+*  Cache is split into shards by file page number. Each shard has its own
+*  hashmap, replacement policy and latch, so read/write operations are
+*  thread safe and threads accessing different shards do not block each
+*  other.
+*
+*  Optional background write-back thread persists dirty pages in file
+*  offset order when shard dirty pages exceed high watermark, so cache
+*  misses rarely have to write dirty victim page on the caller's thread.
+*
+*  On Linux misses of multi-page reads and flush writes are submitted to
+*  the kernel as a group through io_uring (AsyncIO), with fallback to
+*  synchronous I/O if io_uring is not available.
+*
+*  Pages are read from and written to storage device (StorageDevice): OS
+*  file by default (positional I/O on POSIX systems, misses of different
+*  threads go to storage device in parallel), growable memory or latency
+*  simulating device set before open. Group I/O submission is used only
+*  by devices backed by OS file descriptor.
+*
+*  Optional warm-up manifest (sidecar file) keeps resident pages between
+*  sessions, so restarted database reaches its hit rate without waiting
+*  for the workload to fault the pages in one by one.
+*
 *  CachedFileIO vs STDIO performance tests (Release Mode):
 *    - 50%-97% cache read hits leads to 50%-600% performance growth
 *    - 35%-49% cache read hits leads to 12%-36% performance growth
@@ -28,10 +59,15 @@
 #include "CachedFileIO.h"
 
 #include <algorithm>
+#include <vector>
 #include <chrono>
+#include <cstdlib>
 
 using namespace Boson;
 
+// Pages have been loaded to cache by current operation of the thread
+static thread_local bool pagesLoaded = false;
+
 /**
 *
 * @brief Constructor
@@ -39,11 +75,30 @@ using namespace Boson;
 */
 CachedFileIO::CachedFileIO() {
 	this->readOnly = false;
-	this->fileHandler = nullptr;
-	this->cachePageInfoPool = nullptr;		
-	this->cachePageDataPool = nullptr;
-	this->maxPagesCount = 0;
-	this->pageCounter = 0;
+	this->device = &fileDevice;
+	this->pool = &privatePool;
+	this->fileId = 0;
+	this->writeBackEnabled = false;
+	this->writeBackStop = false;
+	this->dirtyHighWatermark = DIRTY_HIGH;
+	this->dirtyLowWatermark = DIRTY_LOW;
+	this->asyncEnabled = true;
+	this->directEnabled = false;
+	this->directIO = false;
+	this->readAheadEnabled = true;
+	this->warmUpEnabled = false;
+	this->warmUpBackground = true;
+	this->warmUpStop = false;
+	this->warmUpRestored = 0;
+	this->warmUpPages = 0;
+	this->warmUpDuration = 0;
+	this->storageSize = 0;
+	for (size_t i = 0; i < MAX_SHARDS; i++) {
+		fileShards[i].dirtyPages = 0;
+		fileShards[i].writeBackCursor = 0;
+	}
+	applyPageSize(PAGE_SIZE);
+	resetReadAhead();
 	resetStats();
 }
 
@@ -60,54 +115,111 @@ CachedFileIO::~CachedFileIO() {
 
 /**
 *
-*  @brief Opens file and allocates cache memory
+*  @brief Opens file and allocates private cache memory of the file
 * 
 *  @param[in] fileName   - the name of the file to be opened (path)
 *  @param[in] cacheSize  - how much memory for cache to allocate (bytes) 
 *  @param[in] isReadOnly - if true, write operations are not allowed
+*  @param[in] policy     - cache replacement policy (LRU, CLOCK, CLOCK_PRO, TWO_QUEUE)
 *
-*  @return true if file opened, false if can't open file
+*  @return true if file opened, false if can't open file or allocate cache
 *
 */
-bool CachedFileIO::open(const char* path, size_t cacheSize, bool isReadOnly) {
+bool CachedFileIO::open(const char* path, size_t cacheSize, bool isReadOnly, CachePolicyType policy) {
 	// return if null pointer
 	if (path == nullptr) return false;
 	// if current file still open, close it
-	if (this->fileHandler != nullptr) close();
-	// try to open existing file for binary read/update (file must exist)
-	errno_t errNo = fopen_s(&(this->fileHandler), path, "r+b");
-	// if file does not exist or another problem
-	if (errNo != 0 || this->fileHandler == nullptr) {
-		// if can`t open file in read only mode return false
-		if (isReadOnly) {
-			this->fileHandler = nullptr;
-			return false;
-		}
-		// try to create new file for binary write/read
-		errNo = fopen_s(&(this->fileHandler), path, "w+b");
-		// if still can't create file return false
-		if (errNo != 0 || this->fileHandler == nullptr) {
-			this->fileHandler = nullptr;
-			return false;
-		}
-	}
-	// set mode to no buffering, we will manage buffers and caching by our selves
-	setvbuf(this->fileHandler, nullptr, _IONBF, 0);
-	// Allocated cache
-	if (setCacheSize(cacheSize) == NOT_FOUND) {
-		close();
-		return false;
-	}
+	if (device->isOpen()) close();
+	// Allocate private pool of cached pages of current page size
+	privatePool.setPageSize(pageSize);
+	if (!privatePool.allocate(cacheSize, policy)) return false;
+	// Open file drawing pages from private pool
+	if (open(path, privatePool, isReadOnly)) return true;
+	privatePool.release();
+	return false;
+}
+
+
+
+/**
+*
+*  @brief Opens file drawing cache pages from the pool shared with other
+*  files: pages of all files compete for pool memory under pool replacement
+*  policy. Page size of the file is page size of the pool.
+*
+*  @param[in] fileName   - the name of the file to be opened (path)
+*  @param[in] bufferPool - allocated pages pool (must outlive open file)
+*  @param[in] isReadOnly - if true, write operations are not allowed
+*
+*  @return true if file opened, false if can't open file or pool is not allocated
+*
+*/
+bool CachedFileIO::open(const char* path, BufferPool& bufferPool, bool isReadOnly) {
+	// return if null pointer or pool has no memory
+	if (path == nullptr || !bufferPool.isAllocated()) return false;
+	// if current file still open, close it
+	if (device->isOpen()) close();
+	// Open file on storage device
+	if (!openFile(path, isReadOnly)) return false;
+	// Draw cache pages from the pool
+	this->attachPool(bufferPool);
 	// Set readOnly flag
 	this->readOnly = isReadOnly;
-	// Clear statistics
+	// Clear statistics and sequential streams
 	this->resetStats();
+	this->resetReadAhead();
+	// Start background write-back if enabled
+	if (writeBackEnabled && !readOnly) startWriteBack();
+	// Restore cached pages of previous session if enabled
+	this->warmUpPath = std::string(path) + WARM_UP_SUFFIX;
+	if (warmUpEnabled && device->isPersistent()) startWarmUp();
 	// file successfuly opened
 	return true;
 }
 
 
 
+/**
+*
+*  @brief Opens storage device, creates file if it doesn't exist (unless
+*  read only), enables direct I/O and group I/O submission if possible
+*
+*  @param[in] fileName   - the name of the file to be opened (path)
+*  @param[in] isReadOnly - if true, file is not created and opened for reading
+*
+*  @return true if file opened, false if can't open file
+*
+*/
+bool CachedFileIO::openFile(const char* path, bool isReadOnly) {
+	// open existing file or create new one (unless read only)
+	if (!device->open(path, isReadOnly)) return false;
+	// remember file size on storage to skip fetches of pages beyond it
+	this->storageSize = device->getSize();
+	// bypass OS page cache if enabled (file system may not support it)
+	this->directIO = directEnabled && device->setDirectIO(true);
+	// set up group I/O submission (not available on some platforms and kernels)
+#ifndef _WIN32
+	int fileDescriptor = device->getDescriptor();
+	if (asyncEnabled && fileDescriptor >= 0) this->asyncIO.open(fileDescriptor);
+#endif
+	return true;
+}
+
+
+
+/**
+*
+*  @brief Releases group I/O submission and closes storage device
+*
+*/
+void CachedFileIO::closeFile() {
+	this->asyncIO.close();
+	this->device->close();
+	this->directIO = false;
+}
+
+
+
 /**
 *
 *  @brief Closes file, persists changed pages and releases cache memory
@@ -117,19 +229,59 @@ bool CachedFileIO::open(const char* path, size_t cacheSize, bool isReadOnly) {
 */
 bool CachedFileIO::close() {
 	// check if file was opened
-	if (fileHandler == nullptr) return false;
+	if (!device->isOpen()) return false;
+	// stop background write-back and warm-up
+	this->stopWriteBack();
+	this->stopWarmUp();
 	// flush buffers if we have write permissions
 	if (!readOnly) this->flush();
-	// close file
-	fclose(fileHandler);
-	// Release memory pool of cached pages
-	this->releasePool();
-	// mark that file is closed
-	this->fileHandler = nullptr;
+	// remember resident pages for the next session
+	if (warmUpEnabled && !readOnly && device->isPersistent()) this->saveWarmUpManifest();
+	// Drop cached pages of the file (private pool is released)
+	this->detachPool();
+	// release group I/O submission and close file
+	this->closeFile();
 	return true;
 }
 
 
+
+/**
+*
+*  @brief Attaches file to the pages pool: page size of the file is set to
+*  pool page size
+*
+*  @param bufferPool - allocated pages pool
+*
+*/
+void CachedFileIO::attachPool(BufferPool& bufferPool) {
+	// Pages of the file are pool pages
+	applyPageSize(bufferPool.getPageSize());
+	// Page keys of the file are prefixed by file id
+	this->pool = &bufferPool;
+	this->fileId = bufferPool.attach(this);
+	for (size_t i = 0; i < MAX_SHARDS; i++) {
+		fileShards[i].dirtyPages = 0;
+		fileShards[i].writeBackCursor = 0;
+	}
+}
+
+
+
+/**
+*
+*  @brief Detaches file from the pages pool: drops cached pages of the file
+*  (changed pages must be persisted before) and releases private pool
+*
+*/
+void CachedFileIO::detachPool() {
+	pool->detach(fileId);
+	if (pool == &privatePool) privatePool.release();
+	this->pool = &privatePool;
+}
+
+
+
 /**
 *
 *  @brief Checks if file is open
@@ -138,7 +290,7 @@ bool CachedFileIO::close() {
 *
 */
 bool CachedFileIO::isOpen() {
-	return fileHandler != nullptr;
+	return device->isOpen();
 }
 
 
@@ -163,26 +315,39 @@ bool CachedFileIO::isReadOnly() {
 *  @param[in]  position   - offset from beginning of the file
 *  @param[out] dataBuffer - data buffer where data copied
 *  @param[in]  length     - data amount to read
+*  @param[in]  hint       - access hint (SEQUENTIAL for scans)
 * 
 *  @return total bytes amount actually read to the data buffer
 * 
 */
-size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
+size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length, AccessHint hint) {
 
 	// In case we reading one aligned page
-	if ((position % PAGE_SIZE == 0) && (length == PAGE_SIZE)) {
-		return readPage(position / PAGE_SIZE, dataBuffer);
+	if (((position & pageMask) == 0) && (length == pageSize)) {
+		return readPage(position >> pageShift, dataBuffer, hint);
 	}
 
 	// Check if file handler, data buffer and length are not null
-	if (fileHandler == nullptr || dataBuffer == nullptr || length == 0) return 0;
+	if (!device->isOpen() || dataBuffer == nullptr || length == 0) return 0;
 
-	// Time point A
-	auto startTime = std::chrono::high_resolution_clock::now();
+	// Time sampled operations only
+	LatencyTimer timer;
+	pagesLoaded = false;
 
 	// Calculate start and end page number in the file
-	size_t firstPageNo = position / PAGE_SIZE;
-	size_t lastPageNo = (position + length) / PAGE_SIZE;
+	size_t firstPageNo = position >> pageShift;
+	size_t lastPageNo = (position + length) >> pageShift;
+
+	// Detect sequential access and prefetch next pages
+	size_t lastDataPageNo = (position + length - 1) >> pageShift;
+	readAhead(firstPageNo, lastDataPageNo, hint);
+
+	// Load missing pages of multi-page request with batched reads
+	if (lastDataPageNo > firstPageNo) {
+		for (size_t pageNo = firstPageNo; pageNo <= lastDataPageNo; pageNo += MAX_RUN_PAGES) {
+			loadPagesToCache(pageNo, std::min(pageNo + MAX_RUN_PAGES - 1, lastDataPageNo), hint);
+		}
+	}
 
 	// Initialize local variables
 	CachePage* pageInfo = nullptr;
@@ -194,9 +359,14 @@ size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
 	// Iterate through requested file pages
 	for (size_t filePage = firstPageNo; filePage <= lastPageNo; filePage++) {
 		
+		// Lock shard of the file page until data copied
+		CacheShard& shard = getShard(filePage);
+		std::lock_guard<std::mutex> lock(shard.latch);
+
 		// Lookup or load file page to cache
-		pageInfo = searchPageInCache(filePage);
-	    // if (pageInfo == nullptr) return 0;
+		pageInfo = searchPageInCache(shard, filePage, hint);
+		// all pages of the shard are pinned
+		if (pageInfo == nullptr) break;
 				
 		// Get cached page description and data
 		pageDataLength = pageInfo->availableDataLength;   // BUG: Page data length 8220 !?
@@ -204,7 +374,7 @@ size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
 		// Calculate source pointers and data length to copy
 		if (filePage == firstPageNo) {
 			// Case 1: if reading first page
-			size_t firstPageOffset = position % PAGE_SIZE;
+			size_t firstPageOffset = position & pageMask;
 			src = &pageInfo->data[firstPageOffset];
 			if (firstPageOffset < pageDataLength)
 				if (firstPageOffset + length > pageDataLength)
@@ -213,7 +383,7 @@ size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
 			else bytesToCopy = 0;
 		} else if (filePage == lastPageNo) {
 			// Case 2: if reading last page
-			size_t remainingBytes = (position + length) % PAGE_SIZE;
+			size_t remainingBytes = (position + length) & pageMask;
 			src = pageInfo->data;                               
 			if (remainingBytes < pageDataLength)                           
 				bytesToCopy = remainingBytes;                              
@@ -221,7 +391,7 @@ size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
 		} else {                       
 			// Case 3: if reading middle page 
 			src = pageInfo->data;
-			bytesToCopy = PAGE_SIZE;
+			bytesToCopy = pageSize;
 		}
 
 		// Copy available data from cache page to user's data buffer 		
@@ -231,10 +401,8 @@ size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
 
 	}
 
-	// Time point B
-	auto endTime = std::chrono::high_resolution_clock::now();
-	// Calculate and increment read duration
-	this->totalReadDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	// Record latency of sampled operation
+	recordLatency(timer, totalReadDuration);
 	// Increment bytes read
 	this->totalBytesRead += bytesRead;
 	// return bytes read
@@ -257,14 +425,15 @@ size_t CachedFileIO::read(size_t position, void* dataBuffer, size_t length) {
 size_t CachedFileIO::write(size_t position, const void* dataBuffer, size_t length) {
 
 	// Check if file handler, data buffer and length are not null
-	if (fileHandler == nullptr || this->readOnly || dataBuffer == nullptr || length == 0) return 0;
+	if (!device->isOpen() || this->readOnly || dataBuffer == nullptr || length == 0) return 0;
 
-	// Time point A
-	auto startTime = std::chrono::high_resolution_clock::now();
+	// Time sampled operations only
+	LatencyTimer timer;
+	pagesLoaded = false;
 	
 	// Calculate start and end page number in the file
-	size_t firstPageNo = position / PAGE_SIZE;
-	size_t lastPageNo = (position + length) / PAGE_SIZE;
+	size_t firstPageNo = position >> pageShift;
+	size_t lastPageNo = (position + length - 1) >> pageShift;
 
 	// Initialize local variables
 	CachePage* pageInfo = nullptr;
@@ -277,43 +446,49 @@ size_t CachedFileIO::write(size_t position, const void* dataBuffer, size_t lengt
 	// Iterate through file pages
 	for (size_t filePage = firstPageNo; filePage <= lastPageNo; filePage++) {
 
-		// Fetch-before-write (FBW)
-		pageInfo = searchPageInCache(filePage);
-		//if (pageInfo == nullptr) return 0;
-
-		// Get cached page description and data
-		pageDataLength = pageInfo->availableDataLength;
-
-		// Calculate source pointers and data length to write
+		// Calculate page offset and data length to write
 		if (filePage == firstPageNo) {
 			// Case 1: if writing first page
-			offset = position % PAGE_SIZE;
-			dst = &pageInfo->data[offset];
-			bytesToCopy = std::min(length, PAGE_SIZE - offset);
+			offset = position & pageMask;
+			bytesToCopy = std::min(length, pageSize - offset);
 		} else if (filePage == lastPageNo) {
 			// Case 2: if writing last page
 			offset = 0;
-			dst = pageInfo->data;
 			bytesToCopy = length - bytesWritten;
 		} else {
-			// Case 3: if reading middle page 
+			// Case 3: if writing middle page 
 			offset = 0;
-			dst = pageInfo->data;
-			bytesToCopy = PAGE_SIZE;
+			bytesToCopy = pageSize;
 		}
 
+		// Lock shard of the file page until data copied
+		CacheShard& shard = getShard(filePage);
+		std::lock_guard<std::mutex> lock(shard.latch);
+
+		// Fetch-before-write (FBW) is not needed if page is fully overwritten
+		// or page is beyond the end of the file on storage device (checked
+		// under shard latch: eviction of the page may have just persisted it)
+		bool fetch = (bytesToCopy < pageSize) && (filePage * pageSize < storageSize);
+
+		// Lookup or allocate file page in cache
+		pageInfo = searchPageInCache(shard, filePage, AccessHint::NORMAL, fetch);
+		// all pages of the shard are pinned
+		if (pageInfo == nullptr) break;
+
+		// Get cached page description and data
+		pageDataLength = pageInfo->availableDataLength;
+		dst = &pageInfo->data[offset];
+
 		// Copy available data from user's data buffer to cache page 
 		memcpy(dst, src, bytesToCopy);       // copy user buffer data to cache page
-		pageInfo->state = PageState::DIRTY;  // mark page as "dirty" (rewritten)
+		markDirty(shard, pageInfo, offset, bytesToCopy); // mark written sectors "dirty"
 		pageInfo->availableDataLength = std::max(pageDataLength, offset + bytesToCopy);
 		bytesWritten += bytesToCopy;         // increment written bytes counter
 		src += bytesToCopy;                  // increment pointer in user buffer
 
 	}
-	// Time point B
-	auto endTime = std::chrono::high_resolution_clock::now();
-	// Calculate and increment write duration
-	this->totalWriteDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	// Record latency of sampled operation
+	recordLatency(timer, totalWriteDuration);
 	// Increment bytes written
 	this->totalBytesWritten += bytesWritten;
 	// return bytes written
@@ -327,32 +502,41 @@ size_t CachedFileIO::write(size_t position, const void* dataBuffer, size_t lengt
 *  @brief Read page from cached file to user buffer
 *
 *  @param[in]  pageNo - file page number
-*  @param[out] userPageBuffer - data buffer (Boson::PAGE_SIZE)
+*  @param[out] userPageBuffer - data buffer (page size)
+*  @param[in]  hint - access hint (SEQUENTIAL for scans)
 *
 *  @return total bytes amount actually read to the data buffer
 *
 */
-size_t CachedFileIO::readPage(size_t pageNo, void* userPageBuffer) {
+size_t CachedFileIO::readPage(size_t pageNo, void* userPageBuffer, AccessHint hint) {
 
 	// Check if file handler, data buffer and length are not null
-	if (fileHandler == nullptr || userPageBuffer == nullptr) return 0;
+	if (!device->isOpen() || userPageBuffer == nullptr) return 0;
+
+	// Time sampled operations only
+	LatencyTimer timer;
+	pagesLoaded = false;
 
-	// Time point A
-	auto startTime = std::chrono::high_resolution_clock::now();
+	// Detect sequential access and prefetch next pages
+	readAhead(pageNo, pageNo, hint);
+
+	// Lock shard of the file page until data copied
+	CacheShard& shard = getShard(pageNo);
+	std::unique_lock<std::mutex> lock(shard.latch);
 
 	// Lookup or load file page to cache
-	CachePage* pageInfo = searchPageInCache(pageNo);
+	CachePage* pageInfo = searchPageInCache(shard, pageNo, hint);
+	if (pageInfo == nullptr) return 0;
 
 	// Copy available data from cache page to user's data buffer
 	uint8_t* src = pageInfo->data;
 	uint8_t* dst = (uint8_t*) userPageBuffer;
 	size_t availableData = pageInfo->availableDataLength;	
 	memcpy(dst, src, availableData);
+	lock.unlock();
 		
-	// Time point B
-	auto endTime = std::chrono::high_resolution_clock::now();
-	// Calculate and increment read duration
-	this->totalReadDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	// Record latency of sampled operation
+	recordLatency(timer, totalReadDuration);
 	// Increment bytes read
 	this->totalBytesRead += availableData;
 
@@ -374,27 +558,32 @@ size_t CachedFileIO::readPage(size_t pageNo, void* userPageBuffer) {
 */
 size_t CachedFileIO::writePage(size_t pageNo, const void* userPageBuffer) {
 	// Check if file handler and data buffer are not null, and write is allowed
-	if (fileHandler == nullptr || this->readOnly || userPageBuffer == nullptr) return 0;
+	if (!device->isOpen() || this->readOnly || userPageBuffer == nullptr) return 0;
+
+	// Time sampled operations only
+	LatencyTimer timer;
+	pagesLoaded = false;
 
-	// Time point A
-	auto startTime = std::chrono::high_resolution_clock::now();
+	// Lock shard of the file page until data copied
+	CacheShard& shard = getShard(pageNo);
+	std::unique_lock<std::mutex> lock(shard.latch);
 
-	// Fetch-before-write (FBW)
-	CachePage* pageInfo = searchPageInCache(pageNo);
+	// Page is fully overwritten, so it is not fetched from storage on miss
+	CachePage* pageInfo = searchPageInCache(shard, pageNo, AccessHint::NORMAL, false);
+	if (pageInfo == nullptr) return 0;
 
 	// Initialize local variables
 	uint8_t* src = (uint8_t*)userPageBuffer;
 	uint8_t* dst = pageInfo->data;
-	size_t bytesToCopy = PAGE_SIZE;
+	size_t bytesToCopy = pageSize;
 
 	memcpy(dst, src, bytesToCopy);               // copy user buffer data to cache page
-	pageInfo->state = PageState::DIRTY;          // mark page as "dirty" (rewritten)
-	pageInfo->availableDataLength = bytesToCopy; // set available data as PAGE_SIZE
+	markDirty(shard, pageInfo, 0, pageSize);     // mark page as "dirty" (rewritten)
+	pageInfo->availableDataLength = bytesToCopy; // set available data as page size
+	lock.unlock();
 
-	// Time point B
-	auto endTime = std::chrono::high_resolution_clock::now();
-	// Calculate and increment write duration
-	this->totalWriteDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	// Record latency of sampled operation
+	recordLatency(timer, totalWriteDuration);
 	// Increment bytes written
 	this->totalBytesWritten += bytesToCopy;
 
@@ -412,36 +601,55 @@ size_t CachedFileIO::writePage(size_t pageNo, const void* userPageBuffer) {
 */
 size_t CachedFileIO::flush() {
 
-	if (fileHandler == nullptr || this->readOnly) return 0;
+	if (!device->isOpen() || this->readOnly) return 0;
 
-	// Time point A
-	auto startTime = std::chrono::high_resolution_clock::now();
+	// Flushes are always timed
+	uint64_t startTime = getTimeNs();
 
-	// Suppose all pages will be persisted
-	bool allDirtyPagesPersisted = true;
+	// Lock all shards in ascending order and collect dirty pages of the file
+	std::vector<std::unique_lock<std::mutex>> locks;
+	std::vector<CachePage*> dirtyPages;
+	for (size_t i = 0; i < pool->shardsCount; i++) {
+		DirtyPagesMap& dirtyMap = pool->shards[i].dirtyMap;
+		locks.emplace_back(pool->shards[i].latch);
+		auto first = dirtyMap.lower_bound(getPageKey(fileId, 0));
+		auto last = dirtyMap.upper_bound(getPageKey(fileId, MAX_FILE_PAGE));
+		for (auto entry = first; entry != last; entry++) dirtyPages.push_back(entry->second);
+	}
 
-	// Sort cache list by file page number in ascending order for sequential write
-	cacheList.sort([](const CachePage* cp1, const CachePage* cp2)
+	// Merge dirty pages of shards by file page number for sequential write
+	std::sort(dirtyPages.begin(), dirtyPages.end(), [](const CachePage* cp1, const CachePage* cp2)
 		{
-			if (cp1->filePageNo == cp2->filePageNo)
-				return cp1->filePageNo < cp2->filePageNo;
 			return cp1->filePageNo < cp2->filePageNo;
 		});
 
-	// Persist pages to storage device
-	for (CachePage* node : cacheList) {
-		if (node->state = PageState::DIRTY) {
-			allDirtyPagesPersisted = allDirtyPagesPersisted && persistCachePage(node);
-		}
+	// Persist dirty ranges of runs of consecutive file pages with one write
+	// call per range or with one group submission of all ranges
+	uint64_t writeCalls = this->storageWriteCalls;
+	uint64_t bytesWritten = this->storageBytesWritten;
+	std::vector<std::pair<size_t, size_t>> runs;
+	size_t runStart = 0;
+	for (size_t i = 1; i <= dirtyPages.size(); i++) {
+		if (i < dirtyPages.size() &&
+			i - runStart < MAX_RUN_PAGES &&
+			dirtyPages[i]->filePageNo == dirtyPages[i - 1]->filePageNo + 1) continue;
+		runs.push_back(std::make_pair(runStart, i - runStart));
+		runStart = i;
 	}
-	
-	// flush buffers to storage device
-	bool buffersFlushed = (fflush(fileHandler) == 0);
+	bool allDirtyPagesPersisted = persistCachePageRuns(dirtyPages.data(), runs);
+	this->flushWriteCalls += this->storageWriteCalls - writeCalls;
+	this->flushBytesWritten += this->storageBytesWritten - bytesWritten;
+	this->totalFlushes++;
+	locks.clear();
 
-	// Time point B
-	auto endTime = std::chrono::high_resolution_clock::now();
-	// Calculate and increment write duration
-	this->totalWriteDuration += std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+	// Persist written data on storage device without shard latches held,
+	// so sync doesn't stall other files of the shared buffer pool
+	bool buffersFlushed = device->sync();
+
+	// Record flush latency and increment write duration
+	uint64_t latency = getTimeNs() - startTime;
+	this->flushLatency.record(latency);
+	this->totalWriteDuration += latency;
 
 	return allDirtyPagesPersisted && buffersFlushed;
 
@@ -449,67 +657,203 @@ size_t CachedFileIO::flush() {
 
 
 
+/**
+*
+*  @brief Pins cached data for direct read access without copying
+*
+*  @param[in] position - offset from beginning of the file
+*  @param[in] length   - data length (data must not cross page boundary)
+*  @param[in] hint     - access hint (SEQUENTIAL for scans)
+*
+*  @return pinned page handle or not pinned handle if data crosses page
+*  boundary, is not available in the file or all shard pages are pinned
+*
+*/
+PinnedPage CachedFileIO::pin(size_t position, size_t length, AccessHint hint) {
+
+	if (!device->isOpen() || length == 0) return PinnedPage();
+
+	// Data must be within one page
+	size_t pageNo = position >> pageShift;
+	size_t offset = position & pageMask;
+	if (offset + length > pageSize) return PinnedPage();
+
+	// Detect sequential access and prefetch next pages
+	readAhead(pageNo, pageNo, hint);
+
+	// Lock shard of the file page until page pinned
+	CacheShard& shard = getShard(pageNo);
+	std::lock_guard<std::mutex> lock(shard.latch);
+
+	// Lookup or load file page to cache
+	CachePage* pageInfo = searchPageInCache(shard, pageNo, hint);
+	if (pageInfo == nullptr || offset + length > pageInfo->availableDataLength) return PinnedPage();
+
+	// Protect page from eviction
+	pageInfo->pinCount++;
+	this->totalBytesPinned += length;
+
+	return PinnedPage(this, pageInfo, &pageInfo->data[offset], length);
+}
+
+
+
+/**
+*
+*  @brief Pins whole cached page for direct read access without copying
+*
+*  @param[in] pageNo - file page number
+*  @param[in] hint   - access hint (SEQUENTIAL for scans)
+*
+*  @return pinned page handle (length is available data of the page)
+*  or not pinned handle if all shard pages are pinned
+*
+*/
+PinnedPage CachedFileIO::pinPage(size_t pageNo, AccessHint hint) {
+
+	if (!device->isOpen()) return PinnedPage();
+
+	// Detect sequential access and prefetch next pages
+	readAhead(pageNo, pageNo, hint);
+
+	// Lock shard of the file page until page pinned
+	CacheShard& shard = getShard(pageNo);
+	std::lock_guard<std::mutex> lock(shard.latch);
+
+	// Lookup or load file page to cache
+	CachePage* pageInfo = searchPageInCache(shard, pageNo, hint);
+	if (pageInfo == nullptr) return PinnedPage();
+
+	// Protect page from eviction
+	pageInfo->pinCount++;
+	this->totalBytesPinned += pageInfo->availableDataLength;
+
+	return PinnedPage(this, pageInfo, pageInfo->data, pageInfo->availableDataLength);
+}
+
+
+
+/**
+* @brief Unpins cache page, so it can be evicted (called by PinnedPage)
+* @param pageInfo - pinned cache page
+*/
+void CachedFileIO::unpin(CachePage* pageInfo) {
+	CacheShard& shard = getShard(pageInfo->filePageNo);
+	std::lock_guard<std::mutex> lock(shard.latch);
+	pageInfo->pinCount--;
+}
+
+
+
 /**
 * @brief Reset IO statistics
 * @param type - requested stats type
 * @return value of stats
 */
 void CachedFileIO::resetStats() {
-	this->cacheRequests = 0;
-	this->cacheMisses = 0;
+	for (size_t i = 0; i < MAX_SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(pool->shards[i].latch);
+		fileShards[i].cacheRequests = 0;
+		fileShards[i].cacheMisses = 0;
+	}
 	this->totalBytesRead = 0;
 	this->totalBytesWritten = 0;
+	this->totalBytesPinned = 0;
 	this->totalReadDuration = 0;
 	this->totalWriteDuration = 0;
+	this->dirtyEvictions = 0;
+	this->writeBackPages = 0;
+	this->totalFlushes = 0;
+	this->flushWriteCalls = 0;
+	this->flushBytesWritten = 0;
+	this->batchedReadPages = 0;
+	this->asyncIO.resetStats();
+	this->readAheadPages = 0;
+	this->readAheadHits = 0;
+	this->readAheadWasted = 0;
+	this->storageBytesRead = 0;
+	this->skippedFetches = 0;
+	this->storageWriteCalls = 0;
+	this->storageBytesWritten = 0;
+	this->hitLatency.reset();
+	this->missLatency.reset();
+	this->evictionLatency.reset();
+	this->flushLatency.reset();
 }
 
 
 
 /**
-* @brief Return IO statistics
-* @param type - requested stats type
-* @return value of stats
+*
+* @brief Takes snapshot of IO statistics: counters and latency percentiles
+* of sampled operations (hits, misses), dirty evictions and flushes
+* @param stats - statistics snapshot
+*
 */
-double CachedFileIO::getStats(CachedFileStats type) {
-
-	double totalRequests = (double)cacheRequests;
-	double totalCacheMisses = (double)cacheMisses;
-	double seconds = 0;
-	double megabytes = 0;
-
-	switch (type) {
-	case CachedFileStats::TOTAL_REQUESTS:
-		return double(totalRequests);
-	case CachedFileStats::TOTAL_CACHE_MISSES:
-		return double(cacheMisses);
-	case CachedFileStats::TOTAL_CACHE_HITS:
-		return double(totalRequests - cacheMisses);
-	case CachedFileStats::TOTAL_BYTES_WRITTEN:
-		return double(totalBytesWritten);
-	case CachedFileStats::TOTAL_BYTES_READ:
-		return double(totalBytesRead);
-	case CachedFileStats::TOTAL_WRITE_TIME_NS:
-		return double(totalWriteDuration);
-	case CachedFileStats::TOTAL_READ_TIME_NS:
-		return double(totalReadDuration);
-	case CachedFileStats::CACHE_HITS_RATE:
-		if (totalRequests == 0) return 0;
-		return (totalRequests - totalCacheMisses) / totalRequests * 100.0;
-	case CachedFileStats::CACHE_MISSES_RATE:
-		if (totalRequests == 0) return 0;
-		return totalCacheMisses / totalRequests * 100.0;
-	case CachedFileStats::READ_THROUGHPUT:
-		if (this->totalReadDuration == 0) return 0;
-		seconds = double(this->totalReadDuration) / 1000000000.0;
-		megabytes = double(this->totalBytesRead) / (1024 * 1024);
-		return megabytes / seconds;
-	case CachedFileStats::WRITE_THROUGHPUT:
-		if (this->totalWriteDuration == 0) return 0;
-		seconds = double(this->totalWriteDuration) / 1000000000.0;
-		megabytes = double(this->totalBytesWritten) / (1024 * 1024);
-		return megabytes / seconds;	
-	}
-	return 0.0;
+void CachedFileIO::getStatsSnapshot(FileIOStats& stats) {
+
+	// Sum up file counters of shards
+	uint64_t cacheRequests = 0;
+	uint64_t cacheMisses = 0;
+	uint64_t dirtyPages = 0;
+	for (size_t i = 0; i < MAX_SHARDS; i++) {
+		std::lock_guard<std::mutex> lock(pool->shards[i].latch);
+		cacheRequests += fileShards[i].cacheRequests;
+		cacheMisses += fileShards[i].cacheMisses;
+		dirtyPages += fileShards[i].dirtyPages;
+	}
+
+	stats = {};
+	stats.totalRequests = cacheRequests;
+	stats.cacheMisses = cacheMisses;
+	stats.bytesWritten = totalBytesWritten;
+	stats.bytesRead = totalBytesRead;
+	stats.bytesPinned = totalBytesPinned;
+	stats.dirtyEvictions = dirtyEvictions;
+	stats.writeBackPages = writeBackPages;
+	stats.dirtyPages = dirtyPages;
+	stats.flushes = totalFlushes;
+	stats.flushWriteCalls = flushWriteCalls;
+	stats.flushBytesWritten = flushBytesWritten;
+	stats.batchedReadPages = batchedReadPages;
+	stats.asyncSubmitCalls = asyncIO.getSubmitCalls();
+	stats.poolMemoryBytes = pool->getMemorySize();
+	stats.readAheadPages = readAheadPages;
+	stats.readAheadHits = readAheadHits;
+	stats.readAheadWasted = readAheadWasted;
+	stats.storageBytesRead = storageBytesRead;
+	stats.skippedFetches = skippedFetches;
+	stats.storageBytesWritten = storageBytesWritten;
+	stats.warmUpPages = warmUpPages;
+	stats.warmUpProgress = warmUpManifest.empty() ? 100.0 :
+		double(warmUpRestored) / double(warmUpManifest.size()) * 100.0;
+	stats.warmUpTimeNs = warmUpDuration;
+	stats.writeTimeNs = totalWriteDuration;
+	stats.readTimeNs = totalReadDuration;
+	hitLatency.getSummary(stats.hitLatency);
+	missLatency.getSummary(stats.missLatency);
+	evictionLatency.getSummary(stats.evictionLatency);
+	flushLatency.getSummary(stats.flushLatency);
+}
+
+
+
+/**
+*
+*  @brief Records latency of sampled read/write operation: to miss histogram
+*  if operation loaded pages to cache, otherwise to hit histogram. Total
+*  duration is incremented by latency of all operations sample stands for.
+*
+*  @param timer - operation timer
+*  @param totalDuration - total duration of the operations type
+*
+*/
+void CachedFileIO::recordLatency(const LatencyTimer& timer, std::atomic<uint64_t>& totalDuration) {
+	if (!timer.isSampled()) return;
+	uint64_t latency = timer.elapsed();
+	totalDuration += latency * LATENCY_SAMPLING;
+	if (pagesLoaded) missLatency.record(latency);
+	else hitLatency.record(latency);
 }
 
 
@@ -522,12 +866,37 @@ double CachedFileIO::getStats(CachedFileStats type) {
 *
 */
 size_t CachedFileIO::getFileSize() {
-	if (fileHandler == nullptr) return 0;
-	size_t currentPosition = _ftelli64(fileHandler);
-	_fseeki64(fileHandler, 0, SEEK_END);
-	size_t fileSize = _ftelli64(fileHandler);
-	_fseeki64(fileHandler, currentPosition, SEEK_SET);
-	return fileSize;
+	return device->getSize();
+}
+
+
+
+/**
+*
+*  @brief Cuts off file data beyond the size: changed pages are persisted,
+*  cached pages beyond the size are dropped and storage device is truncated
+*  (pages beyond the size must not be pinned)
+*
+*  @param size - new file size (not greater than current file size)
+*  @return true if file is truncated, false if file is not open, read only
+*  or smaller than the size
+*
+*/
+bool CachedFileIO::truncate(size_t size) {
+	if (!device->isOpen() || readOnly) return false;
+	bool writeBackRunning = writeBackThread.joinable();
+	this->stopWriteBack();
+	this->stopWarmUp();
+	this->flush();
+	bool truncated = false;
+	if (size <= device->getSize()) {
+		pool->dropPages(fileId, (size + pageMask) >> pageShift);
+		truncated = device->truncate(size);
+		if (truncated) this->storageSize = size;
+		this->resetReadAhead();
+	}
+	if (writeBackRunning) this->startWriteBack();
+	return truncated;
 }
 
 
@@ -541,126 +910,116 @@ size_t CachedFileIO::getFileSize() {
 
 /**
 *
-*  @brief Get cache size in bytes
+*  @brief Get cache size in bytes (capacity of the pool, shared pool
+*  capacity is shared with other files)
 *  @return actual cache size in bytes
 *
 */
 size_t CachedFileIO::getCacheSize() {
-	return this->maxPagesCount * PAGE_SIZE;
+	return pool->getCacheSize();
 }
 
 
 
 /**
 *
-*  @brief Resize cache at runtime: releases memory and allocate new one
+*  @brief Resize cache at runtime keeping resident pages (see
+*  BufferPool::setCacheSize). If file draws pages from shared pool,
+*  capacity of shared pool is changed for all its files.
 *  @param cacheSize - new cache size
-*  @return actual cache size in bytes or NOT_FOUND and closes file if failed to allocate
+*  @return actual cache size in bytes or 0 if file is not open
 *
 */
 size_t CachedFileIO::setCacheSize(size_t cacheSize) {
-	
-	// Check minimal cache size
-	if (cacheSize < MINIMAL_CACHE) cacheSize = MINIMAL_CACHE;
-
-	// check if cache is already allocated
-	if (cachePageInfoPool != nullptr) {
-		// Persist all changed pages to storage device
-		this->flush();
-		// Release allocated memory, list and map
-		this->releasePool();
-		// Clear cache pages list and hashmap
-		this->cacheList.clear();
-		this->cacheMap.clear();
-	} 
-	
-	// Calculate pages count
-	this->pageCounter = 0;
-	this->maxPagesCount = cacheSize / PAGE_SIZE;
-
-	// Try to allocate new cache
-	try {
-		this->allocatePool(this->maxPagesCount);
-		this->cacheMap.reserve(maxPagesCount);
-	} catch (std::bad_alloc& ba) {	
-		// close file and return NOT_FOUND
-		std::cout << "Can't allocate cache of size " << cacheSize << ": " << ba.what() << std::endl;
-		this->close();
-		return NOT_FOUND;
-	}
-	
-	// Reset stats
-	this->resetStats();
-	// Return cache size in bytes
-	return this->maxPagesCount * PAGE_SIZE;
+	if (!device->isOpen()) return 0;
+	return pool->setCacheSize(cacheSize);
 }
 
 
 
 /**
-* @brief Allocates memory pool for cache pages
+*
+*  @brief Get page size in bytes
+*  @return page size in bytes
+*
 */
-void CachedFileIO::allocatePool(size_t pagesToAllocate) {
-	this->cachePageInfoPool = new CachePage[pagesToAllocate];
-	this->cachePageDataPool = new CachePageData[pagesToAllocate];
+size_t CachedFileIO::getPageSize() {
+	return this->pageSize;
 }
 
 
+
 /**
-* @brief Releases memory pool
+*
+*  @brief Sets page size: power of 2 from MIN_PAGE_SIZE to MAX_PAGE_SIZE.
+*  If file is open, changed pages are persisted and private cache of the
+*  same size in bytes is allocated for new pages (must not be called
+*  concurrently with other operations). Page size of file drawing pages
+*  from shared pool can't be changed.
+*  @param newPageSize - new page size in bytes
+*  @return true if page size is set, false if page size is invalid, differs
+*  from shared pool page size or failed to allocate cache (file is closed)
+*
 */
-void CachedFileIO::releasePool() {
-	this->maxPagesCount = 0;
-	this->pageCounter = 0;
-	cacheList.clear();
-	cacheMap.clear();
-	delete[] cachePageInfoPool;
-	delete[] cachePageDataPool;
-	cachePageInfoPool = nullptr;
-	cachePageDataPool = nullptr;
+bool CachedFileIO::setPageSize(size_t newPageSize) {
+	if (!isValidPageSize(newPageSize)) return false;
+	if (newPageSize == this->pageSize) return true;
+	if (!device->isOpen()) {
+		applyPageSize(newPageSize);
+		return true;
+	}
+	if (pool != &privatePool) return false;
+	// Persist changed pages of current page size
+	size_t cacheSize = getCacheSize();
+	CachePolicyType policy = privatePool.cachePolicy;
+	bool writeBackRunning = writeBackThread.joinable();
+	this->stopWriteBack();
+	this->stopWarmUp();
+	this->flush();
+	this->detachPool();
+	// Allocate cache of the same size for new pages
+	privatePool.setPageSize(newPageSize);
+	if (!privatePool.allocate(cacheSize, policy)) {
+		this->close();
+		return false;
+	}
+	this->attachPool(privatePool);
+	if (writeBackRunning) this->startWriteBack();
+	return true;
 }
 
 
+
 /**
-* @brief Allocates cache page from memory pool
+*
+*  @brief Sets page size and derived shift, mask and dirty sector size
+*  @param newPageSize - valid page size in bytes
+*
 */
-CachePage* CachedFileIO::allocatePage() {
+void CachedFileIO::applyPageSize(size_t newPageSize) {
+	this->pageSize = newPageSize;
+	this->pageMask = newPageSize - 1;
+	this->pageShift = 0;
+	while ((size_t(1) << pageShift) < newPageSize) pageShift++;
+	// dirty sectors bitmask is 64 bits
+	this->sectorSize = std::max(SECTOR_SIZE, newPageSize / 64);
+}
 
-	if (pageCounter >= maxPagesCount) return nullptr;
 
-	// Allocate memory for cache page
-	CachePage* newPage = &cachePageInfoPool[pageCounter];
-	// Clear cache page info fields
-	newPage->filePageNo = NOT_FOUND;
-	newPage->state = PageState::CLEAN;
-	newPage->availableDataLength = 0;
-	newPage->data = cachePageDataPool[pageCounter].data;
-	// Increment page counter
-	pageCounter++;
 
-	return newPage;
+/**
+* @brief Returns pool shard of the file page
+*/
+CacheShard& CachedFileIO::getShard(size_t filePageNo) {
+	return pool->getShard(getPageKey(fileId, filePageNo));
 }
 
 
 /**
-*
-* @brief Returns free page: allocates new or return most aged cache page if page limit reached
-* @return new allocated or most aged CachePage pointer
-*
+* @brief Returns file counters of the pool shard
 */
-CachePage* CachedFileIO::getFreeCachePage() {
-	if (cacheList.size() < maxPagesCount) {
-		return allocatePage();
-	} else {
-		// get most aged page (back of the list)
-		CachePage* freePage = this->cacheList.back();
-		// clear page state
-		clearCachePage(freePage);
-		// remove page from list's back
-		this->cacheList.pop_back();
-		// return page reference
-		return freePage;
-	}
+FileShard& CachedFileIO::getFileShard(CacheShard& shard) {
+	return fileShards[&shard - pool->shards];
 }
 
 
@@ -668,30 +1027,41 @@ CachePage* CachedFileIO::getFreeCachePage() {
 /**
 * 
 * @brief Lookup cache page of requested file page if it exists or loads from storage
+* (shard latch must be held by caller)
 * 
+* @param shard - cache shard of the file page
 * @param requestedFilePageNo - requested file page number
+* @param hint - access hint passed to replacement policy
+* @param fetch - if false, missing page is not read from storage (page is
+* overwritten by caller or located beyond the end of the file)
 * @return cache page reference of requested file page or returns nullptr
 * 
 */
-CachePage* CachedFileIO::searchPageInCache(size_t filePageNo) {
+CachePage* CachedFileIO::searchPageInCache(CacheShard& shard, size_t filePageNo, AccessHint hint, bool fetch) {
 	// increment total cache lookup requests
-	cacheRequests++;
+	FileShard& fileShard = getFileShard(shard);
+	fileShard.cacheRequests++;
 	// Search file page in index map
-	auto result = cacheMap.find(filePageNo);
+	auto result = shard.cacheMap.find(getPageKey(fileId, filePageNo));
 	// if page found in cache
-	if (result != cacheMap.end()) {               // Move page to the front of list (LRU):
-		CachePage* cachePage = result->second;    // 1) Get page pointer
-		cacheList.erase(cachePage->it);           // 2) Erase page from list by iterator
-		cacheList.push_front(cachePage);          // 3) Push page in the front of the list
-		cachePage->it = cacheList.begin();        // 4) update page's list iterator 
-		return cachePage;                         // 5) return page (hashmap pointer is valid)
+	if (result != shard.cacheMap.end()) {
+		CachePage* cachePage = result->second;    // Get page pointer
+		shard.policy->access(cachePage, hint);    // Notify replacement policy
+		if (cachePage->prefetched) {              // First request of prefetched page
+			cachePage->prefetched = false;
+			this->readAheadHits++;
+		}
+		return cachePage;                         // return page (hashmap pointer is valid)
 	}
 	
 	// increment cache misses counter
-	cacheMisses++;
+	fileShard.cacheMisses++;
+
+	// write miss that doesn't need storage data
+	if (!fetch) this->skippedFetches++;
 
 	// try to load page to cache from storage
-	return loadPageToCache(filePageNo);
+	return loadPageToCache(shard, filePageNo, hint, fetch);
 }
 
 
@@ -700,44 +1070,343 @@ CachePage* CachedFileIO::searchPageInCache(size_t filePageNo) {
 * 
 *  @brief Loads requested page from storage device to cache and returns cache page
 * 
+*  @param shard - cache shard of the file page
 *  @param requestedFilePageNo - file page number to load
-*  @return loaded page cache index or nullptr if file is not open.
+*  @param hint - access hint passed to replacement policy
+*  @param fetch - if false, page is cleared but not read from storage
+*  @return loaded page cache index or nullptr if all pages of the shard are pinned
 * 
 */
-CachePage* CachedFileIO::loadPageToCache(size_t filePageNo) {
-
-	//if (fileHandler == nullptr) return nullptr;
+CachePage* CachedFileIO::loadPageToCache(CacheShard& shard, size_t filePageNo, AccessHint hint, bool fetch) {
 
 	// get new allocated page or most aged one (remove it from the list)
-	CachePage* cachePage = getFreeCachePage();
+	CachePage* cachePage = pool->getFreeCachePage(shard);
+	if (cachePage == nullptr) return nullptr;
+	pagesLoaded = true;
 
 	// calculate offset and initialize variables
-	size_t offset = filePageNo * PAGE_SIZE;
-	size_t bytesToRead = PAGE_SIZE;	
+	size_t offset = filePageNo * pageSize;
+	size_t bytesToRead = pageSize;	
 	size_t bytesRead = 0;
 
 	// Clear page
-	memset(cachePage->data, 0, PAGE_SIZE);
+	memset(cachePage->data, 0, pageSize);
 
 	// Fetch page from storage device
-	_fseeki64(fileHandler, offset, SEEK_SET);
-	bytesRead = fread(cachePage->data, 1, bytesToRead, fileHandler);
+	if (fetch) {
+		AsyncBuffer buffer = { cachePage->data, bytesToRead };
+		bytesRead = device->read(offset, &buffer, 1);
+		this->storageBytesRead += bytesRead;
+	}
 	
 	// fill loaded page description info
 	cachePage->filePageNo = filePageNo;
+	cachePage->file = this;
+	cachePage->fileId = fileId;
 	cachePage->state = PageState::CLEAN;
+	cachePage->dirtySectors = 0;
 	cachePage->availableDataLength = bytesRead;
+	cachePage->prefetched = false;
 
-	// Insert cache page into the list and to the hashmap
-	cacheList.push_front(cachePage);
-	cachePage->it = cacheList.begin();
-	cacheMap[filePageNo] = cachePage;
+	// Insert cache page into the replacement policy and to the hashmap
+	shard.policy->insert(cachePage, hint);
+	shard.cacheMap[getPageKey(fileId, filePageNo)] = cachePage;
 
 	return cachePage;
 }
 
 
 
+/**
+*
+*  @brief Loads missing pages of file pages range to cache with one group read
+*  submission (or one read call per run of missing pages if group submission
+*  is not available). Consecutive missing pages are read by one request.
+*  Pages that can't be loaded this way are loaded later one by one.
+*
+*  @param firstPageNo - first file page number
+*  @param lastPageNo - last file page number
+*  @param hint - access hint passed to replacement policy
+*  @param loadType - pages are requested, prefetched by read-ahead (not
+*  requested yet) or restored by warm-up
+*
+*/
+void CachedFileIO::loadPagesToCache(size_t firstPageNo, size_t lastPageNo, AccessHint hint, PageLoadType loadType) {
+
+	// Group is limited to the pages run size
+	lastPageNo = std::min(lastPageNo, firstPageNo + MAX_RUN_PAGES - 1);
+
+	// Lock distinct shards of the range in ascending order
+	bool lockedShards[MAX_SHARDS] = { false };
+	for (size_t pageNo = firstPageNo; pageNo <= lastPageNo; pageNo++) {
+		lockedShards[pool->getShardIndex(getPageKey(fileId, pageNo))] = true;
+	}
+	std::unique_lock<std::mutex> shardLocks[MAX_SHARDS];
+	for (size_t i = 0; i < pool->shardsCount; i++) {
+		if (lockedShards[i]) shardLocks[i] = std::unique_lock<std::mutex>(pool->shards[i].latch);
+	}
+
+	// Take free cache pages for missing file pages and queue reads of runs.
+	// Pages are inserted to the cache only after data is read, so they can't
+	// be chosen as victims for other pages of the same group.
+	CachePage* loadingPages[MAX_RUN_PAGES] = { nullptr };
+	AsyncBuffer buffers[MAX_RUN_PAGES];
+	size_t runFirst[MAX_RUN_PAGES], runSize[MAX_RUN_PAGES];
+	size_t runsCount = 0, runStart = 0, runLength = 0;
+	for (size_t pageNo = firstPageNo; pageNo <= lastPageNo + 1; pageNo++) {
+		CachePage* cachePage = nullptr;
+		if (pageNo <= lastPageNo) {
+			CacheShard& shard = getShard(pageNo);
+			if (shard.cacheMap.find(getPageKey(fileId, pageNo)) == shard.cacheMap.end()) {
+				cachePage = pool->getFreeCachePage(shard);
+			}
+		}
+		if (cachePage != nullptr) {
+			size_t index = pageNo - firstPageNo;
+			memset(cachePage->data, 0, pageSize);
+			loadingPages[index] = cachePage;
+			buffers[index] = { cachePage->data, pageSize };
+			if (runLength == 0) runStart = index;
+			runLength++;
+		} else if (runLength > 0) {
+			runFirst[runsCount] = runStart;
+			runSize[runsCount] = runLength;
+			runsCount++;
+			runLength = 0;
+		}
+	}
+
+	// Submit all reads with one system call (request queue is guarded by file latch)
+	std::vector<int64_t> results(runsCount, -1);
+	if (runsCount > 0 && asyncIO.isAvailable()) {
+		std::lock_guard<std::mutex> fileLock(fileLatch);
+		for (size_t r = 0; r < runsCount; r++) {
+			asyncIO.queueRead((firstPageNo + runFirst[r]) * pageSize, &buffers[runFirst[r]], runSize[r]);
+		}
+		asyncIO.submit(results);
+		for (size_t r = 0; r < runsCount; r++) {
+			if (results[r] > 0) this->storageBytesRead += results[r];
+		}
+	} else if (runsCount > 0) {
+		// Read every run with one vectored read call
+		for (size_t r = 0; r < runsCount; r++) {
+			size_t bytesRead = device->read((firstPageNo + runFirst[r]) * pageSize, &buffers[runFirst[r]], runSize[r]);
+			results[r] = int64_t(bytesRead);
+			this->storageBytesRead += bytesRead;
+		}
+	}
+
+	// Insert loaded pages into replacement policy and hashmap
+	if (runsCount > 0) pagesLoaded = true;
+	for (size_t r = 0; r < runsCount; r++) {
+		int64_t bytesRead = results[r];
+		for (size_t index = runFirst[r]; index < runFirst[r] + runSize[r]; index++) {
+			CachePage* cachePage = loadingPages[index];
+			CacheShard& shard = getShard(firstPageNo + index);
+			int64_t pageBytes = 0;
+			if (bytesRead >= 0) {
+				int64_t pageOffset = int64_t(index - runFirst[r]) * pageSize;
+				pageBytes = std::min(std::max(bytesRead - pageOffset, int64_t(0)), int64_t(pageSize));
+			} else {
+				// group read failed, fetch page synchronously
+				pageBytes = int64_t(device->read((firstPageNo + index) * pageSize, &buffers[index], 1));
+				this->storageBytesRead += pageBytes;
+			}
+			cachePage->filePageNo = firstPageNo + index;
+			cachePage->file = this;
+			cachePage->fileId = fileId;
+			cachePage->state = PageState::CLEAN;
+			cachePage->dirtySectors = 0;
+			cachePage->availableDataLength = size_t(pageBytes);
+			cachePage->prefetched = (loadType == READ_AHEAD_LOAD);
+			shard.policy->insert(cachePage, hint);
+			shard.cacheMap[getPageKey(fileId, cachePage->filePageNo)] = cachePage;
+			if (loadType == READ_AHEAD_LOAD) {
+				this->readAheadPages++;
+			} else if (loadType == WARM_UP_LOAD) {
+				this->warmUpPages++;
+			} else {
+				getFileShard(shard).cacheMisses++;
+				this->batchedReadPages++;
+			}
+		}
+	}
+}
+
+
+/**
+*
+*  @brief Detects sequential access and prefetches next pages of the stream.
+*  Request continuing tracked stream (same or next page) or request with
+*  sequential hint starts read-ahead. When stream consumes half of prefetched
+*  window, next window is prefetched with one larger read and window grows
+*  up to READ_AHEAD_MAX pages. (shard latches must not be held by caller)
+*
+*  @param firstPageNo - first requested file page
+*  @param lastPageNo - last requested file page
+*  @param hint - access hint
+*
+*/
+void CachedFileIO::readAhead(size_t firstPageNo, size_t lastPageNo, AccessHint hint) {
+
+	if (!readAheadEnabled) return;
+
+	size_t prefetchFirst = 0, prefetchLast = 0;
+	{
+		// Skip detection rather than wait for other thread
+		std::unique_lock<std::mutex> lock(readAheadLatch, std::try_to_lock);
+		if (!lock.owns_lock()) return;
+
+		// Find stream continued by this request
+		ReadAheadStream* stream = nullptr;
+		for (size_t i = 0; i < READ_AHEAD_STREAMS; i++) {
+			ReadAheadStream& s = streams[i];
+			if (s.lastPageNo != NOT_FOUND && firstPageNo >= s.lastPageNo && firstPageNo <= s.lastPageNo + 1) {
+				stream = &s;
+				break;
+			}
+		}
+
+		if (stream == nullptr) {
+			// Start tracking new stream (random request unless sequential hint)
+			stream = &streams[streamsCursor++ % READ_AHEAD_STREAMS];
+			stream->lastPageNo = lastPageNo;
+			stream->prefetchEnd = lastPageNo + 1;
+			stream->window = 0;
+			if (hint != AccessHint::SEQUENTIAL) return;
+			stream->window = READ_AHEAD_MIN;
+		} else {
+			// Same page requested again
+			if (lastPageNo == stream->lastPageNo) return;
+			// Second adjacent request makes stream sequential
+			stream->lastPageNo = lastPageNo;
+			if (stream->window == 0) stream->window = READ_AHEAD_MIN;
+			if (stream->prefetchEnd <= lastPageNo) stream->prefetchEnd = lastPageNo + 1;
+			// Prefetched pages ahead of stream are enough
+			if (stream->prefetchEnd - lastPageNo - 1 > stream->window / 2) return;
+			// Stream consumed prefetched pages, grow window (limited by cache size)
+			if (stream->prefetchEnd > lastPageNo + 1) {
+				stream->window = std::min(stream->window * 2, std::max(READ_AHEAD_MIN, std::min(READ_AHEAD_MAX, pool->maxPagesCount / 4)));
+			}
+		}
+
+		prefetchFirst = stream->prefetchEnd;
+		prefetchLast = prefetchFirst + stream->window - 1;
+		stream->prefetchEnd = prefetchLast + 1;
+	}
+
+	// Do not prefetch pages beyond end of file
+	size_t fileSize = getFileSize();
+	if (prefetchFirst * pageSize >= fileSize) return;
+	prefetchLast = std::min(prefetchLast, (fileSize - 1) >> pageShift);
+
+	// Prefetch window with batched reads
+	for (size_t pageNo = prefetchFirst; pageNo <= prefetchLast; pageNo += MAX_RUN_PAGES) {
+		loadPagesToCache(pageNo, std::min(pageNo + MAX_RUN_PAGES - 1, prefetchLast), hint, READ_AHEAD_LOAD);
+	}
+}
+
+
+/**
+* @brief Clears sequential streams table
+*/
+void CachedFileIO::resetReadAhead() {
+	std::lock_guard<std::mutex> lock(readAheadLatch);
+	for (size_t i = 0; i < READ_AHEAD_STREAMS; i++) {
+		streams[i].lastPageNo = NOT_FOUND;
+		streams[i].prefetchEnd = 0;
+		streams[i].window = 0;
+	}
+	streamsCursor = 0;
+}
+
+
+
+
+/**
+*
+*  @brief Writes dirty ranges of runs of consecutive cache pages to the
+*  storage device. If group submission is available and more than one write
+*  call or staging copy is needed, all ranges are written with one group
+*  submission straight from cache pages. Otherwise every range is written
+*  with one write call. (shard latches of the pages held by caller)
+*
+*  @param pages - cache pages sorted by file page number
+*  @param runs - first page index and pages count (not more than MAX_RUN_PAGES)
+*  of every run
+*  @return true if all runs are persisted, false otherwise
+*
+*/
+bool CachedFileIO::persistCachePageRuns(CachePage** pages, std::vector<std::pair<size_t, size_t>>& runs) {
+
+	// Collect dirty byte ranges of every run
+	std::vector<std::vector<std::pair<size_t, size_t>>> runRanges(runs.size());
+	size_t rangesCount = 0;
+	bool multiPageRange = false;
+	for (size_t r = 0; r < runs.size(); r++) {
+		getDirtyRanges(&pages[runs[r].first], runs[r].second, runRanges[r]);
+		rangesCount += runRanges[r].size();
+		for (auto& range : runRanges[r]) {
+			if ((range.first >> pageShift) != ((range.first + range.second - 1) >> pageShift)) multiPageRange = true;
+		}
+	}
+
+	AsyncBuffer buffers[MAX_RUN_PAGES];
+	std::vector<int64_t> results(rangesCount, -1);
+
+	// Queue vectored write of every range and submit all writes
+	// (request queue is guarded by file latch)
+	if (asyncIO.isAvailable() && (rangesCount > 1 || multiPageRange)) {
+		std::lock_guard<std::mutex> fileLock(fileLatch);
+		for (size_t r = 0; r < runs.size(); r++) {
+			size_t runOffset = pages[runs[r].first]->filePageNo * pageSize;
+			for (auto& range : runRanges[r]) {
+				size_t buffersCount = getRangeBuffers(&pages[runs[r].first], range, buffers);
+				asyncIO.queueWrite(runOffset + range.first, buffers, buffersCount);
+			}
+		}
+		uint64_t submitCalls = asyncIO.getSubmitCalls();
+		asyncIO.submit(results);
+		this->storageWriteCalls += asyncIO.getSubmitCalls() - submitCalls;
+	}
+
+	// Write ranges synchronously if not submitted or failed
+	std::vector<bool> runPersisted(runs.size(), true);
+	size_t request = 0;
+	for (size_t r = 0; r < runs.size(); r++) {
+		size_t runOffset = pages[runs[r].first]->filePageNo * pageSize;
+		for (auto& range : runRanges[r]) {
+			int64_t bytesWritten = results[request++];
+			if (bytesWritten != int64_t(range.second)) {
+				size_t buffersCount = getRangeBuffers(&pages[runs[r].first], range, buffers);
+				bytesWritten = int64_t(device->write(runOffset + range.first, buffers, buffersCount));
+				this->storageWriteCalls++;
+			}
+			if (bytesWritten != int64_t(range.second)) {
+				runPersisted[r] = false;
+				continue;
+			}
+			this->storageBytesWritten += range.second;
+			growStorageSize(runOffset + range.first + range.second);
+		}
+	}
+
+	// Mark pages of persisted runs clean
+	bool allPersisted = true;
+	for (size_t r = 0; r < runs.size(); r++) {
+		if (!runPersisted[r]) {
+			allPersisted = false;
+			continue;
+		}
+		for (size_t i = runs[r].first; i < runs[r].first + runs[r].second; i++) {
+			markClean(getShard(pages[i]->filePageNo), pages[i]);
+		}
+	}
+	return allPersisted;
+}
+
+
+
 /**
 * 
 *  @brief Writes specified cache page to the storage device
@@ -747,55 +1416,564 @@ CachePage* CachedFileIO::loadPageToCache(size_t filePageNo) {
 * 
 */ 
 bool CachedFileIO::persistCachePage(CachePage* cachedPage) {
+	return persistCachePages(&cachedPage, 1);
+}
 
-	//if (fileHandler == nullptr) return false;
 
-	// Get file page number of cached page and calculate offset in the file
-	size_t offset = cachedPage->filePageNo * PAGE_SIZE;
-	size_t bytesToWrite = PAGE_SIZE;
-	size_t bytesWritten = 0;
-	
-	// Go to calculated offset in the file
-	_fseeki64(fileHandler, offset, SEEK_SET);
-
-	// Write cached page to file
-	bytesWritten = fwrite(cachedPage->data, 1, bytesToWrite, fileHandler);
-	// Check success
-	if (bytesWritten == bytesToWrite) {
-		cachedPage->state = PageState::CLEAN;
-		return true;
+
+/**
+*
+*  @brief Writes dirty ranges of run of cache pages of consecutive file pages
+*  to the storage device (shard latches of the pages held by caller)
+*
+*  @param cachedPages - cache pages of consecutive file pages
+*  @param count - pages count (not more than MAX_RUN_PAGES)
+*  @return true - pages successfuly persisted, false - write failed
+*
+*/
+bool CachedFileIO::persistCachePages(CachePage** cachedPages, size_t count) {
+	std::vector<std::pair<size_t, size_t>> runs(1, std::make_pair(size_t(0), count));
+	return persistCachePageRuns(cachedPages, runs);
+}
+
+
+
+/**
+*
+*  @brief Collects dirty byte ranges of run of cache pages. Dirty sectors are
+*  aligned to direct I/O alignment if file is open for direct I/O. Ranges
+*  separated by less than DIRTY_MERGE_GAP clean bytes are merged, because
+*  one larger write is cheaper than two small ones.
+*
+*  @param cachedPages - cache pages of consecutive file pages
+*  @param count - pages count
+*  @param ranges - offset from the first page start and length of every range
+*
+*/
+void CachedFileIO::getDirtyRanges(CachePage** cachedPages, size_t count, std::vector<std::pair<size_t, size_t>>& ranges) {
+	size_t unit = directIO ? std::max(IO_ALIGNMENT, sectorSize) : sectorSize;
+	size_t sectorsPerPage = pageSize / sectorSize;
+	ranges.clear();
+	for (size_t sector = 0; sector < count * sectorsPerPage; sector++) {
+		CachePage* cachePage = cachedPages[sector / sectorsPerPage];
+		if ((cachePage->dirtySectors & (1ull << (sector % sectorsPerPage))) == 0) continue;
+		size_t rangeStart = sector * sectorSize / unit * unit;
+		size_t rangeEnd = ((sector + 1) * sectorSize + unit - 1) / unit * unit;
+		if (!ranges.empty() && rangeStart <= ranges.back().first + ranges.back().second + DIRTY_MERGE_GAP) {
+			ranges.back().second = std::max(ranges.back().second, rangeEnd - ranges.back().first);
+		} else ranges.push_back(std::make_pair(rangeStart, rangeEnd - rangeStart));
 	}
-	// if failed to write
-	return false;
 }
 
 
 
 /**
-* 
-*  @brief Clears cache page state, persists if changed and removes from hashmap
-* 
-*  @param cachePageIndex - index of the page in cache to clear
-*  @return true - if page cleared, false - if can't persist page to storage
-* 
+*
+*  @brief Splits byte range of run of cache pages to buffers of pages data
+*
+*  @param cachedPages - cache pages of consecutive file pages
+*  @param range - offset from the first page start and length of range
+*  @param buffers - buffers of pages data (up to MAX_RUN_PAGES)
+*  @return buffers count
+*
 */
-bool CachedFileIO::clearCachePage(CachePage* pageInfo) {
-	
-	// if cache page has been rewritten persist page to storage device
-	if (pageInfo->state == PageState::DIRTY) {
-		if (!persistCachePage(pageInfo)) return false;
+size_t CachedFileIO::getRangeBuffers(CachePage** cachedPages, const std::pair<size_t, size_t>& range, AsyncBuffer* buffers) {
+	size_t buffersCount = 0;
+	size_t position = range.first, rangeEnd = range.first + range.second;
+	while (position < rangeEnd) {
+		size_t pageOffset = position & pageMask;
+		size_t length = std::min(pageSize - pageOffset, rangeEnd - position);
+		buffers[buffersCount++] = { &cachedPages[position >> pageShift]->data[pageOffset], length };
+		position += length;
 	}
+	return buffersCount;
+}
 
-	// Remove from index hashmap
-	cacheMap.erase(pageInfo->filePageNo);
 
-	// Clear cache page info fields
-	pageInfo->filePageNo = NOT_FOUND;
-	pageInfo->availableDataLength = 0;
-				
-	// Cache page freed
+
+/**
+*
+*  @brief Extends known file size on storage device after pages written
+*
+*  @param endOffset - end offset of written data
+*
+*/
+void CachedFileIO::growStorageSize(size_t endOffset) {
+	uint64_t size = storageSize;
+	while (endOffset > size && !storageSize.compare_exchange_weak(size, endOffset));
+}
+
+
+
+/**
+*
+*  @brief Marks cache page as "dirty" and wakes up write-back thread
+*  if shard dirty pages exceed high watermark (shard latch held by caller)
+*
+*  @param shard - cache shard of the page
+*  @param pageInfo - rewritten cache page
+*
+*/
+void CachedFileIO::markDirty(CacheShard& shard, CachePage* pageInfo, size_t offset, size_t length) {
+	size_t firstSector = offset / sectorSize;
+	size_t lastSector = (offset + length - 1) / sectorSize;
+	for (size_t sector = firstSector; sector <= lastSector; sector++) {
+		pageInfo->dirtySectors |= 1ull << sector;
+	}
+	if (pageInfo->state == PageState::DIRTY) return;
+	pageInfo->state = PageState::DIRTY;
+	shard.dirtyMap[getPageKey(fileId, pageInfo->filePageNo)] = pageInfo;
+	shard.dirtyPages++;
+	getFileShard(shard).dirtyPages++;
+	if (writeBackEnabled && shard.dirtyPages > shard.maxPagesCount * dirtyHighWatermark) {
+		writeBackSignal.notify_one();
+	}
+}
+
+
+
+/**
+*
+*  @brief Marks cache page as "clean" and removes it from dirty pages map
+*  (shard latch held by caller)
+*
+*  @param shard - cache shard of the page
+*  @param pageInfo - persisted cache page
+*
+*/
+void CachedFileIO::markClean(CacheShard& shard, CachePage* pageInfo) {
+	if (pageInfo->state == PageState::CLEAN) return;
+	pageInfo->state = PageState::CLEAN;
+	pageInfo->dirtySectors = 0;
+	shard.dirtyMap.erase(getPageKey(fileId, pageInfo->filePageNo));
+	shard.dirtyPages--;
+	getFileShard(shard).dirtyPages--;
+}
+
+
+
+//=============================================================================
+// 
+// 
+//                       Background write-back
+// 
+// 
+//=============================================================================
+
+/**
+*
+*  @brief Enables or disables group I/O submission (io_uring on Linux)
+*  (takes effect on next open)
+*
+*  @param enabled - true to submit multi-page reads and flush writes as group
+*
+*/
+void CachedFileIO::setAsyncIO(bool enabled) {
+	this->asyncEnabled = enabled;
+}
+
+
+/**
+* @brief Checks if group I/O submission is used for the open file
+* @return true if io_uring is set up for the file, false otherwise
+*/
+bool CachedFileIO::isAsyncIO() {
+	return asyncIO.isAvailable();
+}
+
+
+/**
+*
+*  @brief Enables or disables direct I/O bypassing OS page cache
+*  (takes effect on next open, not supported by some platforms and file systems)
+*
+*  @param enabled - true to open file for direct I/O
+*
+*/
+void CachedFileIO::setDirectIO(bool enabled) {
+	this->directEnabled = enabled;
+}
+
+
+/**
+* @brief Checks if file is open for direct I/O
+* @return true if OS page cache is bypassed, false otherwise
+*/
+bool CachedFileIO::isDirectIO() {
+	return directIO;
+}
+
+
+/**
+*
+*  @brief Sets storage device of the file: memory device for in-memory
+*  database, simulated device to model storage latency (file must be
+*  closed, device must outlive the open file)
+*
+*  @param storageDevice - storage device (nullptr sets default OS file device)
+*  @return true if device is set, false if file is open
+*
+*/
+bool CachedFileIO::setStorageDevice(StorageDevice* storageDevice) {
+	if (device->isOpen()) return false;
+	this->device = (storageDevice == nullptr) ? &fileDevice : storageDevice;
 	return true;
 }
 
 
+/**
+* @brief Returns storage device of the file
+*/
+StorageDevice* CachedFileIO::getStorageDevice() {
+	return device;
+}
 
+
+/**
+*
+*  @brief Enables or disables huge pages backed pages pool
+*  (takes effect on next pool allocation: open or setCacheSize)
+*
+*  @param enabled - true to back pages pool with 2Mb huge pages
+*
+*/
+void CachedFileIO::setHugePages(bool enabled) {
+	privatePool.setHugePages(enabled);
+}
+
+
+/**
+* @brief Checks if pages pool is mapped to explicit huge pages
+* @return true if pool is backed by huge pages, false otherwise
+*/
+bool CachedFileIO::isHugePages() {
+	return pool->isHugePages();
+}
+
+
+/**
+*
+*  @brief Enables or disables sequential read-ahead
+*
+*  @param enabled - true to prefetch next pages of sequential streams
+*
+*/
+void CachedFileIO::setReadAhead(bool enabled) {
+	this->readAheadEnabled = enabled;
+	this->resetReadAhead();
+}
+
+
+/**
+*
+*  @brief Enables or disables cache warm-up: resident pages are saved to
+*  manifest file (file path + ".warm") on close and restored on next open
+*  (must be called before open, read only files don't save manifest)
+*
+*  @param enabled - true to save and restore resident pages
+*  @param background - true to restore pages by background thread, false
+*  to restore them before open returns
+*
+*/
+void CachedFileIO::setWarmUp(bool enabled, bool background) {
+	this->warmUpEnabled = enabled;
+	this->warmUpBackground = background;
+}
+
+
+/**
+* @brief Checks if background warm-up is still restoring pages
+*/
+bool CachedFileIO::isWarmingUp() {
+	return warmUpThread.joinable() && warmUpRestored < warmUpManifest.size();
+}
+
+
+/**
+*
+*  @brief Enables or disables background write-back of dirty pages
+*  (must not be called concurrently with other operations)
+*
+*  @param enabled - true to start write-back thread, false to stop it
+*  @param highWatermark - shard dirty pages share that wakes up write-back (0-1)
+*  @param lowWatermark - shard dirty pages share write-back stops at (0-1)
+*
+*/
+void CachedFileIO::setWriteBack(bool enabled, double highWatermark, double lowWatermark) {
+	this->stopWriteBack();
+	this->writeBackEnabled = enabled;
+	this->dirtyHighWatermark = std::min(std::max(highWatermark, 0.0), 1.0);
+	this->dirtyLowWatermark = std::min(std::max(lowWatermark, 0.0), dirtyHighWatermark);
+	if (enabled && device->isOpen() && !readOnly) this->startWriteBack();
+}
+
+
+/**
+* @brief Starts write-back thread
+*/
+void CachedFileIO::startWriteBack() {
+	if (writeBackThread.joinable()) return;
+	writeBackStop = false;
+	writeBackThread = std::thread(&CachedFileIO::writeBackLoop, this);
+}
+
+
+/**
+* @brief Stops write-back thread and waits for it to finish
+*/
+void CachedFileIO::stopWriteBack() {
+	if (!writeBackThread.joinable()) return;
+	std::unique_lock<std::mutex> lock(writeBackLatch);
+	writeBackStop = true;
+	lock.unlock();
+	writeBackSignal.notify_one();
+	writeBackThread.join();
+}
+
+
+/**
+* @brief Checks if dirty pages of any shard holding dirty pages of the file
+* exceed high watermark
+*/
+bool CachedFileIO::isAboveHighWatermark() {
+	for (size_t i = 0; i < pool->shardsCount; i++) {
+		CacheShard& shard = pool->shards[i];
+		if (fileShards[i].dirtyPages > 0 && shard.dirtyPages > shard.maxPagesCount * dirtyHighWatermark) return true;
+	}
+	return false;
+}
+
+
+/**
+* @brief Write-back thread: sleeps until dirty pages exceed high watermark
+* or wake up interval elapses, then writes back dirty pages
+*/
+void CachedFileIO::writeBackLoop() {
+	std::unique_lock<std::mutex> lock(writeBackLatch);
+	while (!writeBackStop) {
+		writeBackSignal.wait_for(lock, std::chrono::milliseconds(WRITEBACK_MS), [this]() {
+			return writeBackStop || isAboveHighWatermark();
+		});
+		if (writeBackStop) break;
+		lock.unlock();
+		writeBackDirtyPages();
+		lock.lock();
+	}
+}
+
+
+/**
+*
+*  @brief Persists dirty pages of shards above high watermark until they
+*  reach low watermark. Pages are written in file offset order, every shard
+*  continues from the page where previous write-back stopped, so all dirty
+*  pages get their turn and shard pages are locked only while written.
+*
+*/
+void CachedFileIO::writeBackDirtyPages() {
+
+	std::vector<uint64_t> pagesToWrite;
+
+	// Collect excess of dirty pages of every shard above high watermark
+	// (shared pool shard may hold dirty pages of other files)
+	for (size_t i = 0; i < pool->shardsCount; i++) {
+		CacheShard& shard = pool->shards[i];
+		FileShard& fileShard = fileShards[i];
+		std::lock_guard<std::mutex> lock(shard.latch);
+		uint64_t highLimit = uint64_t(shard.maxPagesCount * dirtyHighWatermark);
+		uint64_t lowLimit = uint64_t(shard.maxPagesCount * dirtyLowWatermark);
+		if (shard.dirtyMap.size() <= highLimit || fileShard.dirtyPages == 0) continue;
+		// Start from write-back cursor and wrap around pages of the file
+		size_t excess = std::min(size_t(shard.dirtyMap.size() - lowLimit), size_t(fileShard.dirtyPages));
+		std::vector<uint64_t> dirtyPages;
+		auto first = shard.dirtyMap.lower_bound(getPageKey(fileId, 0));
+		auto last = shard.dirtyMap.upper_bound(getPageKey(fileId, MAX_FILE_PAGE));
+		auto cursor = shard.dirtyMap.lower_bound(getPageKey(fileId, fileShard.writeBackCursor));
+		while (dirtyPages.size() < excess) {
+			if (cursor == last) cursor = first;
+			dirtyPages.push_back(cursor->second->filePageNo);
+			cursor++;
+		}
+		fileShard.writeBackCursor = dirtyPages.back() + 1;
+		pagesToWrite.insert(pagesToWrite.end(), dirtyPages.begin(), dirtyPages.end());
+	}
+
+	// Write runs of consecutive pages in file offset order. Pages of the run
+	// belong to different shards, shards are locked in ascending order.
+	std::sort(pagesToWrite.begin(), pagesToWrite.end());
+	size_t maxRunLength = std::min(MAX_RUN_PAGES, pool->shardsCount);
+	size_t runStart = 0;
+	for (size_t i = 1; i <= pagesToWrite.size(); i++) {
+		if (i < pagesToWrite.size() &&
+			i - runStart < maxRunLength &&
+			pagesToWrite[i] == pagesToWrite[i - 1] + 1) continue;
+		// Lock shards of the run
+		std::vector<size_t> shardIndices;
+		for (size_t j = runStart; j < i; j++) shardIndices.push_back(pool->getShardIndex(getPageKey(fileId, pagesToWrite[j])));
+		std::sort(shardIndices.begin(), shardIndices.end());
+		std::vector<std::unique_lock<std::mutex>> locks;
+		for (size_t shardIndex : shardIndices) locks.emplace_back(pool->shards[shardIndex].latch);
+		// Persist pages of the run that are still cached and dirty
+		std::vector<CachePage*> run;
+		for (size_t j = runStart; j <= i; j++) {
+			CachePage* cachePage = nullptr;
+			if (j < i) {
+				CacheShard& shard = getShard(pagesToWrite[j]);
+				auto result = shard.cacheMap.find(getPageKey(fileId, pagesToWrite[j]));
+				if (result != shard.cacheMap.end() && result->second->state == PageState::DIRTY) {
+					cachePage = result->second;
+				}
+			}
+			if (cachePage != nullptr) {
+				run.push_back(cachePage);
+				continue;
+			}
+			if (!run.empty() && persistCachePages(run.data(), run.size())) writeBackPages += run.size();
+			run.clear();
+		}
+		runStart = i;
+	}
+}
+
+
+
+/**
+*
+*  @brief Writes resident pages of the file to warm-up manifest. Pages of
+*  every shard are listed by replacement policy from the hottest to the
+*  coldest, shards are interleaved, so manifest starts with hottest pages.
+*
+*  @return true if manifest is written, false otherwise
+*
+*/
+bool CachedFileIO::saveWarmUpManifest() {
+	// Collect resident pages of the file in recency order of every shard
+	std::vector<std::vector<uint64_t>> shardPages(pool->shardsCount);
+	std::vector<CachePage*> resident;
+	size_t pagesCount = 0;
+	for (size_t i = 0; i < pool->shardsCount; i++) {
+		CacheShard& shard = pool->shards[i];
+		std::lock_guard<std::mutex> lock(shard.latch);
+		resident.clear();
+		shard.policy->getResidentPages(resident);
+		for (CachePage* cachePage : resident) {
+			if (cachePage->file == this && cachePage->fileId == fileId) {
+				shardPages[i].push_back(cachePage->filePageNo);
+			}
+		}
+		pagesCount += shardPages[i].size();
+	}
+
+	// Interleave shards by rank of the page in its shard
+	std::vector<uint64_t> manifest;
+	manifest.reserve(pagesCount);
+	for (size_t rank = 0; manifest.size() < pagesCount; rank++) {
+		for (std::vector<uint64_t>& pages : shardPages) {
+			if (rank < pages.size()) manifest.push_back(pages[rank]);
+		}
+	}
+
+	// Write header and page numbers
+	std::FILE* manifestFile = std::fopen(warmUpPath.c_str(), "wb");
+	if (manifestFile == nullptr) return false;
+	WarmUpHeader header = { WARM_UP_SIGNATURE, uint32_t(pageSize), manifest.size() };
+	bool written = (fwrite(&header, sizeof(WarmUpHeader), 1, manifestFile) == 1);
+	if (written && !manifest.empty()) {
+		written = (fwrite(manifest.data(), sizeof(uint64_t), manifest.size(), manifestFile) == manifest.size());
+	}
+	fclose(manifestFile);
+	if (!written) std::remove(warmUpPath.c_str());
+	return written;
+}
+
+
+
+/**
+*
+*  @brief Reads warm-up manifest of the file. Manifest is ignored if it was
+*  written for another page size, pages beyond cache capacity and beyond
+*  the end of the file are skipped (manifest is only a hint of what to load).
+*
+*  @return true if there are pages to restore, false otherwise
+*
+*/
+bool CachedFileIO::loadWarmUpManifest() {
+	warmUpManifest.clear();
+	std::FILE* manifestFile = std::fopen(warmUpPath.c_str(), "rb");
+	if (manifestFile == nullptr) return false;
+	WarmUpHeader header = {};
+	if (fread(&header, sizeof(WarmUpHeader), 1, manifestFile) == 1 &&
+		header.signature == WARM_UP_SIGNATURE &&
+		header.pageSize == pageSize) {
+		// Restore not more pages than cache can hold
+		size_t pagesCount = std::min(header.pagesCount, uint64_t(pool->maxPagesCount));
+		warmUpManifest.resize(pagesCount);
+		if (pagesCount > 0) pagesCount = fread(warmUpManifest.data(), sizeof(uint64_t), pagesCount, manifestFile);
+		warmUpManifest.resize(pagesCount);
+	}
+	fclose(manifestFile);
+	// Skip pages beyond the end of the file
+	uint64_t filePages = (storageSize + pageMask) >> pageShift;
+	auto last = std::remove_if(warmUpManifest.begin(), warmUpManifest.end(),
+		[filePages](uint64_t pageNo) { return pageNo >= filePages; });
+	warmUpManifest.erase(last, warmUpManifest.end());
+	return !warmUpManifest.empty();
+}
+
+
+
+/**
+* @brief Reads warm-up manifest and restores its pages by background thread
+* or on the caller's thread
+*/
+void CachedFileIO::startWarmUp() {
+	this->warmUpStop = false;
+	this->warmUpRestored = 0;
+	this->warmUpPages = 0;
+	this->warmUpDuration = 0;
+	if (!loadWarmUpManifest()) return;
+	if (warmUpBackground) warmUpThread = std::thread(&CachedFileIO::warmUpLoop, this);
+	else warmUpLoop();
+}
+
+
+
+/**
+* @brief Stops warm-up thread and waits for it to finish
+*/
+void CachedFileIO::stopWarmUp() {
+	if (!warmUpThread.joinable()) return;
+	this->warmUpStop = true;
+	warmUpThread.join();
+}
+
+
+
+/**
+*
+*  @brief Restores manifest pages hottest first by batches. Batch is sorted
+*  by page number and consecutive pages are loaded with one read, pages
+*  cached meanwhile by requests are skipped. Warm-up loads are not counted
+*  as cache misses.
+*
+*/
+void CachedFileIO::warmUpLoop() {
+	uint64_t startTime = getTimeNs();
+	std::vector<uint64_t> batch;
+	for (size_t first = 0; first < warmUpManifest.size() && !warmUpStop; first += WARM_UP_BATCH) {
+		size_t last = std::min(first + WARM_UP_BATCH, warmUpManifest.size());
+		batch.assign(warmUpManifest.begin() + first, warmUpManifest.begin() + last);
+		std::sort(batch.begin(), batch.end());
+		// Load runs of consecutive pages of the batch
+		size_t runStart = 0;
+		for (size_t i = 1; i <= batch.size() && !warmUpStop; i++) {
+			if (i < batch.size() &&
+				i - runStart < MAX_RUN_PAGES &&
+				batch[i] == batch[i - 1] + 1) continue;
+			loadPagesToCache(batch[runStart], batch[i - 1], AccessHint::NORMAL, WARM_UP_LOAD);
+			runStart = i;
+		}
+		this->warmUpDuration = getTimeNs() - startTime;
+		if (!warmUpStop) this->warmUpRestored = last;
+	}
+}
@@ -15,6 +15,66 @@
 *    - O(1) time complexity of page look up
 *    - O(1) time complexity of page insert
 *    - O(1) time complexity of page remove
+*
+*  Replacement policy is selectable on open: LRU (default), CLOCK,
+*  CLOCK-Pro or 2Q. CLOCK policies only set reference bit on cache hit.
+*  Read operations accept access hint: pages of sequential scan are not
+*  promoted by replacement policies and are evicted first.
+*
+*  Data within one page can be accessed without copying through pinned
+*  page handle (PinnedPage), pinned pages are not evicted until released.
+*
+*  Cache is split into shards by file page number. Each shard has its own
+*  hashmap, replacement policy and latch, so read/write operations are
+*  thread safe and threads accessing different shards do not block each
+*  other.
+*
+*  Cache pages are drawn from pages pool (BufferPool). File owns private
+*  pool by default, or files of the process may share one pool: pages of
+*  all files are keyed by (file id, page number) and compete for pool
+*  memory under one replacement policy (see BufferPool.h).
+*
+*  CachedFileIO implements FileIO storage interface (see FileIO.h).
+*
+*  Sequential access (stream of adjacent pages or sequential hint) is
+*  detected and next pages are prefetched with one larger read, read-ahead
+*  window grows while stream continues.
+*
+*  Optional direct I/O mode bypasses OS page cache, so file pages are not
+*  buffered twice. Pages pool is aligned for direct I/O and can be backed
+*  by 2Mb huge pages to reduce TLB misses.
+*
+*  Optional background write-back thread persists dirty pages in file
+*  offset order when shard dirty pages exceed high watermark, so cache
+*  misses rarely have to write dirty victim page on the caller's thread.
+*
+*  Page size is set at runtime (power of 2 from 4Kb to 64Kb, 8Kb default),
+*  so page number and page offset are calculated with shift and mask.
+*
+*  Dirty pages track written sectors (512 bytes, 1/64 of larger pages),
+*  only dirty sectors are written to storage device (nearby dirty ranges
+*  are merged).
+*
+*  Write misses of pages fully overwritten or located beyond the end of
+*  the file on storage don't fetch pages from storage device before write.
+*
+*  Pages pool consists of segments (4Mb), so cache is resized online
+*  keeping resident pages: growing adds segments, shrinking evicts the
+*  coldest pages down to the new capacity, moves pages of the released
+*  segments to free pages and returns memory of these segments to OS.
+*
+*  Only sampled read/write operations are timed (see IOStats.h), latency
+*  histograms of cache hits, misses, dirty evictions and flushes are
+*  reported with other counters by structured stats snapshot.
+*
+*  Optional cache warm-up writes resident page numbers in recency order to
+*  sidecar manifest file on close. On open pages of the manifest are
+*  restored (in background thread by default) hottest first, every batch
+*  is sorted by page number and read with batched sequential reads.
+*
+*  Pages are stored on storage device (see StorageDevice.h): OS file by
+*  default, growable memory (in-memory database) or latency simulating
+*  device, selected before open.
 * 
 *  CachedFileIO vs STDIO performance tests (Release Mode):
 *    - 50%-97% cache read hits leads to 50%-600% performance growth
@@ -31,116 +91,214 @@
 #include <cstring>
 #include <cstdint>
 #include <unordered_map>
+#include <map>
+#include <vector>
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 #include <iostream>
+#include <string>
+
+#include "FileIO.h"
+#include "CachePolicy.h"
+#include "BufferPool.h"
+#include "AsyncIO.h"
+#include "StorageDevice.h"
 
 namespace Boson {
 
 	//-------------------------------------------------------------------------
-	constexpr uint64_t PAGE_SIZE      = 8192;         // 8192 bytes page size
-	constexpr uint64_t MINIMAL_CACHE  = 256 * 1024;   // 256Kb minimal cache
-	constexpr uint64_t DEFAULT_CACHE  = 1*1024*1024;  // 1Mb default cache
-	constexpr uint64_t NOT_FOUND      = -1;           // "Not found" signature
+	constexpr double   DIRTY_HIGH     = 0.25;         // Default dirty pages high watermark
+	constexpr double   DIRTY_LOW      = 0.10;         // Default dirty pages low watermark
+	constexpr uint64_t WRITEBACK_MS   = 100;          // Write-back thread wake up interval
+	constexpr uint64_t MAX_RUN_PAGES  = 32;           // Maximum pages written by one call
+	constexpr uint64_t READ_AHEAD_STREAMS = 8;        // Tracked sequential streams
+	constexpr uint64_t READ_AHEAD_MIN = 4;            // Initial read-ahead window (pages)
+	constexpr uint64_t READ_AHEAD_MAX = 64;           // Maximum read-ahead window (pages)
+	constexpr uint64_t SECTOR_SIZE    = 512;          // Minimal dirty tracking sector size
+	constexpr uint64_t DIRTY_MERGE_GAP = 2048;        // Clean bytes written to merge dirty ranges
+	constexpr uint64_t WARM_UP_BATCH  = 1024;         // Manifest pages restored per sorted batch
+	constexpr uint32_t WARM_UP_SIGNATURE = 0x4D525742; // BWRM warm-up manifest signature
+	constexpr const char* WARM_UP_SUFFIX = ".warm";   // Warm-up manifest file name suffix
 	//-------------------------------------------------------------------------
 
-	typedef enum {                              // Cache Page State
-		CLEAN = 0,                              // Page has not been changed
-		DIRTY = 1                               // Cache page is rewritten
-	} PageState;
+	static_assert(MAX_RUN_PAGES <= MAX_DEVICE_BUFFERS, "Pages run must fit one device call");
 
-	typedef struct {
-		uint8_t data[PAGE_SIZE];
-	} CachePageData;
+	typedef struct {                            // Sequential read stream
+		uint64_t  lastPageNo;                   // Last requested file page
+		uint64_t  prefetchEnd;                  // First file page not prefetched
+		uint64_t  window;                       // Read-ahead window (pages)
+	} ReadAheadStream;
 
-	class alignas(64) CachePage {               // Align to CPU cache line
-	public:
-		uint64_t  filePageNo;                   // Page number in file
-		PageState state;                        // Current page state
-		uint64_t  availableDataLength;          // Available amount of data
-		uint8_t*  data;                         // Pointer to data (payload)
-		std::list<CachePage*>::iterator it;     // Cache list node iterator
-	};
-
-	//-------------------------------------------------------------------------
-
-	typedef                                     // Double linked list
-		std::list<CachePage*>                   // of cached pages pointers
-		CacheLinkedList;
-
-	typedef                                     // Hashmap of cached pages
-		std::unordered_map<size_t, CachePage*>  // File page No. -> CachePage*           
-		CachedPagesMap;                         
-
-	//-------------------------------------------------------------------------
+	typedef enum {                              // Reason of batched pages load
+		DEMAND_LOAD = 0,                        // Pages requested by caller
+		READ_AHEAD_LOAD = 1,                    // Pages prefetched by read-ahead
+		WARM_UP_LOAD = 2                        // Pages restored from warm-up manifest
+	} PageLoadType;
 
-	typedef enum {                              // CachedFileIO stats types
-		TOTAL_REQUESTS,                         // Total requests to cache
-		TOTAL_CACHE_MISSES,                     // Total number of cache misses
-		TOTAL_CACHE_HITS,                       // Total number of cache hits
-		TOTAL_BYTES_WRITTEN,                    // Total bytes written
-		TOTAL_BYTES_READ,		                // Total bytes read
-		TOTAL_WRITE_TIME_NS,                    // Total write time (ns)
-		TOTAL_READ_TIME_NS,                     // Total read time (ns)
-		CACHE_HITS_RATE,                        // Cache hits rate (0-100%)
-		CACHE_MISSES_RATE,                      // Cache misses rate (0-100%)
-		WRITE_THROUGHPUT,                       // Write throughput Mb/sec
-		READ_THROUGHPUT                         // Read throughput Mb/sec
-	} CachedFileStats;
+	typedef struct {                            // Warm-up manifest header
+		uint32_t  signature;                    // BWRM signature
+		uint32_t  pageSize;                     // Page size of page numbers
+		uint64_t  pagesCount;                   // Page numbers count (hottest first)
+	} WarmUpHeader;
 
+	class alignas(64) FileShard {               // File counters of pool shard (shard latch)
+	public:
+		uint64_t        cacheRequests;          // Cache requests counter
+		uint64_t        cacheMisses;            // Cache misses counter
+		std::atomic<uint64_t> dirtyPages;       // Dirty pages of the file (read without latch)
+		uint64_t        writeBackCursor;        // Next file page to write back
+	};
 
 	//-------------------------------------------------------------------------
 	// Binary random access LRU cached file IO
 	//-------------------------------------------------------------------------
-	class CachedFileIO {
+	class CachedFileIO : public FileIO {
+		friend class PinnedPage;
+		friend class BufferPool;
 	public:
 		CachedFileIO();
 		CachedFileIO(const CachedFileIO&) = delete;
 		void operator=(const CachedFileIO&) = delete;
 		~CachedFileIO();
 		
-		bool open(const char* path, size_t cache = DEFAULT_CACHE, bool readOnly = false);
+		bool open(const char* path, size_t cache = DEFAULT_CACHE, bool readOnly = false, CachePolicyType policy = CachePolicyType::LRU);
+		bool open(const char* path, BufferPool& sharedPool, bool readOnly = false);
 		bool close();
 		bool isOpen();
 		bool isReadOnly();
 
-		size_t read(size_t position, void* dataBuffer, size_t length);
+		size_t read(size_t position, void* dataBuffer, size_t length, AccessHint hint = AccessHint::NORMAL);
 		size_t write(size_t position, const void* dataBuffer, size_t length);
-		size_t readPage(size_t pageNo, void* userPageBuffer);
+		size_t readPage(size_t pageNo, void* userPageBuffer, AccessHint hint = AccessHint::NORMAL);
 		size_t writePage(size_t pageNo, const void* userPageBuffer);
 		size_t flush();
 
+		PinnedPage pin(size_t position, size_t length, AccessHint hint = AccessHint::NORMAL);
+		PinnedPage pinPage(size_t pageNo, AccessHint hint = AccessHint::NORMAL);
+
 		void   resetStats();
-		double getStats(CachedFileStats type);
+		void   getStatsSnapshot(FileIOStats& stats);
 		size_t getFileSize();
+		bool   truncate(size_t size);
 		size_t getCacheSize();
 		size_t setCacheSize(size_t cacheSize);
+		size_t getPageSize();
+		bool   setPageSize(size_t pageSize);
+		void   setWriteBack(bool enabled, double highWatermark = DIRTY_HIGH, double lowWatermark = DIRTY_LOW);
+		void   setAsyncIO(bool enabled);
+		bool   isAsyncIO();
+		void   setDirectIO(bool enabled);
+		bool   isDirectIO();
+		bool   setStorageDevice(StorageDevice* storageDevice);
+		StorageDevice* getStorageDevice();
+		void   setHugePages(bool enabled);
+		bool   isHugePages();
+		void   setReadAhead(bool enabled);
+		void   setWarmUp(bool enabled, bool background = true);
+		bool   isWarmingUp();
 
 	private:
 
-		void       allocatePool(size_t pagesCount);
-		void       releasePool();
-		CachePage* allocatePage();
-		CachePage* getFreeCachePage();                            
-		CachePage* searchPageInCache(size_t filePageNo);
-		CachePage* loadPageToCache(size_t filePageNo);
+		void       applyPageSize(size_t newPageSize);
+		bool       openFile(const char* path, bool isReadOnly);
+		void       closeFile();
+		void       attachPool(BufferPool& bufferPool);
+		void       detachPool();
+		CacheShard& getShard(size_t filePageNo);
+		FileShard& getFileShard(CacheShard& shard);
+		CachePage* searchPageInCache(CacheShard& shard, size_t filePageNo, AccessHint hint = AccessHint::NORMAL, bool fetch = true);
+		CachePage* loadPageToCache(CacheShard& shard, size_t filePageNo, AccessHint hint, bool fetch = true);
+		void       loadPagesToCache(size_t firstPageNo, size_t lastPageNo, AccessHint hint, PageLoadType loadType = DEMAND_LOAD);
+		void       readAhead(size_t firstPageNo, size_t lastPageNo, AccessHint hint);
+		void       resetReadAhead();
 		bool       persistCachePage(CachePage* pageInfo);
-		bool       clearCachePage(CachePage* pageInfo);		
+		bool       persistCachePages(CachePage** cachedPages, size_t count);
+		bool       persistCachePageRuns(CachePage** pages, std::vector<std::pair<size_t, size_t>>& runs);
+		void       getDirtyRanges(CachePage** cachedPages, size_t count, std::vector<std::pair<size_t, size_t>>& ranges);
+		size_t     getRangeBuffers(CachePage** cachedPages, const std::pair<size_t, size_t>& range, AsyncBuffer* buffers);
+		void       growStorageSize(size_t endOffset);
+		void       unpin(CachePage* pageInfo);
+		void       markDirty(CacheShard& shard, CachePage* pageInfo, size_t offset, size_t length);
+		void       markClean(CacheShard& shard, CachePage* pageInfo);
+		bool       isAboveHighWatermark();
+		void       startWriteBack();
+		void       stopWriteBack();
+		void       writeBackLoop();
+		void       writeBackDirtyPages();
+		void       recordLatency(const LatencyTimer& timer, std::atomic<uint64_t>& totalDuration);
+		bool       saveWarmUpManifest();
+		bool       loadWarmUpManifest();
+		void       startWarmUp();
+		void       stopWarmUp();
+		void       warmUpLoop();
 				
-		uint64_t        maxPagesCount;           // Maximum cache capacity (pages)
-		uint64_t        pageCounter;             // Allocated pages counter
+		size_t          pageSize;                // Page size (power of 2)
+		size_t          pageShift;               // log2(pageSize): page number = offset >> pageShift
+		size_t          pageMask;                // pageSize - 1: page offset = offset & pageMask
+		size_t          sectorSize;              // Dirty tracking sector size
 				
-		uint64_t        totalBytesRead;          // Total bytes read
-		uint64_t        totalBytesWritten;       // Total bytes written
-		uint64_t        totalReadDuration;       // Time of read operations (ns)
-		uint64_t        totalWriteDuration;      // Time of write operations (ns)
-		uint64_t        cacheRequests;           // Cache requests counter
-		uint64_t        cacheMisses;             // Cache misses counter
-
-		std::FILE*      fileHandler;             // OS file handler
+		std::atomic<uint64_t> totalBytesRead;    // Total bytes read
+		std::atomic<uint64_t> totalBytesWritten; // Total bytes written
+		std::atomic<uint64_t> totalBytesPinned;  // Total bytes accessed by pins
+		std::atomic<uint64_t> totalReadDuration; // Time of read operations (ns, estimated)
+		std::atomic<uint64_t> totalWriteDuration;// Time of write operations (ns, estimated)
+		std::atomic<uint64_t> dirtyEvictions;    // Dirty pages persisted on eviction
+		std::atomic<uint64_t> writeBackPages;    // Dirty pages persisted by write-back
+		std::atomic<uint64_t> totalFlushes;      // Flush calls
+		std::atomic<uint64_t> flushWriteCalls;   // Storage write calls made by flushes
+		std::atomic<uint64_t> flushBytesWritten; // Bytes written by flushes
+		std::atomic<uint64_t> batchedReadPages;  // Pages loaded by batched reads
+		std::atomic<uint64_t> readAheadPages;    // Pages prefetched by read-ahead
+		std::atomic<uint64_t> readAheadHits;     // Prefetched pages requested later
+		std::atomic<uint64_t> readAheadWasted;   // Prefetched pages evicted unused
+		std::atomic<uint64_t> storageBytesRead;  // Bytes read from storage device
+		std::atomic<uint64_t> skippedFetches;    // Write misses served without storage read
+		std::atomic<uint64_t> storageWriteCalls; // Storage write calls
+		std::atomic<uint64_t> storageBytesWritten;// Bytes written to storage device
+		LatencyHistogram hitLatency;             // Sampled operations served from cache
+		LatencyHistogram missLatency;            // Sampled operations that loaded pages
+		LatencyHistogram evictionLatency;        // Dirty victim page writes
+		LatencyHistogram flushLatency;           // Flush calls
+
+		FileDevice      fileDevice;              // OS file device (default)
+		StorageDevice*  device;                  // Storage device (OS file, memory, simulated)
+		std::mutex      fileLatch;               // Group I/O queue latch
+		std::atomic<uint64_t> storageSize;       // File size on storage device
 		bool            readOnly;                // Read only flag
-		CachedPagesMap  cacheMap;                // Cached pages map 
-		CacheLinkedList cacheList;               // Cached pages double linked list
-		CachePage*      cachePageInfoPool;       // Cache pages info memory pool
-		CachePageData*  cachePageDataPool;       // Cache pages data memory pool
+		BufferPool      privatePool;             // Private pages pool of the file
+		BufferPool*     pool;                    // Pages pool (private or shared)
+		uint32_t        fileId;                  // File id of page keys in the pool
+		FileShard       fileShards[MAX_SHARDS];  // File counters of pool shards
+		AsyncIO         asyncIO;                 // Group I/O submission (file latch)
+		bool            asyncEnabled;            // Group I/O submission is enabled
+		bool            directEnabled;           // Direct I/O (bypass OS page cache) is enabled
+		bool            directIO;                // File is open for direct I/O
+
+		bool            readAheadEnabled;        // Sequential read-ahead is enabled
+		ReadAheadStream streams[READ_AHEAD_STREAMS]; // Sequential streams table
+		uint64_t        streamsCursor;           // Next stream entry to replace
+		std::mutex      readAheadLatch;          // Streams table latch
+
+		bool            writeBackEnabled;        // Background write-back is enabled
+		bool            writeBackStop;           // Write-back thread stop request
+		double          dirtyHighWatermark;      // Shard dirty pages share to start write-back
+		double          dirtyLowWatermark;       // Shard dirty pages share to stop write-back
+		std::thread     writeBackThread;         // Background write-back thread
+		std::mutex      writeBackLatch;          // Write-back thread state latch
+		std::condition_variable writeBackSignal; // Wakes up write-back thread
+
+		bool            warmUpEnabled;           // Warm-up manifest is saved and restored
+		bool            warmUpBackground;        // Manifest is restored by background thread
+		std::string     warmUpPath;              // Warm-up manifest file path
+		std::vector<uint64_t> warmUpManifest;    // Pages to restore (hottest first)
+		std::thread     warmUpThread;            // Background warm-up thread
+		std::atomic<bool> warmUpStop;            // Warm-up thread stop request
+		std::atomic<uint64_t> warmUpRestored;    // Manifest pages processed
+		std::atomic<uint64_t> warmUpPages;       // Pages loaded by warm-up
+		std::atomic<uint64_t> warmUpDuration;    // Time of warm-up (ns)
 	};
 
 
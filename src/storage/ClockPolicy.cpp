@@ -0,0 +1,146 @@
+/******************************************************************************
+*
+*  CLOCK (second chance) cache replacement policy implementation
+*
+*  Pages of shard memory pool form a circular buffer. Cache hit only sets
+*  page reference bit. Clock hand sweeps pages clearing reference bits and
+*  evicts first page that has not been referenced since last sweep.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+using namespace Boson;
+
+
+/**
+* @brief CLOCK policy constructor (pool pages are added by addPages)
+*/
+ClockPolicy::ClockPolicy() {
+	this->hand = 0;
+}
+
+
+/**
+* @brief Page is loaded: it will get second chance only if referenced again
+* @param page - loaded cache page
+* @param hint - access hint
+*/
+void ClockPolicy::insert(CachePage* page, AccessHint hint) {
+	page->referenced = false;
+}
+
+
+/**
+* @brief Page is accessed: set reference bit (scan access gives no second chance)
+* @param page - accessed cache page
+* @param hint - access hint
+*/
+void ClockPolicy::access(CachePage* page, AccessHint hint) {
+	if (hint == AccessHint::SEQUENTIAL) return;
+	page->referenced = true;
+}
+
+
+/**
+* @brief Sweeps clock hand to find page that is not referenced and not pinned
+* @return victim cache page or nullptr if there are no unpinned pages
+*/
+CachePage* ClockPolicy::evict() {
+	// Two turns of the hand are enough, first turn clears reference bits
+	for (uint64_t i = 0; i < 2 * pages.size(); i++) {
+		CachePage* page = pages[hand];
+		hand = (hand + 1) % pages.size();
+		if (page->filePageNo == NOT_FOUND || page->pinCount > 0) continue;
+		if (page->referenced) {
+			page->referenced = false;
+			continue;
+		}
+		return page;
+	}
+	return nullptr;
+}
+
+
+/**
+* @brief Clears policy state
+*/
+void ClockPolicy::clear() {
+	for (CachePage* page : pages) page->referenced = false;
+	hand = 0;
+}
+
+
+/**
+* @brief New free pages of shard pool are added to the clock
+* @param pages - added free pages
+* @param count - pages count
+*/
+void ClockPolicy::addPages(CachePage** pages, uint64_t count) {
+	this->pages.insert(this->pages.end(), pages, pages + count);
+}
+
+
+/**
+* @brief Free pages released from shard pool are removed from the clock
+* @param pages - removed free pages
+* @param count - pages count
+*/
+void ClockPolicy::removePages(CachePage** pages, uint64_t count) {
+	std::unordered_set<CachePage*> removed(pages, pages + count);
+	auto last = std::remove_if(this->pages.begin(), this->pages.end(),
+		[&removed](CachePage* page) { return removed.count(page) > 0; });
+	this->pages.erase(last, this->pages.end());
+	if (hand >= this->pages.size()) hand = 0;
+}
+
+
+/**
+* @brief Resident page is moved to another pool page keeping its reference bit
+* @param from - current cache page
+* @param to - free cache page that takes place of the page
+*/
+void ClockPolicy::movePage(CachePage* from, CachePage* to) {
+	to->referenced = from->referenced;
+	from->referenced = false;
+}
+
+
+/**
+* @brief Shard capacity is changed (clock has no capacity dependent state)
+* @param pagesCount - new shard capacity
+*/
+void ClockPolicy::setCapacity(uint64_t pagesCount) {
+}
+
+
+/**
+* @brief Page leaves the cache without eviction (file is detached from pool)
+* @param page - resident cache page
+*/
+void ClockPolicy::erase(CachePage* page) {
+	page->referenced = false;
+}
+
+
+/**
+* @brief Lists resident pages from the hottest to the coldest: referenced
+* pages first, then pages in reverse order of the hand sweep (pages right
+* after the hand are the next victims)
+* @param resident - pages are appended to the vector
+*/
+void ClockPolicy::getResidentPages(std::vector<CachePage*>& resident) {
+	uint64_t count = pages.size();
+	for (int referencedPass = 1; referencedPass >= 0; referencedPass--) {
+		for (uint64_t i = 1; i <= count; i++) {
+			CachePage* page = pages[(hand + count - i) % count];
+			if (page->filePageNo == NOT_FOUND) continue;
+			if (page->referenced == (referencedPass == 1)) resident.push_back(page);
+		}
+	}
+}
@@ -0,0 +1,261 @@
+/******************************************************************************
+*
+*  CLOCK-Pro cache replacement policy implementation
+*
+*  Resident pages are "hot" (small reuse distance) or "cold". Cold pages
+*  start a test period on insert. If cold page is referenced again during
+*  its test period it is promoted to hot. Evicted cold pages that are still
+*  in test period are remembered as non-resident test pages, so if they are
+*  requested again soon, cold pages target grows and page is loaded as hot.
+*  Expired test pages shrink cold pages target back.
+*
+*  Cold hand searches for victim among cold pages, hot hand demotes not
+*  referenced hot pages to cold when hot pages exceed their share. As in
+*  CLOCK, cache hit only sets page reference bit. Pages of sequential scan
+*  are loaded as cold pages without test period and never get reference bit.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+using namespace Boson;
+
+
+/**
+* @brief CLOCK-Pro policy constructor (pool pages and capacity are set
+* by addPages and setCapacity)
+*/
+ClockProPolicy::ClockProPolicy() {
+	this->pagesCount = 0;
+	this->coldHand = 0;
+	this->hotHand = 0;
+	this->hotPagesCount = 0;
+	this->coldTarget = 1;
+}
+
+
+/**
+* @brief Page is loaded: hot if it was recently evicted during test, otherwise cold
+* @param page - loaded cache page
+* @param hint - access hint
+*/
+void ClockProPolicy::insert(CachePage* page, AccessHint hint) {
+	page->referenced = false;
+	auto testPage = testPagesMap.find(getPageKey(page->fileId, page->filePageNo));
+	if (hint == AccessHint::SEQUENTIAL) {
+		// Scan page: cold without test period
+		page->hot = false;
+		page->inTest = false;
+	} else if (testPage != testPagesMap.end()) {
+		// Reuse distance is less than cache size: give more space to cold pages
+		testPages.erase(testPage->second);
+		testPagesMap.erase(testPage);
+		if (coldTarget < pagesCount - 1) coldTarget++;
+		page->hot = true;
+		page->inTest = false;
+		hotPagesCount++;
+		runHotHand();
+	} else {
+		page->hot = false;
+		page->inTest = true;
+	}
+}
+
+
+/**
+* @brief Page is accessed: set reference bit (except scan access)
+* @param page - accessed cache page
+* @param hint - access hint
+*/
+void ClockProPolicy::access(CachePage* page, AccessHint hint) {
+	if (hint == AccessHint::SEQUENTIAL) return;
+	page->referenced = true;
+}
+
+
+/**
+* @brief Sweeps cold hand to find cold page that is not referenced and not pinned
+* @return victim cache page or nullptr if there are no unpinned pages
+*/
+CachePage* ClockProPolicy::evict() {
+	for (uint64_t i = 0; i < 2 * pages.size(); i++) {
+		CachePage* page = pages[coldHand];
+		coldHand = (coldHand + 1) % pages.size();
+		if (page->filePageNo == NOT_FOUND || page->hot || page->pinCount > 0) continue;
+		if (page->referenced) {
+			page->referenced = false;
+			if (page->inTest) {
+				// Referenced during test period: promote to hot
+				page->hot = true;
+				page->inTest = false;
+				hotPagesCount++;
+				runHotHand();
+			} else page->inTest = true;
+			continue;
+		}
+		// Remember victim as non-resident test page if test period is not over
+		if (page->inTest) addTestPage(getPageKey(page->fileId, page->filePageNo));
+		return page;
+	}
+	// All pages are hot, referenced or pinned: evict first unpinned page under the cold hand
+	for (uint64_t i = 0; i < pages.size(); i++) {
+		CachePage* page = pages[coldHand];
+		coldHand = (coldHand + 1) % pages.size();
+		if (page->filePageNo == NOT_FOUND || page->pinCount > 0) continue;
+		if (page->hot) {
+			page->hot = false;
+			hotPagesCount--;
+		}
+		return page;
+	}
+	return nullptr;
+}
+
+
+/**
+* @brief Clears policy state
+*/
+void ClockProPolicy::clear() {
+	for (CachePage* page : pages) {
+		page->referenced = false;
+		page->hot = false;
+		page->inTest = false;
+	}
+	testPages.clear();
+	testPagesMap.clear();
+	coldHand = 0;
+	hotHand = 0;
+	hotPagesCount = 0;
+	coldTarget = std::max(uint64_t(1), pagesCount / 2);
+}
+
+
+/**
+* @brief Sweeps hot hand demoting not referenced hot pages to cold
+* while hot pages count exceeds its target share
+*/
+void ClockProPolicy::runHotHand() {
+	for (uint64_t i = 0; i < 2 * pages.size() && hotPagesCount + coldTarget > pagesCount; i++) {
+		CachePage* page = pages[hotHand];
+		hotHand = (hotHand + 1) % pages.size();
+		if (page->filePageNo == NOT_FOUND) continue;
+		if (page->hot) {
+			if (page->referenced) page->referenced = false;
+			else {
+				page->hot = false;
+				hotPagesCount--;
+			}
+		} else page->inTest = false;  // hot hand terminates test period of cold pages
+	}
+}
+
+
+/**
+* @brief Remembers evicted page as non-resident test page
+* @param pageKey - pool page key of evicted page
+*/
+void ClockProPolicy::addTestPage(uint64_t pageKey) {
+	testPages.push_front(pageKey);
+	testPagesMap[pageKey] = testPages.begin();
+	// Keep not more test pages than resident pages
+	if (testPages.size() > pagesCount) {
+		// Test period expired without reuse: give less space to cold pages
+		testPagesMap.erase(testPages.back());
+		testPages.pop_back();
+		if (coldTarget > 1) coldTarget--;
+	}
+}
+
+
+/**
+* @brief New free pages of shard pool are added to the clock
+* @param pages - added free pages
+* @param count - pages count
+*/
+void ClockProPolicy::addPages(CachePage** pages, uint64_t count) {
+	this->pages.insert(this->pages.end(), pages, pages + count);
+}
+
+
+/**
+* @brief Free pages released from shard pool are removed from the clock
+* @param pages - removed free pages
+* @param count - pages count
+*/
+void ClockProPolicy::removePages(CachePage** pages, uint64_t count) {
+	std::unordered_set<CachePage*> removed(pages, pages + count);
+	auto last = std::remove_if(this->pages.begin(), this->pages.end(),
+		[&removed](CachePage* page) { return removed.count(page) > 0; });
+	this->pages.erase(last, this->pages.end());
+	if (coldHand >= this->pages.size()) coldHand = 0;
+	if (hotHand >= this->pages.size()) hotHand = 0;
+}
+
+
+/**
+* @brief Resident page is moved to another pool page keeping its hot/cold state
+* @param from - current cache page
+* @param to - free cache page that takes place of the page
+*/
+void ClockProPolicy::movePage(CachePage* from, CachePage* to) {
+	to->referenced = from->referenced;
+	to->hot = from->hot;
+	to->inTest = from->inTest;
+	from->referenced = false;
+	from->hot = false;
+	from->inTest = false;
+}
+
+
+/**
+* @brief Shard capacity is changed: adapted cold pages target keeps its share
+* of the capacity, test pages over the new capacity are forgotten
+* @param pagesCount - new shard capacity
+*/
+void ClockProPolicy::setCapacity(uint64_t pagesCount) {
+	if (this->pagesCount == 0) coldTarget = pagesCount / 2;
+	else coldTarget = coldTarget * pagesCount / this->pagesCount;
+	coldTarget = std::max(uint64_t(1), std::min(coldTarget, pagesCount > 1 ? pagesCount - 1 : 1));
+	this->pagesCount = pagesCount;
+	while (testPages.size() > pagesCount) {
+		testPagesMap.erase(testPages.back());
+		testPages.pop_back();
+	}
+	runHotHand();
+}
+
+
+/**
+* @brief Page leaves the cache without eviction (file is detached from pool)
+* @param page - resident cache page
+*/
+void ClockProPolicy::erase(CachePage* page) {
+	if (page->hot) hotPagesCount--;
+	page->hot = false;
+	page->inTest = false;
+	page->referenced = false;
+}
+
+
+/**
+* @brief Lists resident pages from the hottest to the coldest: hot pages,
+* referenced cold pages, then other cold pages in reverse order of the cold
+* hand sweep (pages right after the cold hand are the next victims)
+* @param resident - pages are appended to the vector
+*/
+void ClockProPolicy::getResidentPages(std::vector<CachePage*>& resident) {
+	uint64_t count = pages.size();
+	for (int pass = 0; pass < 3; pass++) {
+		for (uint64_t i = 1; i <= count; i++) {
+			CachePage* page = pages[(coldHand + count - i) % count];
+			if (page->filePageNo == NOT_FOUND) continue;
+			int pagePass = page->hot ? 0 : (page->referenced ? 1 : 2);
+			if (pagePass == pass) resident.push_back(page);
+		}
+	}
+}
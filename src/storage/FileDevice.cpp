@@ -0,0 +1,306 @@
+/******************************************************************************
+*
+*  FileDevice class implementation
+*
+*  File is accessed by OS file descriptor. On POSIX systems I/O is
+*  positional and vectored (preadv/pwritev), so there is no shared seek
+*  pointer and calls of different threads go to storage device in
+*  parallel. On Windows seek and read/write calls of CRT descriptor are
+*  serialized by file latch and vectored I/O is gathered in the staging
+*  buffer.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "StorageDevice.h"
+
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#include <share.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+using namespace Boson;
+
+
+/**
+* @brief Constructor of closed file device
+*/
+FileDevice::FileDevice() {
+	this->fileDescriptor = -1;
+}
+
+
+/**
+* @brief Destructor closes file if it still open
+*/
+FileDevice::~FileDevice() {
+	this->close();
+}
+
+
+/**
+*
+*  @brief Opens OS file, creates it if it doesn't exist (unless read only)
+*
+*  @param[in] path     - the name of the file to be opened (path)
+*  @param[in] readOnly - if true, file is not created and opened for reading
+*
+*  @return true if file opened, false if can't open file
+*
+*/
+bool FileDevice::open(const char* path, bool readOnly) {
+	if (path == nullptr) return false;
+	if (fileDescriptor >= 0) close();
+#ifdef _WIN32
+	int flags = _O_BINARY | (readOnly ? _O_RDONLY : (_O_RDWR | _O_CREAT));
+	errno_t errNo = _sopen_s(&(this->fileDescriptor), path, flags, _SH_DENYNO, _S_IREAD | _S_IWRITE);
+	if (errNo != 0) this->fileDescriptor = -1;
+#else
+	int flags = readOnly ? O_RDONLY : (O_RDWR | O_CREAT);
+	this->fileDescriptor = ::open(path, flags, 0644);
+#endif
+	return fileDescriptor >= 0;
+}
+
+
+/**
+* @brief Closes OS file
+*/
+void FileDevice::close() {
+	if (fileDescriptor < 0) return;
+#ifdef _WIN32
+	_close(fileDescriptor);
+#else
+	::close(fileDescriptor);
+#endif
+	this->fileDescriptor = -1;
+	this->stagingBuffer.clear();
+	this->stagingBuffer.shrink_to_fit();
+}
+
+
+/**
+* @brief Returns true if file is open
+*/
+bool FileDevice::isOpen() {
+	return fileDescriptor >= 0;
+}
+
+
+/**
+*
+*  @brief Reads consecutive file range to buffers with one read call:
+*  positional vectored read on POSIX systems, on Windows buffers are
+*  scattered from the staging buffer
+*
+*  @param offset - file offset
+*  @param buffers - buffers filled in order
+*  @param count - buffers count (not more than MAX_DEVICE_BUFFERS)
+*  @return bytes read (less than buffers length at the end of file)
+*
+*/
+size_t FileDevice::read(size_t offset, const AsyncBuffer* buffers, size_t count) {
+	if (fileDescriptor < 0 || count == 0) return 0;
+#ifdef _WIN32
+	std::lock_guard<std::mutex> fileLock(fileLatch);
+	if (_lseeki64(fileDescriptor, int64_t(offset), SEEK_SET) < 0) return 0;
+	if (count == 1) {
+		int bytesRead = _read(fileDescriptor, buffers[0].data, unsigned(buffers[0].length));
+		return bytesRead > 0 ? size_t(bytesRead) : 0;
+	}
+	size_t length = 0;
+	for (size_t i = 0; i < count; i++) length += buffers[i].length;
+	if (stagingBuffer.size() < length) stagingBuffer.resize(length);
+	int bytesRead = _read(fileDescriptor, stagingBuffer.data(), unsigned(length));
+	if (bytesRead <= 0) return 0;
+	size_t position = 0;
+	for (size_t i = 0; i < count && position < size_t(bytesRead); i++) {
+		size_t bytesToCopy = std::min(buffers[i].length, size_t(bytesRead) - position);
+		memcpy(buffers[i].data, &stagingBuffer[position], bytesToCopy);
+		position += bytesToCopy;
+	}
+	return size_t(bytesRead);
+#else
+	return transfer(offset, buffers, count, false);
+#endif
+}
+
+
+/**
+*
+*  @brief Writes buffers to consecutive file range with one write call:
+*  positional vectored write on POSIX systems, on Windows buffers are
+*  gathered to the staging buffer
+*
+*  @param offset - file offset
+*  @param buffers - buffers written in order
+*  @param count - buffers count (not more than MAX_DEVICE_BUFFERS)
+*  @return bytes written
+*
+*/
+size_t FileDevice::write(size_t offset, const AsyncBuffer* buffers, size_t count) {
+	if (fileDescriptor < 0 || count == 0) return 0;
+#ifdef _WIN32
+	std::lock_guard<std::mutex> fileLock(fileLatch);
+	const uint8_t* data = (const uint8_t*) buffers[0].data;
+	size_t length = buffers[0].length;
+	if (count > 1) {
+		length = 0;
+		for (size_t i = 0; i < count; i++) length += buffers[i].length;
+		if (stagingBuffer.size() < length) stagingBuffer.resize(length);
+		size_t position = 0;
+		for (size_t i = 0; i < count; i++) {
+			memcpy(&stagingBuffer[position], buffers[i].data, buffers[i].length);
+			position += buffers[i].length;
+		}
+		data = stagingBuffer.data();
+	}
+	if (_lseeki64(fileDescriptor, int64_t(offset), SEEK_SET) < 0) return 0;
+	int bytesWritten = _write(fileDescriptor, data, unsigned(length));
+	return bytesWritten > 0 ? size_t(bytesWritten) : 0;
+#else
+	return transfer(offset, buffers, count, true);
+#endif
+}
+
+
+/**
+*
+*  @brief Persists written data on storage device (fdatasync on POSIX)
+*
+*  @return true if data is persisted, false otherwise
+*
+*/
+bool FileDevice::sync() {
+	if (fileDescriptor < 0) return false;
+#if defined(_WIN32)
+	return _commit(fileDescriptor) == 0;
+#elif defined(__APPLE__)
+	return fsync(fileDescriptor) == 0;
+#else
+	return fdatasync(fileDescriptor) == 0;
+#endif
+}
+
+
+/**
+* @brief Returns current file size in bytes
+*/
+size_t FileDevice::getSize() {
+	if (fileDescriptor < 0) return 0;
+#ifdef _WIN32
+	int64_t fileSize = _filelengthi64(fileDescriptor);
+	return fileSize < 0 ? 0 : size_t(fileSize);
+#else
+	struct stat fileStat;
+	if (fstat(fileDescriptor, &fileStat) != 0) return 0;
+	return size_t(fileStat.st_size);
+#endif
+}
+
+
+/**
+*
+*  @brief Cuts off file data beyond the size
+*
+*  @param size - new file size (not greater than current file size)
+*  @return true if file is truncated
+*
+*/
+bool FileDevice::truncate(size_t size) {
+	if (fileDescriptor < 0 || size > getSize()) return false;
+#ifdef _WIN32
+	std::lock_guard<std::mutex> fileLock(fileLatch);
+	return _chsize_s(fileDescriptor, int64_t(size)) == 0;
+#else
+	return ftruncate(fileDescriptor, off_t(size)) == 0;
+#endif
+}
+
+
+/**
+*
+*  @brief Bypasses OS page cache (file system may not support it),
+*  buffers, offsets and lengths must be aligned to IO_ALIGNMENT
+*
+*  @param enabled - true to bypass OS page cache
+*  @return true if file is open for direct I/O
+*
+*/
+bool FileDevice::setDirectIO(bool enabled) {
+#if !defined(_WIN32) && defined(O_DIRECT)
+	if (fileDescriptor < 0) return false;
+	int fileFlags = fcntl(fileDescriptor, F_GETFL);
+	if (fileFlags < 0) return false;
+	fileFlags = enabled ? (fileFlags | O_DIRECT) : (fileFlags & ~O_DIRECT);
+	return fcntl(fileDescriptor, F_SETFL, fileFlags) == 0 && enabled;
+#else
+	return false;
+#endif
+}
+
+
+/**
+* @brief Returns OS file descriptor for group I/O submission (-1 if closed)
+*/
+int FileDevice::getDescriptor() {
+	return fileDescriptor;
+}
+
+
+#ifndef _WIN32
+/**
+*
+*  @brief Reads or writes consecutive file range with preadv/pwritev,
+*  repeats the call after partial transfer or interrupt
+*
+*  @param offset - file offset
+*  @param buffers - buffers in order
+*  @param count - buffers count (not more than MAX_DEVICE_BUFFERS)
+*  @param write - true to write buffers, false to read them
+*  @return bytes transferred
+*
+*/
+size_t FileDevice::transfer(size_t offset, const AsyncBuffer* buffers, size_t count, bool write) {
+	struct iovec vectors[MAX_DEVICE_BUFFERS];
+	count = std::min(count, size_t(MAX_DEVICE_BUFFERS));
+	size_t length = 0;
+	for (size_t i = 0; i < count; i++) {
+		vectors[i].iov_base = buffers[i].data;
+		vectors[i].iov_len = buffers[i].length;
+		length += buffers[i].length;
+	}
+	size_t transferred = 0, first = 0;
+	while (transferred < length) {
+		ssize_t result = write ?
+			pwritev(fileDescriptor, &vectors[first], int(count - first), off_t(offset + transferred)) :
+			preadv(fileDescriptor, &vectors[first], int(count - first), off_t(offset + transferred));
+		if (result < 0 && errno == EINTR) continue;
+		if (result <= 0) break;  // error or end of file
+		transferred += size_t(result);
+		// skip transferred buffers and move into partially transferred one
+		size_t remaining = size_t(result);
+		while (first < count && remaining >= vectors[first].iov_len) {
+			remaining -= vectors[first].iov_len;
+			first++;
+		}
+		if (first < count) {
+			vectors[first].iov_base = (uint8_t*)vectors[first].iov_base + remaining;
+			vectors[first].iov_len -= remaining;
+		}
+	}
+	return transferred;
+}
+#endif
@@ -0,0 +1,123 @@
+/******************************************************************************
+*
+*  FileIO interface header
+*
+*  FileIO is paged random access storage file interface used by records
+*  storage layer. Implementations:
+*    - CachedFileIO - user-space page cache over OS file (default) or
+*                     other storage device (memory, simulated)
+*    - MappedFileIO - file mapped to memory, OS page cache does caching
+*
+*  Storage implementation is selected on BosonAPI::open().
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "CachePolicy.h"
+#include "IOStats.h"
+
+namespace Boson {
+
+	//-------------------------------------------------------------------------
+	constexpr uint64_t PAGE_SIZE      = 8192;         // Default page size (8Kb)
+	constexpr uint64_t MIN_PAGE_SIZE  = 4096;         // Minimal page size (4Kb)
+	constexpr uint64_t MAX_PAGE_SIZE  = 65536;        // Maximal page size (64Kb)
+	constexpr uint64_t NOT_FOUND      = -1;           // "Not found" signature
+	//-------------------------------------------------------------------------
+
+	typedef enum {                              // Storage file implementation
+		CACHED_FILE = 0,                        // User-space page cache
+		MAPPED_FILE = 1,                        // Memory mapped file
+		IN_MEMORY   = 2                         // User-space page cache over memory device
+	} StorageType;
+
+	//-------------------------------------------------------------------------
+
+	inline bool isValidPageSize(size_t pageSize) {
+		return pageSize >= MIN_PAGE_SIZE && pageSize <= MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
+	}
+
+	//-------------------------------------------------------------------------
+
+	class CachePage;
+	class CachedFileIO;
+	class MappedFileIO;
+
+	//-------------------------------------------------------------------------
+	// Pinned page handle (RAII): points directly into cached page data or
+	// mapped file memory. Cache page is not evicted until handle is released
+	// or destroyed. Handles must be released before file is closed or page
+	// size is changed (online cache resize doesn't move pinned pages).
+	//-------------------------------------------------------------------------
+	class PinnedPage {
+		friend class CachedFileIO;
+		friend class MappedFileIO;
+	public:
+		PinnedPage();
+		PinnedPage(PinnedPage&& other) noexcept;
+		PinnedPage& operator=(PinnedPage&& other) noexcept;
+		PinnedPage(const PinnedPage&) = delete;
+		void operator=(const PinnedPage&) = delete;
+		~PinnedPage();
+
+		bool           isPinned() const { return dataPointer != nullptr; }
+		const uint8_t* data() const { return dataPointer; }
+		size_t         length() const { return dataLength; }
+		void           release();
+
+	private:
+		PinnedPage(CachedFileIO* file, CachePage* page, const uint8_t* data, size_t length);
+		CachedFileIO*  file;                    // Cached file of the page (or nullptr)
+		CachePage*     page;                    // Pinned cache page (or nullptr)
+		const uint8_t* dataPointer;             // Pointer to requested data
+		size_t         dataLength;              // Requested data length
+	};
+
+
+	//-------------------------------------------------------------------------
+	// Paged random access storage file interface
+	//-------------------------------------------------------------------------
+	class FileIO {
+	public:
+		virtual ~FileIO() {}
+
+		virtual bool   close() = 0;
+		virtual bool   isOpen() = 0;
+		virtual bool   isReadOnly() = 0;
+
+		virtual size_t read(size_t position, void* dataBuffer, size_t length, AccessHint hint = AccessHint::NORMAL) = 0;
+		virtual size_t write(size_t position, const void* dataBuffer, size_t length) = 0;
+		virtual size_t readPage(size_t pageNo, void* userPageBuffer, AccessHint hint = AccessHint::NORMAL) = 0;
+		virtual size_t writePage(size_t pageNo, const void* userPageBuffer) = 0;
+		virtual size_t flush() = 0;
+
+		virtual PinnedPage pin(size_t position, size_t length, AccessHint hint = AccessHint::NORMAL) = 0;
+		virtual PinnedPage pinPage(size_t pageNo, AccessHint hint = AccessHint::NORMAL) = 0;
+
+		virtual void   resetStats() = 0;
+		virtual void   getStatsSnapshot(FileIOStats& stats) = 0;
+		double         getStats(CachedFileStats type);
+		virtual size_t getFileSize() = 0;
+		virtual bool   truncate(size_t size) = 0;
+		virtual size_t getPageSize() = 0;
+		virtual bool   setPageSize(size_t pageSize) = 0;
+	};
+
+
+	/**
+	* @brief Returns statistics parameter of storage file snapshot
+	* @param type - requested statistics parameter
+	*/
+	inline double FileIO::getStats(CachedFileStats type) {
+		FileIOStats stats = {};
+		getStatsSnapshot(stats);
+		return stats.get(type);
+	}
+
+}
@@ -0,0 +1,225 @@
+/******************************************************************************
+*
+*  File I/O statistics implementation
+*
+*  Latency histogram bucket of value below 2^(LATENCY_SUB_BITS+1) ns is the
+*  value itself. Larger values are split by power of 2 (exponent) and by
+*  LATENCY_SUB_BITS bits following the highest bit (sub bucket), so bucket
+*  width is 1/8 of its lower bound. Percentiles are reported as the upper
+*  bound of the bucket they fall into.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "IOStats.h"
+
+#include <algorithm>
+
+using namespace Boson;
+
+
+/**
+*
+* @brief Returns snapshot value of requested statistics parameter
+* @param type - requested statistics parameter
+* @return value of requested parameter
+*
+*/
+double FileIOStats::get(CachedFileStats type) const {
+
+	double totalRequests = double(this->totalRequests);
+	double totalCacheMisses = double(this->cacheMisses);
+	double seconds = 0;
+	double megabytes = 0;
+
+	switch (type) {
+	case CachedFileStats::TOTAL_REQUESTS:
+		return totalRequests;
+	case CachedFileStats::TOTAL_CACHE_MISSES:
+		return totalCacheMisses;
+	case CachedFileStats::TOTAL_CACHE_HITS:
+		return totalRequests - totalCacheMisses;
+	case CachedFileStats::TOTAL_BYTES_WRITTEN:
+		return double(bytesWritten);
+	case CachedFileStats::TOTAL_BYTES_READ:
+		return double(bytesRead);
+	case CachedFileStats::TOTAL_BYTES_PINNED:
+		return double(bytesPinned);
+	case CachedFileStats::TOTAL_DIRTY_EVICTIONS:
+		return double(dirtyEvictions);
+	case CachedFileStats::TOTAL_WRITEBACK_PAGES:
+		return double(writeBackPages);
+	case CachedFileStats::DIRTY_PAGES:
+		return double(dirtyPages);
+	case CachedFileStats::TOTAL_FLUSHES:
+		return double(flushes);
+	case CachedFileStats::FLUSH_WRITE_CALLS:
+		return double(flushWriteCalls);
+	case CachedFileStats::FLUSH_BYTES_WRITTEN:
+		return double(flushBytesWritten);
+	case CachedFileStats::BATCHED_READ_PAGES:
+		return double(batchedReadPages);
+	case CachedFileStats::ASYNC_SUBMIT_CALLS:
+		return double(asyncSubmitCalls);
+	case CachedFileStats::POOL_MEMORY_BYTES:
+		return double(poolMemoryBytes);
+	case CachedFileStats::READ_AHEAD_PAGES:
+		return double(readAheadPages);
+	case CachedFileStats::READ_AHEAD_HITS:
+		return double(readAheadHits);
+	case CachedFileStats::READ_AHEAD_WASTED:
+		return double(readAheadWasted);
+	case CachedFileStats::STORAGE_BYTES_READ:
+		return double(storageBytesRead);
+	case CachedFileStats::SKIPPED_FETCHES:
+		return double(skippedFetches);
+	case CachedFileStats::STORAGE_BYTES_WRITTEN:
+		return double(storageBytesWritten);
+	case CachedFileStats::WARM_UP_PAGES:
+		return double(warmUpPages);
+	case CachedFileStats::WARM_UP_PROGRESS:
+		return warmUpProgress;
+	case CachedFileStats::WARM_UP_TIME_NS:
+		return double(warmUpTimeNs);
+	case CachedFileStats::TOTAL_WRITE_TIME_NS:
+		return double(writeTimeNs);
+	case CachedFileStats::TOTAL_READ_TIME_NS:
+		return double(readTimeNs);
+	case CachedFileStats::CACHE_HITS_RATE:
+		if (totalRequests == 0) return 0;
+		return (totalRequests - totalCacheMisses) / totalRequests * 100.0;
+	case CachedFileStats::CACHE_MISSES_RATE:
+		if (totalRequests == 0) return 0;
+		return totalCacheMisses / totalRequests * 100.0;
+	case CachedFileStats::READ_THROUGHPUT:
+		if (readTimeNs == 0) return 0;
+		seconds = double(readTimeNs) / 1000000000.0;
+		megabytes = double(bytesRead) / (1024 * 1024);
+		return megabytes / seconds;
+	case CachedFileStats::WRITE_THROUGHPUT:
+		if (writeTimeNs == 0) return 0;
+		seconds = double(writeTimeNs) / 1000000000.0;
+		megabytes = double(bytesWritten) / (1024 * 1024);
+		return megabytes / seconds;
+	case CachedFileStats::HIT_LATENCY_P99:
+		return double(hitLatency.p99);
+	case CachedFileStats::MISS_LATENCY_P99:
+		return double(missLatency.p99);
+	case CachedFileStats::EVICTION_LATENCY_P99:
+		return double(evictionLatency.p99);
+	case CachedFileStats::FLUSH_LATENCY_P99:
+		return double(flushLatency.p99);
+	}
+	return 0.0;
+}
+
+
+
+/**
+* @brief Constructor of empty histogram
+*/
+LatencyHistogram::LatencyHistogram() {
+	reset();
+}
+
+
+/**
+* @brief Records operation latency (thread safe, lock free)
+* @param latency - operation latency in nanoseconds
+*/
+void LatencyHistogram::record(uint64_t latency) {
+	buckets[getBucket(latency)].fetch_add(1, std::memory_order_relaxed);
+	totalLatency.fetch_add(latency, std::memory_order_relaxed);
+	uint64_t currentMax = maxLatency.load(std::memory_order_relaxed);
+	while (latency > currentMax && !maxLatency.compare_exchange_weak(currentMax, latency, std::memory_order_relaxed));
+}
+
+
+/**
+* @brief Clears all recorded latencies
+*/
+void LatencyHistogram::reset() {
+	for (uint64_t i = 0; i < LATENCY_BUCKETS; i++) buckets[i] = 0;
+	totalLatency = 0;
+	maxLatency = 0;
+}
+
+
+/**
+* @brief Returns recorded operations count
+*/
+uint64_t LatencyHistogram::getCount() {
+	uint64_t count = 0;
+	for (uint64_t i = 0; i < LATENCY_BUCKETS; i++) count += buckets[i].load(std::memory_order_relaxed);
+	return count;
+}
+
+
+
+/**
+*
+* @brief Calculates operations count, mean, maximum and percentiles of
+* recorded latencies (concurrent records may be partially included)
+* @param summary - latency summary (ns)
+*
+*/
+void LatencyHistogram::getSummary(LatencySummary& summary) {
+	uint64_t counts[LATENCY_BUCKETS];
+	uint64_t count = 0;
+	for (uint64_t i = 0; i < LATENCY_BUCKETS; i++) {
+		counts[i] = buckets[i].load(std::memory_order_relaxed);
+		count += counts[i];
+	}
+	summary = {};
+	summary.count = count;
+	if (count == 0) return;
+	summary.mean = totalLatency.load(std::memory_order_relaxed) / count;
+	summary.max = maxLatency.load(std::memory_order_relaxed);
+
+	// Ranks of percentiles (rounded up) in ascending order
+	const uint64_t ranks[3] = {
+		(count * 500 + 999) / 1000,
+		(count * 990 + 999) / 1000,
+		(count * 999 + 999) / 1000 };
+	uint64_t* percentiles[3] = { &summary.p50, &summary.p99, &summary.p999 };
+	uint64_t cumulative = 0;
+	size_t next = 0;
+	for (uint64_t i = 0; i < LATENCY_BUCKETS && next < 3; i++) {
+		if (counts[i] == 0) continue;
+		cumulative += counts[i];
+		uint64_t limit = std::min(getBucketLimit(i), summary.max);
+		while (next < 3 && cumulative >= ranks[next]) *percentiles[next++] = limit;
+	}
+}
+
+
+
+/**
+* @brief Returns histogram bucket of latency value
+* @param latency - latency in nanoseconds
+*/
+uint64_t LatencyHistogram::getBucket(uint64_t latency) {
+	constexpr uint64_t linearLimit = 2ull << LATENCY_SUB_BITS;
+	if (latency < linearLimit) return latency;
+	if (latency >> LATENCY_MAX_BITS) return LATENCY_BUCKETS - 1;
+	// Position of the highest bit
+	uint64_t exponent = 0;
+	for (uint64_t bits = latency; bits > 1; bits >>= 1) exponent++;
+	uint64_t subBucket = (latency >> (exponent - LATENCY_SUB_BITS)) & ((1ull << LATENCY_SUB_BITS) - 1);
+	return linearLimit + ((exponent - LATENCY_SUB_BITS - 1) << LATENCY_SUB_BITS) + subBucket;
+}
+
+
+/**
+* @brief Returns the largest latency value of histogram bucket
+* @param bucket - histogram bucket
+*/
+uint64_t LatencyHistogram::getBucketLimit(uint64_t bucket) {
+	constexpr uint64_t linearLimit = 2ull << LATENCY_SUB_BITS;
+	if (bucket < linearLimit) return bucket;
+	uint64_t exponent = ((bucket - linearLimit) >> LATENCY_SUB_BITS) + LATENCY_SUB_BITS + 1;
+	uint64_t subBucket = (bucket - linearLimit) & ((1ull << LATENCY_SUB_BITS) - 1);
+	uint64_t width = 1ull << (exponent - LATENCY_SUB_BITS);
+	return ((1ull << LATENCY_SUB_BITS) + subBucket) * width + width - 1;
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+*
+*  File I/O statistics header
+*
+*  Storage files keep low overhead counters and latency histograms:
+*    - only sampled operations (1 of LATENCY_SAMPLING, chosen at random by
+*      thread local generator) read the clock, so cache hits don't pay for
+*      two clock reads; total read/write time is estimated from samples
+*    - latency histogram has log-linear buckets (8 buckets per power of 2,
+*      12.5% precision) of atomic counters, so recording is lock free
+*
+*  FileIOStats is structured snapshot of all counters and latency
+*  percentiles (p50/p99/p999) of cache hits, misses, dirty evictions and
+*  flushes, monitoring takes it with one call.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+
+namespace Boson {
+
+	//-------------------------------------------------------------------------
+	constexpr uint64_t LATENCY_SAMPLING  = 16;        // 1 of N operations is timed (power of 2)
+	constexpr uint64_t LATENCY_SUB_BITS  = 3;         // Histogram buckets per power of 2 (log2)
+	constexpr uint64_t LATENCY_MAX_BITS  = 44;        // Maximal histogram latency (2^44 ns)
+	constexpr uint64_t LATENCY_BUCKETS   =            // Histogram buckets count
+		(2ull << LATENCY_SUB_BITS) + (LATENCY_MAX_BITS - LATENCY_SUB_BITS - 1) * (1ull << LATENCY_SUB_BITS);
+	//-------------------------------------------------------------------------
+
+	typedef enum {                              // CachedFileIO stats types
+		TOTAL_REQUESTS,                         // Total requests to cache
+		TOTAL_CACHE_MISSES,                     // Total number of cache misses
+		TOTAL_CACHE_HITS,                       // Total number of cache hits
+		TOTAL_BYTES_WRITTEN,                    // Total bytes written
+		TOTAL_BYTES_READ,		                // Total bytes read
+		TOTAL_BYTES_PINNED,                     // Total bytes accessed by pins
+		TOTAL_DIRTY_EVICTIONS,                  // Dirty pages persisted on eviction
+		TOTAL_WRITEBACK_PAGES,                  // Dirty pages persisted by write-back
+		DIRTY_PAGES,                            // Current dirty pages count
+		TOTAL_FLUSHES,                          // Total flush calls
+		FLUSH_WRITE_CALLS,                      // Storage write calls made by flushes
+		FLUSH_BYTES_WRITTEN,                    // Bytes written to storage by flushes
+		BATCHED_READ_PAGES,                     // Pages loaded by batched reads
+		ASYNC_SUBMIT_CALLS,                     // Group I/O submit system calls
+		POOL_MEMORY_BYTES,                      // Memory allocated for cache pages
+		READ_AHEAD_PAGES,                       // Pages prefetched by read-ahead
+		READ_AHEAD_HITS,                        // Prefetched pages requested later
+		READ_AHEAD_WASTED,                      // Prefetched pages evicted unused
+		STORAGE_BYTES_READ,                     // Bytes read from storage device
+		SKIPPED_FETCHES,                        // Write misses served without storage read
+		STORAGE_BYTES_WRITTEN,                  // Bytes written to storage device
+		WARM_UP_PAGES,                          // Pages restored by cache warm-up
+		WARM_UP_PROGRESS,                       // Cache warm-up progress (0-100%)
+		WARM_UP_TIME_NS,                        // Cache warm-up time (ns)
+		TOTAL_WRITE_TIME_NS,                    // Total write time (ns, estimated by samples)
+		TOTAL_READ_TIME_NS,                     // Total read time (ns, estimated by samples)
+		CACHE_HITS_RATE,                        // Cache hits rate (0-100%)
+		CACHE_MISSES_RATE,                      // Cache misses rate (0-100%)
+		WRITE_THROUGHPUT,                       // Write throughput Mb/sec
+		READ_THROUGHPUT,                        // Read throughput Mb/sec
+		HIT_LATENCY_P99,                        // 99th percentile of cache hit latency (ns)
+		MISS_LATENCY_P99,                       // 99th percentile of cache miss latency (ns)
+		EVICTION_LATENCY_P99,                   // 99th percentile of dirty eviction latency (ns)
+		FLUSH_LATENCY_P99                       // 99th percentile of flush latency (ns)
+	} CachedFileStats;
+
+	typedef struct {                            // Latency histogram summary (ns)
+		uint64_t  count;                        // Recorded operations
+		uint64_t  mean;                         // Mean latency
+		uint64_t  p50;                          // Median latency
+		uint64_t  p99;                          // 99th percentile
+		uint64_t  p999;                         // 99.9th percentile
+		uint64_t  max;                          // Maximal latency
+	} LatencySummary;
+
+
+	//-------------------------------------------------------------------------
+	// Structured snapshot of storage file statistics
+	//-------------------------------------------------------------------------
+	class FileIOStats {
+	public:
+		uint64_t  totalRequests;                // Total requests to cache
+		uint64_t  cacheMisses;                  // Total number of cache misses
+		uint64_t  bytesWritten;                 // Total bytes written
+		uint64_t  bytesRead;                    // Total bytes read
+		uint64_t  bytesPinned;                  // Total bytes accessed by pins
+		uint64_t  dirtyEvictions;               // Dirty pages persisted on eviction
+		uint64_t  writeBackPages;               // Dirty pages persisted by write-back
+		uint64_t  dirtyPages;                   // Current dirty pages count
+		uint64_t  flushes;                      // Total flush calls
+		uint64_t  flushWriteCalls;              // Storage write calls made by flushes
+		uint64_t  flushBytesWritten;            // Bytes written to storage by flushes
+		uint64_t  batchedReadPages;             // Pages loaded by batched reads
+		uint64_t  asyncSubmitCalls;             // Group I/O submit system calls
+		uint64_t  poolMemoryBytes;              // Memory allocated for cache pages
+		uint64_t  readAheadPages;               // Pages prefetched by read-ahead
+		uint64_t  readAheadHits;                // Prefetched pages requested later
+		uint64_t  readAheadWasted;              // Prefetched pages evicted unused
+		uint64_t  storageBytesRead;             // Bytes read from storage device
+		uint64_t  skippedFetches;               // Write misses served without storage read
+		uint64_t  storageBytesWritten;          // Bytes written to storage device
+		uint64_t  warmUpPages;                  // Pages restored by cache warm-up
+		double    warmUpProgress;               // Cache warm-up progress (0-100%)
+		uint64_t  warmUpTimeNs;                 // Cache warm-up time (ns)
+		uint64_t  writeTimeNs;                  // Total write time (ns, estimated)
+		uint64_t  readTimeNs;                   // Total read time (ns, estimated)
+		LatencySummary hitLatency;              // Operations served from cache
+		LatencySummary missLatency;             // Operations that loaded pages
+		LatencySummary evictionLatency;         // Dirty victim page writes
+		LatencySummary flushLatency;            // Flush calls
+
+		double get(CachedFileStats type) const;
+	};
+
+
+	//-------------------------------------------------------------------------
+	// Lock free log-linear latency histogram (ns)
+	//-------------------------------------------------------------------------
+	class LatencyHistogram {
+	public:
+		LatencyHistogram();
+		LatencyHistogram(const LatencyHistogram&) = delete;
+		void operator=(const LatencyHistogram&) = delete;
+
+		void     record(uint64_t latency);
+		void     reset();
+		uint64_t getCount();
+		void     getSummary(LatencySummary& summary);
+
+	private:
+		static uint64_t getBucket(uint64_t latency);
+		static uint64_t getBucketLimit(uint64_t bucket);
+
+		std::atomic<uint64_t> buckets[LATENCY_BUCKETS]; // Operations count per bucket
+		std::atomic<uint64_t> totalLatency;      // Sum of recorded latencies
+		std::atomic<uint64_t> maxLatency;        // Maximal recorded latency
+	};
+
+	//-------------------------------------------------------------------------
+
+	/**
+	* @brief Returns monotonic clock time in nanoseconds
+	*/
+	inline uint64_t getTimeNs() {
+		return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+
+	/**
+	* @brief Decides if calling thread times current operation: thread local
+	* xorshift generator picks 1 of LATENCY_SAMPLING operations at random, so
+	* periodic access patterns don't bias samples
+	*/
+	inline bool isSampledOperation() {
+		static thread_local uint64_t state = 0x9E3779B97F4A7C15ull;
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return (state & (LATENCY_SAMPLING - 1)) == 0;
+	}
+
+	//-------------------------------------------------------------------------
+	// Sampled operation timer: reads clock only if operation is sampled
+	//-------------------------------------------------------------------------
+	class LatencyTimer {
+	public:
+		LatencyTimer() : startTime(isSampledOperation() ? getTimeNs() : 0) {}
+		bool     isSampled() const { return startTime != 0; }
+		uint64_t elapsed() const { return getTimeNs() - startTime; }
+	private:
+		uint64_t startTime;                     // Start time (0 if not sampled)
+	};
+
+}
@@ -0,0 +1,121 @@
+/******************************************************************************
+*
+*  LRU cache replacement policy implementation
+*
+*  Pages are kept in double linked list ordered by recency of access.
+*  Cache hit moves page to the front of the list, victim is taken from
+*  the back of the list. All operations have O(1) time complexity.
+*  Pages of sequential scan are put to the back of the list and are not
+*  moved on hit, so they are evicted before the hot pages.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+using namespace Boson;
+
+
+/**
+* @brief Inserts loaded page to the front of the list (scan page to the back)
+* @param page - loaded cache page
+* @param hint - access hint
+*/
+void LRUPolicy::insert(CachePage* page, AccessHint hint) {
+	if (hint == AccessHint::SEQUENTIAL) {
+		cacheList.push_back(page);
+		page->it = std::prev(cacheList.end());
+	} else {
+		cacheList.push_front(page);
+		page->it = cacheList.begin();
+	}
+}
+
+
+/**
+* @brief Moves accessed page to the front of the list (except scan access)
+* @param page - accessed cache page
+* @param hint - access hint
+*/
+void LRUPolicy::access(CachePage* page, AccessHint hint) {
+	if (hint == AccessHint::SEQUENTIAL) return;
+	cacheList.erase(page->it);                // 1) Erase page from list by iterator
+	cacheList.push_front(page);               // 2) Push page in the front of the list
+	page->it = cacheList.begin();             // 3) update page's list iterator 
+}
+
+
+/**
+* @brief Removes most aged page that is not pinned (closest to the back of the list)
+* @return victim cache page or nullptr if all pages are pinned
+*/
+CachePage* LRUPolicy::evict() {
+	CachePage* victim = lastUnpinned(cacheList);
+	if (victim == nullptr) return nullptr;
+	cacheList.erase(victim->it);
+	return victim;
+}
+
+
+/**
+* @brief Clears policy state
+*/
+void LRUPolicy::clear() {
+	cacheList.clear();
+}
+
+
+/**
+* @brief New pages are added to shard pool (list holds resident pages only)
+* @param pages - added free pages
+* @param count - pages count
+*/
+void LRUPolicy::addPages(CachePage** pages, uint64_t count) {
+}
+
+
+/**
+* @brief Free pages are removed from shard pool (list holds resident pages only)
+* @param pages - removed free pages
+* @param count - pages count
+*/
+void LRUPolicy::removePages(CachePage** pages, uint64_t count) {
+}
+
+
+/**
+* @brief Resident page is moved to another pool page keeping its list position
+* @param from - current cache page
+* @param to - free cache page that takes place of the page
+*/
+void LRUPolicy::movePage(CachePage* from, CachePage* to) {
+	to->it = from->it;
+	*to->it = to;
+}
+
+
+/**
+* @brief Shard capacity is changed (list has no capacity dependent state)
+* @param pagesCount - new shard capacity
+*/
+void LRUPolicy::setCapacity(uint64_t pagesCount) {
+}
+
+
+/**
+* @brief Page leaves the cache without eviction (file is detached from pool)
+* @param page - resident cache page
+*/
+void LRUPolicy::erase(CachePage* page) {
+	cacheList.erase(page->it);
+}
+
+
+/**
+* @brief Lists resident pages from the most recently used to the least
+* @param resident - pages are appended to the vector
+*/
+void LRUPolicy::getResidentPages(std::vector<CachePage*>& resident) {
+	resident.insert(resident.end(), cacheList.begin(), cacheList.end());
+}
@@ -0,0 +1,481 @@
+/******************************************************************************
+*
+*  MappedFileIO class implementation
+*
+*  MappedFileIO maps storage file to memory and lets OS page cache do the
+*  caching. Large range of address space is reserved on open and file is
+*  mapped at its beginning, file growth maps new part of the file right
+*  after already mapped part, so mapped memory is never moved.
+*
+*  Memory mapping is supported on POSIX systems only.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "MappedFileIO.h"
+
+#include <cstring>
+#include <algorithm>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+using namespace Boson;
+
+
+/**
+* @brief Constructor
+*/
+MappedFileIO::MappedFileIO() {
+	this->fileDescriptor = -1;
+	this->readOnly = false;
+	this->mappedMemory = nullptr;
+	this->reservedSize = 0;
+	this->mappedSize = 0;
+	this->fileCapacity = 0;
+	this->fileSize = 0;
+	this->pageSize = PAGE_SIZE;
+	resetStats();
+}
+
+
+/**
+* @brief Destructor closes file if it still open
+*/
+MappedFileIO::~MappedFileIO() {
+	this->close();
+}
+
+
+/**
+*
+*  @brief Opens file and maps it to reserved address space
+*
+*  @param path - the path of the file
+*  @param isReadOnly - if true, the file is opened in read-only mode
+*
+*  @return true - if file opened and mapped, false - otherwise
+*
+*/
+bool MappedFileIO::open(const char* path, bool isReadOnly) {
+	// return if null pointer
+	if (path == nullptr) return false;
+	// if current file still open, close it
+	if (this->fileDescriptor >= 0) close();
+#ifdef _WIN32
+	return false;
+#else
+	// open existing file or create new one (if not read only)
+	int flags = isReadOnly ? O_RDONLY : (O_RDWR | O_CREAT);
+	int fd = ::open(path, flags, 0644);
+	if (fd < 0) return false;
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0) {
+		::close(fd);
+		return false;
+	}
+
+	// Reserve address space (no memory committed)
+	uint64_t size = uint64_t(fileStat.st_size);
+	uint64_t reserve = std::max(MAPPED_RESERVE, size * 2);
+	void* memory = mmap(nullptr, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if (memory == MAP_FAILED) {
+		::close(fd);
+		return false;
+	}
+
+	this->fileDescriptor = fd;
+	this->readOnly = isReadOnly;
+	this->mappedMemory = (uint8_t*) memory;
+	this->reservedSize = reserve;
+	this->mappedSize = 0;
+	this->fileCapacity = size;
+	this->fileSize = size;
+
+	// Map existing file content
+	if (!mapFile(size)) {
+		close();
+		return false;
+	}
+
+	// Clear statistics
+	this->resetStats();
+	return true;
+#endif
+}
+
+
+/**
+*
+*  @brief Unmaps file, trims growth chunk and closes file
+*  (all pins must be released before)
+*
+*  @return true - if file closed, false - if file was not open
+*
+*/
+bool MappedFileIO::close() {
+	if (this->fileDescriptor < 0) return false;
+#ifndef _WIN32
+	munmap(mappedMemory, reservedSize);
+	if (!readOnly && fileCapacity != fileSize) {
+		if (ftruncate(fileDescriptor, off_t(fileSize.load())) != 0) {
+			std::cerr << "MappedFileIO: can't trim file to data size\n";
+		}
+	}
+	::close(fileDescriptor);
+#endif
+	this->fileDescriptor = -1;
+	this->mappedMemory = nullptr;
+	this->reservedSize = 0;
+	this->mappedSize = 0;
+	this->fileCapacity = 0;
+	this->fileSize = 0;
+	return true;
+}
+
+
+/**
+* @brief Checks if file is open
+* @return true - if file open, false - otherwise
+*/
+bool MappedFileIO::isOpen() {
+	return fileDescriptor >= 0;
+}
+
+
+/**
+* @brief Checks if file is read only
+* @return true - if file is read only, false - otherwise
+*/
+bool MappedFileIO::isReadOnly() {
+	return readOnly;
+}
+
+
+/**
+*
+*  @brief Copies data from mapped file to user buffer
+*
+*  @param position - offset from beginning of the file
+*  @param dataBuffer - data buffer
+*  @param length - data buffer length
+*  @param hint - access hint (OS read-ahead is used for mapped file)
+*
+*  @return total bytes amount read (less than length at the end of file)
+*
+*/
+size_t MappedFileIO::read(size_t position, void* dataBuffer, size_t length, AccessHint hint) {
+
+	// Check if file is open, data buffer and length are not null
+	if (fileDescriptor < 0 || dataBuffer == nullptr || length == 0) return 0;
+
+	// Time sampled operations only
+	LatencyTimer timer;
+
+	// Copy data available in the file
+	size_t size = fileSize;
+	size_t bytesRead = 0;
+	if (position < size) {
+		bytesRead = std::min(length, size - position);
+		memcpy(dataBuffer, &mappedMemory[position], bytesRead);
+	}
+
+	// Record latency of sampled operation
+	recordLatency(timer, totalReadDuration);
+	// Increment bytes read and requests
+	this->totalBytesRead += bytesRead;
+	this->totalRequests++;
+	return bytesRead;
+}
+
+
+/**
+*
+*  @brief Copies data from user buffer to mapped file, grows file if required
+*
+*  @param position - offset from beginning of the file
+*  @param dataBuffer - data buffer with write data
+*  @param length - data buffer length
+*
+*  @return total bytes amount written
+*
+*/
+size_t MappedFileIO::write(size_t position, const void* dataBuffer, size_t length) {
+
+	// Check if file is open, data buffer and length are not null
+	if (fileDescriptor < 0 || readOnly || dataBuffer == nullptr || length == 0) return 0;
+
+	// Time sampled operations only
+	LatencyTimer timer;
+
+	// Grow file if data is written beyond file capacity
+	size_t endPosition = position + length;
+	if (endPosition > fileSize) {
+		std::lock_guard<std::mutex> lock(growLatch);
+		if (endPosition > fileCapacity) {
+			size_t newCapacity = std::max(endPosition, fileCapacity + fileCapacity / 2);
+			newCapacity = (newCapacity + MAPPED_GROW - 1) / MAPPED_GROW * MAPPED_GROW;
+			if (!mapFile(newCapacity)) return 0;
+		}
+	}
+
+	// Copy data to mapped memory
+	memcpy(&mappedMemory[position], dataBuffer, length);
+
+	// Update written data size
+	uint64_t size = fileSize;
+	while (endPosition > size && !fileSize.compare_exchange_weak(size, endPosition));
+
+	// Record latency of sampled operation
+	recordLatency(timer, totalWriteDuration);
+	// Increment bytes written and requests
+	this->totalBytesWritten += length;
+	this->totalRequests++;
+	return length;
+}
+
+
+/**
+*
+*  @brief Reads specified page from mapped file to user buffer
+*
+*  @param pageNo - page number
+*  @param userPageBuffer - user buffer of page size bytes
+*  @param hint - access hint
+*
+*  @return bytes read (less than page size at the end of file)
+*
+*/
+size_t MappedFileIO::readPage(size_t pageNo, void* userPageBuffer, AccessHint hint) {
+	return read(pageNo * pageSize, userPageBuffer, pageSize, hint);
+}
+
+
+/**
+*
+*  @brief Writes user buffer to specified page of mapped file
+*
+*  @param pageNo - page number
+*  @param userPageBuffer - user buffer of page size bytes
+*
+*  @return bytes written
+*
+*/
+size_t MappedFileIO::writePage(size_t pageNo, const void* userPageBuffer) {
+	return write(pageNo * pageSize, userPageBuffer, pageSize);
+}
+
+
+/**
+*
+*  @brief Schedules write of modified mapped pages to storage device
+*
+*  @return true - if write scheduled, false - otherwise
+*
+*/
+size_t MappedFileIO::flush() {
+	if (fileDescriptor < 0 || readOnly) return 0;
+	bool flushed = true;
+#ifndef _WIN32
+	uint64_t startTime = getTimeNs();
+	std::lock_guard<std::mutex> lock(growLatch);
+	if (mappedSize > 0) flushed = (msync(mappedMemory, mappedSize, MS_ASYNC) == 0);
+	uint64_t latency = getTimeNs() - startTime;
+	this->flushLatency.record(latency);
+	this->totalWriteDuration += latency;
+#endif
+	this->totalFlushes++;
+	return flushed;
+}
+
+
+/**
+*
+*  @brief Returns handle pointing directly into mapped file memory
+*  (data may span several pages, nothing is pinned)
+*
+*  @param position - offset from beginning of the file
+*  @param length - data length
+*  @param hint - access hint
+*
+*  @return handle, empty if data is beyond end of file
+*
+*/
+PinnedPage MappedFileIO::pin(size_t position, size_t length, AccessHint hint) {
+	if (fileDescriptor < 0 || length == 0) return PinnedPage();
+	if (position + length > fileSize) return PinnedPage();
+	this->totalBytesPinned += length;
+	this->totalRequests++;
+	return PinnedPage(nullptr, nullptr, &mappedMemory[position], length);
+}
+
+
+/**
+*
+*  @brief Returns handle pointing directly to file page in mapped memory
+*
+*  @param pageNo - page number
+*  @param hint - access hint
+*
+*  @return handle to available page data, empty if page is beyond end of file
+*
+*/
+PinnedPage MappedFileIO::pinPage(size_t pageNo, AccessHint hint) {
+	size_t position = pageNo * pageSize;
+	size_t size = fileSize;
+	if (position >= size) return PinnedPage();
+	return pin(position, std::min(pageSize, size - position), hint);
+}
+
+
+/**
+*
+*  @brief Maps file part beyond already mapped part, grows file if required
+*  (grow latch must be held by caller, except open)
+*
+*  @param newCapacity - required file capacity
+*
+*  @return true - if file is mapped, false - if file can't be grown or mapped
+*
+*/
+bool MappedFileIO::mapFile(size_t newCapacity) {
+#ifdef _WIN32
+	return false;
+#else
+	if (newCapacity > reservedSize) return false;
+	// Grow storage file
+	if (newCapacity > fileCapacity) {
+		if (ftruncate(fileDescriptor, off_t(newCapacity)) != 0) return false;
+		this->fileCapacity = newCapacity;
+	}
+	// Map file part beyond mapped part (OS page aligned)
+	size_t osPageSize = size_t(sysconf(_SC_PAGESIZE));
+	size_t newMappedSize = (fileCapacity + osPageSize - 1) / osPageSize * osPageSize;
+	if (newMappedSize <= mappedSize) return true;
+	int protection = readOnly ? PROT_READ : (PROT_READ | PROT_WRITE);
+	void* memory = mmap(&mappedMemory[mappedSize], newMappedSize - mappedSize, protection,
+		MAP_SHARED | MAP_FIXED, fileDescriptor, off_t(mappedSize));
+	if (memory == MAP_FAILED) return false;
+	this->mappedSize = newMappedSize;
+	return true;
+#endif
+}
+
+
+/**
+* @brief Resets all statistics counters
+*/
+void MappedFileIO::resetStats() {
+	this->totalRequests = 0;
+	this->totalBytesRead = 0;
+	this->totalBytesWritten = 0;
+	this->totalBytesPinned = 0;
+	this->totalReadDuration = 0;
+	this->totalWriteDuration = 0;
+	this->totalFlushes = 0;
+	this->hitLatency.reset();
+	this->flushLatency.reset();
+}
+
+
+/**
+*
+* @brief Takes snapshot of file I/O statistics. Mapped file has no cache of
+* its own: all requests are reported as hits, page faults of the OS page
+* cache are not counted.
+*
+* @param stats - statistics snapshot
+*
+*/
+void MappedFileIO::getStatsSnapshot(FileIOStats& stats) {
+	stats = {};
+	stats.totalRequests = totalRequests;
+	stats.bytesWritten = totalBytesWritten;
+	stats.bytesRead = totalBytesRead;
+	stats.bytesPinned = totalBytesPinned;
+	stats.flushes = totalFlushes;
+	stats.warmUpProgress = 100.0;
+	stats.writeTimeNs = totalWriteDuration;
+	stats.readTimeNs = totalReadDuration;
+	hitLatency.getSummary(stats.hitLatency);
+	flushLatency.getSummary(stats.flushLatency);
+}
+
+
+/**
+*
+* @brief Records latency of sampled read/write operation, total duration is
+* incremented by latency of all operations sample stands for
+*
+* @param timer - operation timer
+* @param totalDuration - total duration of the operations type
+*
+*/
+void MappedFileIO::recordLatency(const LatencyTimer& timer, std::atomic<uint64_t>& totalDuration) {
+	if (!timer.isSampled()) return;
+	uint64_t latency = timer.elapsed();
+	totalDuration += latency * LATENCY_SAMPLING;
+	hitLatency.record(latency);
+}
+
+
+/**
+* @brief Returns size of data written to the file
+* @return file size in bytes
+*/
+size_t MappedFileIO::getFileSize() {
+	if (fileDescriptor < 0) return 0;
+	return fileSize;
+}
+
+
+/**
+*
+*  @brief Cuts off file data beyond the size, reserved address space stays
+*  mapped and file part is accessible again when file grows
+*  (pins beyond the size must be released before)
+*
+*  @param size - new file size (not greater than current file size)
+*  @return true if file is truncated
+*
+*/
+bool MappedFileIO::truncate(size_t size) {
+	if (fileDescriptor < 0 || readOnly) return false;
+#ifdef _WIN32
+	return false;
+#else
+	std::lock_guard<std::mutex> lock(growLatch);
+	if (size > fileSize) return false;
+	if (ftruncate(fileDescriptor, off_t(size)) != 0) return false;
+	this->fileCapacity = size;
+	this->fileSize = size;
+	return true;
+#endif
+}
+
+
+/**
+* @brief Returns page size of page operations
+* @return page size in bytes
+*/
+size_t MappedFileIO::getPageSize() {
+	return pageSize;
+}
+
+
+/**
+* @brief Sets page size of page operations (mapping does not depend on it)
+* @param newPageSize - power of 2 from MIN_PAGE_SIZE to MAX_PAGE_SIZE
+* @return true if page size is set, false if page size is invalid
+*/
+bool MappedFileIO::setPageSize(size_t newPageSize) {
+	if (!isValidPageSize(newPageSize)) return false;
+	this->pageSize = newPageSize;
+	return true;
+}
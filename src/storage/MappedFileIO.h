@@ -0,0 +1,97 @@
+/******************************************************************************
+*
+*  MappedFileIO class header
+*
+*  MappedFileIO maps storage file to memory and lets OS page cache do the
+*  caching. For read-mostly databases that fit in RAM it avoids hashmap
+*  lookup, replacement policy bookkeeping and copying of CachedFileIO:
+*  pins point directly into mapped memory and may span several pages.
+*
+*  Large range of address space is reserved on open and file is mapped at
+*  its beginning, so file growth maps new part of the file right after
+*  already mapped part. Mapped memory is never moved, pointers returned
+*  by pins stay valid until file is closed. File is grown by chunks and
+*  trimmed to written data size on close.
+*
+*  MappedFileIO implements FileIO storage interface (see FileIO.h).
+*  Memory mapping is supported on POSIX systems only, open() fails on
+*  other platforms.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+
+#include "FileIO.h"
+
+namespace Boson {
+
+	//-------------------------------------------------------------------------
+	constexpr uint64_t MAPPED_RESERVE = 1ull << 40;   // 1Tb reserved address space
+	constexpr uint64_t MAPPED_GROW    = 1024 * 1024;  // 1Mb file growth chunk
+	//-------------------------------------------------------------------------
+
+
+	//-------------------------------------------------------------------------
+	// Binary random access memory mapped file IO
+	//-------------------------------------------------------------------------
+	class MappedFileIO : public FileIO {
+	public:
+		MappedFileIO();
+		MappedFileIO(const MappedFileIO&) = delete;
+		void operator=(const MappedFileIO&) = delete;
+		~MappedFileIO();
+
+		bool open(const char* path, bool readOnly = false);
+		bool close();
+		bool isOpen();
+		bool isReadOnly();
+
+		size_t read(size_t position, void* dataBuffer, size_t length, AccessHint hint = AccessHint::NORMAL);
+		size_t write(size_t position, const void* dataBuffer, size_t length);
+		size_t readPage(size_t pageNo, void* userPageBuffer, AccessHint hint = AccessHint::NORMAL);
+		size_t writePage(size_t pageNo, const void* userPageBuffer);
+		size_t flush();
+
+		PinnedPage pin(size_t position, size_t length, AccessHint hint = AccessHint::NORMAL);
+		PinnedPage pinPage(size_t pageNo, AccessHint hint = AccessHint::NORMAL);
+
+		void   resetStats();
+		void   getStatsSnapshot(FileIOStats& stats);
+		size_t getFileSize();
+		bool   truncate(size_t size);
+		size_t getPageSize();
+		bool   setPageSize(size_t pageSize);
+
+	private:
+
+		bool   mapFile(size_t newCapacity);
+		void   recordLatency(const LatencyTimer& timer, std::atomic<uint64_t>& totalDuration);
+
+		std::atomic<uint64_t> totalRequests;     // Read/write/pin requests
+		std::atomic<uint64_t> totalBytesRead;    // Total bytes read
+		std::atomic<uint64_t> totalBytesWritten; // Total bytes written
+		std::atomic<uint64_t> totalBytesPinned;  // Total bytes accessed by pins
+		std::atomic<uint64_t> totalReadDuration; // Time of read operations (ns, estimated)
+		std::atomic<uint64_t> totalWriteDuration;// Time of write operations (ns, estimated)
+		std::atomic<uint64_t> totalFlushes;      // Flush calls
+		LatencyHistogram hitLatency;             // Sampled read/write operations
+		LatencyHistogram flushLatency;           // Flush calls
+
+		int             fileDescriptor;          // OS file descriptor
+		bool            readOnly;                // Read only flag
+		size_t          pageSize;                // Page size of page operations
+		uint8_t*        mappedMemory;            // Reserved address space (file mapped at start)
+		uint64_t        reservedSize;            // Reserved address space size
+		uint64_t        mappedSize;              // Mapped part of reserved space (OS page aligned)
+		uint64_t        fileCapacity;            // Storage file size including growth chunk
+		std::atomic<uint64_t> fileSize;          // Written data size
+		std::mutex      growLatch;               // File growth latch
+	};
+
+}
@@ -0,0 +1,237 @@
+/******************************************************************************
+*
+*  MemoryDevice class implementation
+*
+*  Device data is kept in fixed size memory chunks (MEMORY_CHUNK_SIZE),
+*  so growing device never moves or copies written data. Chunks are zero
+*  filled on allocation, gaps of data read as zeros (like sparse file).
+*  Reads and writes copy under shared chunks latch, only growing takes
+*  the latch exclusively. No system calls are made except allocation.
+*
+*  Data is kept between close and open, it is released when device is
+*  cleared or destroyed.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "StorageDevice.h"
+
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+using namespace Boson;
+
+
+/**
+* @brief Constructor of empty closed memory device
+*/
+MemoryDevice::MemoryDevice() {
+	this->size = 0;
+	this->opened = false;
+	this->readOnly = false;
+}
+
+
+/**
+* @brief Destructor releases device memory
+*/
+MemoryDevice::~MemoryDevice() {
+	this->clear();
+}
+
+
+/**
+*
+*  @brief Opens memory device (keeps data of previous session)
+*
+*  @param[in] path     - device name (not used)
+*  @param[in] readOnly - if true, writes are not allowed
+*  @return true
+*
+*/
+bool MemoryDevice::open(const char* path, bool readOnly) {
+	this->readOnly = readOnly;
+	this->opened = true;
+	return true;
+}
+
+
+/**
+* @brief Closes memory device (data is kept until device is cleared)
+*/
+void MemoryDevice::close() {
+	this->opened = false;
+}
+
+
+/**
+* @brief Returns true if device is open
+*/
+bool MemoryDevice::isOpen() {
+	return opened;
+}
+
+
+/**
+*
+*  @brief Copies consecutive device range to buffers
+*
+*  @param offset - device offset
+*  @param buffers - buffers filled in order
+*  @param count - buffers count
+*  @return bytes read (less than buffers length at the end of data)
+*
+*/
+size_t MemoryDevice::read(size_t offset, const AsyncBuffer* buffers, size_t count) {
+	if (!opened) return 0;
+	std::shared_lock<std::shared_mutex> lock(chunksLatch);
+	size_t dataSize = size.load();
+	size_t position = offset;
+	for (size_t i = 0; i < count && position < dataSize; i++) {
+		uint8_t* data = (uint8_t*)buffers[i].data;
+		size_t bytesLeft = std::min(buffers[i].length, dataSize - position);
+		while (bytesLeft > 0) {
+			size_t chunkOffset = position % MEMORY_CHUNK_SIZE;
+			size_t bytesToCopy = std::min(bytesLeft, size_t(MEMORY_CHUNK_SIZE - chunkOffset));
+			memcpy(data, chunks[position / MEMORY_CHUNK_SIZE] + chunkOffset, bytesToCopy);
+			data += bytesToCopy;
+			position += bytesToCopy;
+			bytesLeft -= bytesToCopy;
+		}
+	}
+	return position - offset;
+}
+
+
+/**
+*
+*  @brief Copies buffers to consecutive device range, grows device if
+*  range ends beyond allocated chunks
+*
+*  @param offset - device offset
+*  @param buffers - buffers written in order
+*  @param count - buffers count
+*  @return bytes written
+*
+*/
+size_t MemoryDevice::write(size_t offset, const AsyncBuffer* buffers, size_t count) {
+	if (!opened || readOnly) return 0;
+	size_t length = 0;
+	for (size_t i = 0; i < count; i++) length += buffers[i].length;
+	if (length == 0) return 0;
+	try {
+		growChunks(offset + length);
+	} catch (std::bad_alloc&) {
+		return 0;
+	}
+	std::shared_lock<std::shared_mutex> lock(chunksLatch);
+	size_t position = offset;
+	for (size_t i = 0; i < count; i++) {
+		const uint8_t* data = (const uint8_t*)buffers[i].data;
+		size_t bytesLeft = buffers[i].length;
+		while (bytesLeft > 0) {
+			size_t chunkOffset = position % MEMORY_CHUNK_SIZE;
+			size_t bytesToCopy = std::min(bytesLeft, size_t(MEMORY_CHUNK_SIZE - chunkOffset));
+			memcpy(chunks[position / MEMORY_CHUNK_SIZE] + chunkOffset, data, bytesToCopy);
+			data += bytesToCopy;
+			position += bytesToCopy;
+			bytesLeft -= bytesToCopy;
+		}
+	}
+	// extend data size up to the end of written range
+	uint64_t dataSize = size.load();
+	while (position > dataSize && !size.compare_exchange_weak(dataSize, position));
+	return length;
+}
+
+
+/**
+* @brief Memory device has nothing to persist
+* @return true if device is open
+*/
+bool MemoryDevice::sync() {
+	return opened;
+}
+
+
+/**
+* @brief Returns device data size in bytes
+*/
+size_t MemoryDevice::getSize() {
+	return size;
+}
+
+
+/**
+*
+*  @brief Cuts off device data beyond the size and releases its chunks
+*
+*  @param newSize - new data size (not greater than current data size)
+*  @return true if device is truncated
+*
+*/
+bool MemoryDevice::truncate(size_t newSize) {
+	if (!opened || readOnly) return false;
+	std::unique_lock<std::shared_mutex> lock(chunksLatch);
+	if (newSize > size) return false;
+	size_t chunksCount = (newSize + MEMORY_CHUNK_SIZE - 1) / MEMORY_CHUNK_SIZE;
+	for (size_t i = chunksCount; i < chunks.size(); i++) delete[] chunks[i];
+	chunks.resize(chunksCount);
+	// cut off data of the last chunk reads as zeros if device grows again
+	size_t chunkOffset = newSize % MEMORY_CHUNK_SIZE;
+	if (chunkOffset > 0) memset(chunks.back() + chunkOffset, 0, MEMORY_CHUNK_SIZE - chunkOffset);
+	this->size = newSize;
+	return true;
+}
+
+
+/**
+* @brief Memory device data doesn't outlive the process
+*/
+bool MemoryDevice::isPersistent() {
+	return false;
+}
+
+
+/**
+* @brief Releases device memory, device data size becomes zero
+*/
+void MemoryDevice::clear() {
+	std::unique_lock<std::shared_mutex> lock(chunksLatch);
+	for (uint8_t* chunk : chunks) delete[] chunk;
+	chunks.clear();
+	chunks.shrink_to_fit();
+	this->size = 0;
+}
+
+
+/**
+* @brief Returns memory allocated for device data in bytes
+*/
+size_t MemoryDevice::getMemorySize() {
+	std::shared_lock<std::shared_mutex> lock(chunksLatch);
+	return chunks.size() * MEMORY_CHUNK_SIZE;
+}
+
+
+/**
+*
+*  @brief Allocates zero filled chunks up to the end offset
+*
+*  @param endOffset - end offset of written range
+*
+*/
+void MemoryDevice::growChunks(size_t endOffset) {
+	size_t chunksCount = (endOffset + MEMORY_CHUNK_SIZE - 1) / MEMORY_CHUNK_SIZE;
+	{
+		std::shared_lock<std::shared_mutex> lock(chunksLatch);
+		if (chunks.size() >= chunksCount) return;
+	}
+	std::unique_lock<std::shared_mutex> lock(chunksLatch);
+	chunks.reserve(chunksCount);
+	while (chunks.size() < chunksCount) {
+		chunks.push_back(new uint8_t[MEMORY_CHUNK_SIZE]());
+	}
+}
@@ -0,0 +1,98 @@
+/******************************************************************************
+*
+*  PinnedPage class implementation
+*
+*  PinnedPage is move only handle of pinned cache page. It gives direct
+*  read access to the cached page data without copying to user buffer.
+*  Page stays in cache while handle is alive, page is unpinned when
+*  handle is released, destroyed or assigned. Handles of mapped file
+*  point to mapped memory and have no cache page to unpin.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+using namespace Boson;
+
+
+/**
+* @brief Empty (not pinned) handle constructor
+*/
+PinnedPage::PinnedPage() {
+	this->file = nullptr;
+	this->page = nullptr;
+	this->dataPointer = nullptr;
+	this->dataLength = 0;
+}
+
+
+/**
+* @brief Pinned handle constructor (page pin count is incremented by caller)
+* @param file - cached file of the page
+* @param page - pinned cache page
+* @param data - pointer to requested data in the page
+* @param length - requested data length
+*/
+PinnedPage::PinnedPage(CachedFileIO* file, CachePage* page, const uint8_t* data, size_t length) {
+	this->file = file;
+	this->page = page;
+	this->dataPointer = data;
+	this->dataLength = length;
+}
+
+
+/**
+* @brief Move constructor: takes over the pin
+*/
+PinnedPage::PinnedPage(PinnedPage&& other) noexcept {
+	this->file = other.file;
+	this->page = other.page;
+	this->dataPointer = other.dataPointer;
+	this->dataLength = other.dataLength;
+	other.file = nullptr;
+	other.page = nullptr;
+	other.dataPointer = nullptr;
+	other.dataLength = 0;
+}
+
+
+/**
+* @brief Move assignment: releases own pin and takes over the other pin
+*/
+PinnedPage& PinnedPage::operator=(PinnedPage&& other) noexcept {
+	if (this != &other) {
+		release();
+		this->file = other.file;
+		this->page = other.page;
+		this->dataPointer = other.dataPointer;
+		this->dataLength = other.dataLength;
+		other.file = nullptr;
+		other.page = nullptr;
+		other.dataPointer = nullptr;
+		other.dataLength = 0;
+	}
+	return *this;
+}
+
+
+/**
+* @brief Destructor unpins page
+*/
+PinnedPage::~PinnedPage() {
+	release();
+}
+
+
+/**
+* @brief Unpins page, so it can be evicted from cache
+*/
+void PinnedPage::release() {
+	if (dataPointer == nullptr) return;
+	if (page != nullptr) file->unpin(page);
+	file = nullptr;
+	page = nullptr;
+	dataPointer = nullptr;
+	dataLength = 0;
+}
@@ -5,15 +5,39 @@
 *  RecordFileIO is designed for seamless storage of binary records of
 *  arbitary size (max record size limited to 4Gb), accessing records as
 *  linked list and reuse space of deleted records. RecordFileIO uses
-*  CachedFileIO to cache frequently accessed data and win IO performance.
+*  CachedFileIO to cache frequently accessed data and win IO performance
+*  (or MappedFileIO, any FileIO storage implementation).
 *
 *  Features:
 *    - create/read/update/delete records of arbitrary size (up to 4Gb)
 *    - navigate records: first, last, next, previous, exact position
-*    - reuse space of deleted records
+*    - reuse space of deleted records (best fit from size class skip lists)
+*    - merge adjacent deleted records, trim deleted records at end of file
+*    - split oversized deleted records on reuse
+*    - move records to free space below given offset, shrink file (compaction)
 *    - data consistency check (checksum)
+*    - zero-copy access to records that fit in one cache page
 *
-*  (C) Boson Database, Bolat Basheyev 2022-2023
+*  Deleted records are kept in size classes (4 classes per power of 2),
+*  every class is skip list of free records ordered by capacity, heads of
+*  lists are in the free space index record. Allocation takes the tightest
+*  fitting record of requested capacity class in O(log n), or the first
+*  (smallest) record of the next non empty class found in bitmap.
+*
+*  Released record is merged with physically adjacent free records: the
+*  next one starts right after its capacity, the previous one is found by
+*  boundary tag - last 8 bytes of every free record keep its own offset.
+*  Free record that ends at the end of file is cut off from the file.
+*  Allocated free record is split if the rest has FREE_SPLIT_MINIMUM bytes
+*  of capacity, the rest is released as any deleted record.
+*
+*  Compaction moves record to free record below given offset (compact size
+*  of the file), owner of the record updates references to it. Free lists
+*  are ordered by capacity, so besides them the file is scanned from the
+*  beginning for the first fitting free record, scan resumes where previous
+*  lookup stopped. File is truncated at the end of the last record.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
 *
 ******************************************************************************/
 
@@ -23,30 +47,32 @@
 #include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <cstddef>
 
 using namespace Boson;
 
 /*
 * 
 * @brief RecordFileIO constructor and initializations
-* @param[in] cachedFile - reference to cached file object
-* @param[in] freeDepth - free record lookup maximum iterations (unlim by default)
+* @param[in] storageFile - reference to storage file object (cached or mapped)
 * 
 */
-RecordFileIO::RecordFileIO(CachedFileIO& cachedFile, size_t freeDepth) : cachedFile(cachedFile) {
+RecordFileIO::RecordFileIO(FileIO& storageFile) : storageFile(storageFile) {
 	// Check if file is open
-	if (!cachedFile.isOpen()) {
+	if (!storageFile.isOpen()) {
 		const char* msg = "ERROR: Can't operate on closed file.\n";
 		std::cerr << msg;
 		throw std::runtime_error(msg);
 	}
 	// Initialize internal data structures and variables to zero
 	memset(&storageHeader, 0, sizeof StorageHeader);
+	memset(&freeSpace, 0, sizeof FreeSpaceIndex);
 	memset(&recordHeader, 0, sizeof RecordHeader);
 	currentPosition = NOT_FOUND;
-	freeLookupDepth = freeDepth;
+	accessHint = AccessHint::NORMAL;
+	compactScanOffset = NOT_FOUND;
 	// If file is empty and write is permitted, then write storage header
-	if (cachedFile.getFileSize() == 0 && !cachedFile.isReadOnly()) {
+	if (storageFile.getFileSize() == 0 && !storageFile.isReadOnly()) {
 		initStorageHeader();
 	}
 	// Try to load storage header
@@ -65,9 +91,9 @@ RecordFileIO::RecordFileIO(CachedFileIO& cachedFile, size_t freeDepth) : cachedF
 *
 */
 RecordFileIO::~RecordFileIO() {
-	if (!cachedFile.isOpen()) return;	
+	if (!storageFile.isOpen()) return;	
 	persistStorageHeader();
-	cachedFile.flush();
+	storageFile.flush();
 }
 
 
@@ -76,7 +102,7 @@ RecordFileIO::~RecordFileIO() {
 * @return true if file is open, or false otherwise
 */
 bool RecordFileIO::isOpen() {
-	return cachedFile.isOpen();
+	return storageFile.isOpen();
 }
 
 
@@ -104,6 +130,67 @@ uint64_t RecordFileIO::getTotalFreeRecords() {
 
 
 
+/*
+*
+* @brief Get total capacity of free (released) records
+* @return total capacity of free records in bytes
+*
+*/
+uint64_t RecordFileIO::getFreeSpaceBytes() {
+	return freeSpace.freeBytes;
+}
+
+
+
+/*
+*
+* @brief Get total data length of records
+* @return total data length of records in bytes
+*
+*/
+uint64_t RecordFileIO::getDataBytes() {
+	return freeSpace.dataBytes;
+}
+
+
+
+/*
+*
+* @brief Get total capacity of records
+* @return total capacity of records in bytes
+*
+*/
+uint64_t RecordFileIO::getRecordBytes() {
+	return freeSpace.recordBytes;
+}
+
+
+
+/*
+*
+* @brief Get internal fragmentation: capacity of records not used by data
+* @return average unused capacity per record in bytes
+*
+*/
+double RecordFileIO::getInternalFragmentation() {
+	if (storageHeader.totalRecords == 0) return 0;
+	return double(freeSpace.recordBytes - freeSpace.dataBytes) / double(storageHeader.totalRecords);
+}
+
+
+
+/*
+*
+* @brief Get end of the last record in storage file
+* @return offset of records end in bytes
+*
+*/
+uint64_t RecordFileIO::getEndOfFile() {
+	return storageHeader.endOfFile;
+}
+
+
+
 /*
 *
 * @brief Set cursor position
@@ -112,7 +199,7 @@ uint64_t RecordFileIO::getTotalFreeRecords() {
 *
 */
 bool RecordFileIO::setPosition(uint64_t offset) {
-	if (!cachedFile.isOpen()) return false;	
+	if (!storageFile.isOpen()) return false;	
 	// Try to read record header
 	RecordHeader header;
 	if (getRecordHeader(offset, header)==NOT_FOUND) return false;
@@ -132,7 +219,7 @@ bool RecordFileIO::setPosition(uint64_t offset) {
 *
 */
 uint64_t RecordFileIO::getPosition() {
-	if (!cachedFile.isOpen()) return NOT_FOUND;
+	if (!storageFile.isOpen()) return NOT_FOUND;
 	return currentPosition;
 }
 
@@ -145,7 +232,7 @@ uint64_t RecordFileIO::getPosition() {
 *
 */
 bool RecordFileIO::first() {
-	if (!cachedFile.isOpen()) return false;
+	if (!storageFile.isOpen()) return false;
 	if (storageHeader.firstRecord == NOT_FOUND) return false;
 	return setPosition(storageHeader.firstRecord);
 }
@@ -159,7 +246,7 @@ bool RecordFileIO::first() {
 *
 */
 bool RecordFileIO::last() {
-	if (!cachedFile.isOpen()) return false;
+	if (!storageFile.isOpen()) return false;
 	if (storageHeader.lastRecord == NOT_FOUND) return false;
 	return setPosition(storageHeader.lastRecord);
 }
@@ -173,7 +260,7 @@ bool RecordFileIO::last() {
 *
 */
 bool RecordFileIO::next() {
-	if (!cachedFile.isOpen() || currentPosition==NOT_FOUND) return false;
+	if (!storageFile.isOpen() || currentPosition==NOT_FOUND) return false;
 	if (recordHeader.next == NOT_FOUND) return false;
 	return setPosition(recordHeader.next);
 }
@@ -187,7 +274,7 @@ bool RecordFileIO::next() {
 * 
 */
 bool RecordFileIO::previous() {
-	if (!cachedFile.isOpen() || currentPosition == NOT_FOUND) return false;
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND) return false;
 	if (recordHeader.previous == NOT_FOUND) return false;
 	return setPosition(recordHeader.previous);
 }
@@ -206,7 +293,7 @@ bool RecordFileIO::previous() {
 *
 */
 uint64_t RecordFileIO::createRecord(const void* data, uint32_t length) {
-	if (!cachedFile.isOpen() || cachedFile.isReadOnly()) return NOT_FOUND;
+	if (!storageFile.isOpen() || storageFile.isReadOnly()) return NOT_FOUND;
 	// find free record of required length or create new one
 	RecordHeader newRecordHeader;
 	uint64_t offset = allocateRecord(length, newRecordHeader);
@@ -215,21 +302,18 @@ uint64_t RecordFileIO::createRecord(const void* data, uint32_t length) {
 		return NOT_FOUND;
 	}
 	
-	// Fill record header fields and link to previous record	
-	newRecordHeader.next = NOT_FOUND;                       
+	// Fill record header fields and link to the last record (writes header)
 	newRecordHeader.dataLength = length;
 	newRecordHeader.dataChecksum = checksum((uint8_t*) data, length);
-	uint32_t headerDataLength = sizeof RecordHeader - sizeof newRecordHeader.headChecksum;
-	newRecordHeader.headChecksum = checksum((uint8_t*)&newRecordHeader, headerDataLength);
+	linkRecord(offset, newRecordHeader);
 
 	// copy to working record
 	memcpy(&recordHeader, &newRecordHeader, sizeof RecordHeader);
 	currentPosition = offset;
 
-	// Write record header and data to the storage file
+	// Write record data to the storage file
 	constexpr uint64_t HEADER_SIZE = sizeof RecordHeader;
-	cachedFile.write(currentPosition, &recordHeader, HEADER_SIZE);
-	cachedFile.write(currentPosition + HEADER_SIZE, data, length);
+	storageFile.write(currentPosition + HEADER_SIZE, data, length);
 
 	// Return offset of new record
 	return offset;
@@ -247,7 +331,7 @@ uint64_t RecordFileIO::createRecord(const void* data, uint32_t length) {
 */
 uint64_t RecordFileIO::removeRecord() {
 
-	if (!cachedFile.isOpen() || cachedFile.isReadOnly() || currentPosition == NOT_FOUND) return NOT_FOUND;
+	if (!storageFile.isOpen() || storageFile.isReadOnly() || currentPosition == NOT_FOUND) return NOT_FOUND;
 
 #ifdef _DEBUG
 	std::cout << "RecordFileIO: removing record at " << currentPosition << std::endl;
@@ -298,6 +382,8 @@ uint64_t RecordFileIO::removeRecord() {
 	}
 	// Update storage header information about total records number
 	storageHeader.totalRecords--;
+	freeSpace.recordBytes -= recordHeader.recordCapacity;
+	freeSpace.dataBytes -= recordHeader.dataLength;
 	persistStorageHeader();
 	return returnOffset;
 }
@@ -311,7 +397,7 @@ uint64_t RecordFileIO::removeRecord() {
 *
 */
 uint32_t RecordFileIO::getDataLength() {
-	if (!cachedFile.isOpen() || currentPosition == NOT_FOUND) return 0;
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND) return 0;
 	return recordHeader.dataLength;
 }
 
@@ -324,7 +410,7 @@ uint32_t RecordFileIO::getDataLength() {
 *
 */
 uint32_t RecordFileIO::getRecordCapacity() {
-	if (!cachedFile.isOpen() || currentPosition == NOT_FOUND) return 0;
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND) return 0;
 	return recordHeader.recordCapacity;
 }
 
@@ -337,7 +423,7 @@ uint32_t RecordFileIO::getRecordCapacity() {
 *
 */
 uint64_t RecordFileIO::getNextPosition() {
-	if (!cachedFile.isOpen() || currentPosition == NOT_FOUND) return NOT_FOUND;
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND) return NOT_FOUND;
 	return recordHeader.next;
 }
 
@@ -350,7 +436,7 @@ uint64_t RecordFileIO::getNextPosition() {
 *
 */
 uint64_t RecordFileIO::getPrevPosition() {
-	if (!cachedFile.isOpen() || currentPosition == NOT_FOUND) return NOT_FOUND;
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND) return NOT_FOUND;
 	return recordHeader.previous;
 }
 
@@ -367,10 +453,10 @@ uint64_t RecordFileIO::getPrevPosition() {
 *
 */
 uint64_t RecordFileIO::getRecordData(void* data, uint32_t length) {
-	if (!cachedFile.isOpen() || currentPosition == NOT_FOUND || length==0) return NOT_FOUND;
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND || length==0) return NOT_FOUND;
 	uint64_t bytesToRead = std::min(recordHeader.dataLength, length);
 	uint64_t dataOffset = currentPosition + sizeof RecordHeader;
-	cachedFile.read(dataOffset, data, bytesToRead);
+	storageFile.read(dataOffset, data, bytesToRead, accessHint);
 	// check data consistency by checksum
 	uint32_t dataCheckSum = checksum((uint8_t*)data, bytesToRead);
 	if (dataCheckSum != recordHeader.dataChecksum) return NOT_FOUND;
@@ -379,6 +465,28 @@ uint64_t RecordFileIO::getRecordData(void* data, uint32_t length) {
 
 
 
+/*
+*
+* @brief Pins record data in current position for reading without copying
+* and checks consistency
+*
+* @return pinned record data or not pinned handle if record data crosses
+* cache page boundary or data is corrupted (use getRecordData then)
+*
+*/
+PinnedPage RecordFileIO::pinRecordData() {
+	if (!storageFile.isOpen() || currentPosition == NOT_FOUND) return PinnedPage();
+	uint64_t dataOffset = currentPosition + sizeof RecordHeader;
+	PinnedPage pinnedData = storageFile.pin(dataOffset, recordHeader.dataLength, accessHint);
+	if (!pinnedData.isPinned()) return pinnedData;
+	// check data consistency by checksum
+	uint32_t dataCheckSum = checksum(pinnedData.data(), pinnedData.length());
+	if (dataCheckSum != recordHeader.dataChecksum) return PinnedPage();
+	return pinnedData;
+}
+
+
+
 /*
 *
 * @brief Updates record's data in current position.
@@ -393,11 +501,16 @@ uint64_t RecordFileIO::getRecordData(void* data, uint32_t length) {
 *
 */
 uint64_t RecordFileIO::setRecordData(const void* data, uint32_t length) {
-	if (!cachedFile.isOpen() || cachedFile.isReadOnly() || 
+	if (!storageFile.isOpen() || storageFile.isReadOnly() || 
 		currentPosition == NOT_FOUND) return NOT_FOUND;
 	// if there is enough capacity in record
 	if (length <= recordHeader.recordCapacity) {
+		// Release unused capacity of shrunk record
+		uint32_t oldCapacity = recordHeader.recordCapacity;
+		splitRecord(currentPosition, recordHeader, alignCapacity(length));
+		freeSpace.recordBytes = freeSpace.recordBytes - oldCapacity + recordHeader.recordCapacity;
 		// Update header data length info without affecting ID
+		freeSpace.dataBytes = freeSpace.dataBytes - recordHeader.dataLength + length;
 		recordHeader.dataLength = length;
 		// Update checksum
 		recordHeader.dataChecksum = checksum((uint8_t*)data, length);
@@ -405,9 +518,9 @@ uint64_t RecordFileIO::setRecordData(const void* data, uint32_t length) {
 		recordHeader.headChecksum = checksum((uint8_t*) &recordHeader, headerLength);
 		// Write record header and data to the storage file
 		constexpr uint64_t HEADER_SIZE = sizeof RecordHeader;
-		cachedFile.write(currentPosition, &recordHeader, HEADER_SIZE);
-		cachedFile.write(currentPosition + HEADER_SIZE, data, length);
-
+		storageFile.write(currentPosition, &recordHeader, HEADER_SIZE);
+		storageFile.write(currentPosition + HEADER_SIZE, data, length);
+		persistStorageHeader();
 		return currentPosition;
 	}
 
@@ -421,20 +534,18 @@ uint64_t RecordFileIO::setRecordData(const void* data, uint32_t length) {
 	newRecordHeader.previous = recordHeader.previous;
 	newRecordHeader.dataLength = length;
 	newRecordHeader.dataChecksum = checksum((uint8_t*)data, length);
-	uint32_t headerLength = sizeof RecordHeader - sizeof newRecordHeader.headChecksum;
-	newRecordHeader.headChecksum = checksum((uint8_t*)&newRecordHeader, headerLength);
+	// Write record header and data to the storage file
+	constexpr uint64_t HEADER_SIZE = sizeof RecordHeader;
+	putRecordHeader(offset, newRecordHeader);
+	storageFile.write(offset + HEADER_SIZE, data, length);
+
+	// Link siblings (or storage header) to the new record position
+	relinkRecord(recordHeader, offset);
+	freeSpace.recordBytes = freeSpace.recordBytes - recordHeader.recordCapacity + newRecordHeader.recordCapacity;
+	freeSpace.dataBytes = freeSpace.dataBytes - recordHeader.dataLength + length;
 
 	// Delete old record and add it to the free records list
 	if (!putToFreeList(currentPosition)) return NOT_FOUND;
-	// if this is first record, then update storage header
-	if (recordHeader.previous == NOT_FOUND) {
-		storageHeader.firstRecord = offset;
-		persistStorageHeader();
-	};
-	// Write record header and data to the storage file
-	constexpr uint64_t HEADER_SIZE = sizeof RecordHeader;
-	cachedFile.write(offset, &newRecordHeader, HEADER_SIZE);
-	cachedFile.write(offset + HEADER_SIZE, data, length);
 	// Update current record in memory
 	memcpy(&recordHeader, &newRecordHeader, HEADER_SIZE);
 	// Set cursor to new updated position
@@ -444,6 +555,102 @@ uint64_t RecordFileIO::setRecordData(const void* data, uint32_t length) {
 
 
 
+/*
+*
+* @brief Moves record to free record below the limit offset (compaction),
+* if there is no such free record - to the largest free record if it is
+* below the record. Record capacity shrinks to its data length, siblings
+* are relinked to the new position and old record space is released.
+* Cursor follows the record if it points to it.
+*
+* @param[in] offset - position of live record (or free space index record)
+* @param[in] limit - target end of records (compact size of the file)
+*
+* @return new record position, the same position if there is no suitable
+* free record or NOT_FOUND if record can't be moved
+*
+*/
+uint64_t RecordFileIO::moveRecord(uint64_t offset, uint64_t limit) {
+	if (!storageFile.isOpen() || storageFile.isReadOnly()) return NOT_FOUND;
+	RecordHeader header;
+	if (getRecordHeader(offset, header) == NOT_FOUND) return NOT_FOUND;
+	bool isIndex = (offset == storageHeader.freeSpaceIndex);
+	if (!isIndex && isFreeRecord(offset, header)) return NOT_FOUND;
+
+	// free record below the limit and below the record
+	uint32_t capacity = alignCapacity(header.dataLength);
+	uint64_t newOffset = findFreeRecordBelow(capacity, std::min(limit, offset));
+	// otherwise the largest free record (gap left by moved records)
+	// if it is closer to the beginning of file
+	if (newOffset == NOT_FOUND) newOffset = getLargestFreeRecord(capacity);
+	if (newOffset == NOT_FOUND || newOffset > offset) return offset;
+	RecordHeader newHeader;
+	if (takeFreeRecord(newOffset, capacity, newHeader) == NOT_FOUND) return NOT_FOUND;
+	newHeader.next = header.next;
+	newHeader.previous = header.previous;
+	newHeader.dataLength = header.dataLength;
+	newHeader.dataChecksum = header.dataChecksum;
+	putRecordHeader(newOffset, newHeader);
+
+	if (isIndex) {
+		// write in memory free space index to the new place
+		storageHeader.freeSpaceIndex = newOffset;
+		persistFreeSpace(&freeSpace, sizeof FreeSpaceIndex);
+	} else {
+		if (!copyRecordData(offset, newOffset, header.dataLength)) return NOT_FOUND;
+		relinkRecord(header, newOffset);
+		freeSpace.recordBytes = freeSpace.recordBytes - header.recordCapacity + newHeader.recordCapacity;
+	}
+	if (currentPosition == offset) {
+		memcpy(&recordHeader, &newHeader, sizeof RecordHeader);
+		currentPosition = newOffset;
+	}
+
+	// release old record space
+	if (!putToFreeList(offset)) return NOT_FOUND;
+	return newOffset;
+}
+
+
+
+/*
+*
+* @brief Get file size if all records were packed at the beginning of file
+* @return size of storage header, free space index and records in bytes
+*
+*/
+uint64_t RecordFileIO::getCompactSize() {
+	uint64_t indexLength = sizeof(RecordHeader) + alignCapacity(sizeof FreeSpaceIndex);
+	uint64_t headersLength = storageHeader.totalRecords * sizeof(RecordHeader);
+	return sizeof(StorageHeader) + indexLength + headersLength + freeSpace.recordBytes;
+}
+
+
+
+/*
+*
+* @brief Moves free space index located beyond compact size of the file
+* below it if there is free space and cuts off storage file beyond the
+* last record
+* @return bytes released to file system
+*
+*/
+uint64_t RecordFileIO::shrinkFile() {
+	if (!storageFile.isOpen() || storageFile.isReadOnly()) return 0;
+	uint64_t compactSize = getCompactSize();
+	if (storageHeader.freeSpaceIndex != NOT_FOUND &&
+		storageHeader.freeSpaceIndex >= compactSize) {
+		moveRecord(storageHeader.freeSpaceIndex, compactSize);
+	}
+	storageFile.flush();
+	uint64_t fileSize = storageFile.getFileSize();
+	if (fileSize <= storageHeader.endOfFile) return 0;
+	if (!storageFile.truncate(storageHeader.endOfFile)) return 0;
+	return fileSize - storageHeader.endOfFile;
+}
+
+
+
 //=============================================================================
 // 
 // 
@@ -460,6 +667,7 @@ void RecordFileIO::initStorageHeader() {
 	
 	storageHeader.signature = BOSONDB_SIGNATURE;
 	storageHeader.version = BOSONDB_VERSION;
+	storageHeader.pageSizeKb = uint16_t(storageFile.getPageSize() / 1024);
 	storageHeader.endOfFile = sizeof StorageHeader;
 
 	storageHeader.totalRecords = 0;
@@ -467,9 +675,12 @@ void RecordFileIO::initStorageHeader() {
 	storageHeader.lastRecord = NOT_FOUND;
 
 	storageHeader.totalFreeRecords = 0;
-	storageHeader.firstFreeRecord = NOT_FOUND;
-	storageHeader.lastFreeRecord = NOT_FOUND;
+	storageHeader.freeSpaceIndex = NOT_FOUND;
+	storageHeader.reserved = 0;
 
+	// Free space index record goes right after storage header
+	resetFreeSpaceIndex();
+	createFreeSpaceIndex();
 	persistStorageHeader();
 
 }
@@ -477,14 +688,16 @@ void RecordFileIO::initStorageHeader() {
 
 
 /*
-*  @brief Saves in memory storage header to the file storage
+*  @brief Saves in memory storage header and space counters to the file storage
 *  @return true - if succeeded, false - if failed
 */
 bool RecordFileIO::persistStorageHeader() {
-	if (!cachedFile.isOpen()) return false;
-	uint64_t bytesWritten = cachedFile.write(0, &storageHeader, sizeof StorageHeader);
+	if (!storageFile.isOpen()) return false;
+	uint64_t bytesWritten = storageFile.write(0, &storageHeader, sizeof StorageHeader);
 	// check read success
 	if (bytesWritten != sizeof StorageHeader) return false;
+	// space counters are at the beginning of free space index
+	persistFreeSpace(&freeSpace, offsetof(FreeSpaceIndex, nonEmptyClasses));
 	return true;
 }
 
@@ -495,33 +708,177 @@ bool RecordFileIO::persistStorageHeader() {
 *  @return true - if succeeded, false - if failed
 */
 bool RecordFileIO::loadStorageHeader() {
-	if (!cachedFile.isOpen()) return false;
+	if (!storageFile.isOpen()) return false;
 	StorageHeader sh;
-	uint64_t bytesRead = cachedFile.read(0, &sh, sizeof StorageHeader);
+	uint64_t bytesRead = storageFile.read(0, &sh, sizeof StorageHeader);
 	// check read success
 	if (bytesRead != sizeof StorageHeader) return false;  
 	// check signature and version
 	if (sh.signature != BOSONDB_SIGNATURE) return false;
-	if (sh.version != BOSONDB_VERSION) return false;
+	if (sh.version == 0 || sh.version > BOSONDB_VERSION) return false;
+	// Switch storage to page size of the database (version 1 has default)
+	size_t pageSize = (sh.pageSizeKb == 0) ? PAGE_SIZE : size_t(sh.pageSizeKb) * 1024;
+	if (!storageFile.setPageSize(pageSize)) return false;
 	// Copy header data to internal structure
 	memcpy(&storageHeader, &sh, sizeof StorageHeader);
-	return true;
+	// Free space of previous versions is indexed on first writable open
+	if (sh.version < BOSONDB_VERSION) {
+		uint64_t staleIndex = (sh.version >= 3) ? sh.freeSpaceIndex : NOT_FOUND;
+		storageHeader.freeSpaceIndex = NOT_FOUND;
+		if (storageFile.isReadOnly()) return true;
+		return rebuildFreeSpaceIndex(staleIndex);
+	}
+	return loadFreeSpaceIndex();
+}
+
+
+
+/*
+*  @brief Clears in memory free space index: no free records, zero counters
+*/
+void RecordFileIO::resetFreeSpaceIndex() {
+	memset(&freeSpace, 0, sizeof FreeSpaceIndex);
+	for (uint32_t i = 0; i < FREE_SIZE_CLASSES; i++) {
+		freeSpace.classHead[i] = NOT_FOUND;
+		for (uint32_t level = 1; level < FREE_SKIP_LEVELS; level++) freeSpace.classTower[i][level - 1] = NOT_FOUND;
+	}
+}
+
+
+
+/*
+*  @brief Appends free space index record to the end of file and writes
+*  in memory free space index to it
+*  @return offset of free space index record
+*/
+uint64_t RecordFileIO::createFreeSpaceIndex() {
+	// index is updated in place field by field, so its data has no checksum
+	RecordHeader indexHeader;
+	indexHeader.next = NOT_FOUND;
+	indexHeader.previous = NOT_FOUND;
+	indexHeader.recordCapacity = alignCapacity(sizeof FreeSpaceIndex);
+	indexHeader.dataLength = sizeof FreeSpaceIndex;
+	indexHeader.dataChecksum = 0;
+	uint64_t offset = storageHeader.endOfFile;
+	putRecordHeader(offset, indexHeader);
+	storageHeader.endOfFile += sizeof(RecordHeader) + indexHeader.recordCapacity;
+	storageHeader.freeSpaceIndex = offset;
+	persistFreeSpace(&freeSpace, sizeof FreeSpaceIndex);
+	return offset;
+}
+
+
+
+/*
+*  @brief Loads free space index record referenced by storage header
+*  @return true - if succeeded, false - if failed
+*/
+bool RecordFileIO::loadFreeSpaceIndex() {
+	RecordHeader indexHeader;
+	uint64_t offset = storageHeader.freeSpaceIndex;
+	if (offset == NOT_FOUND || getRecordHeader(offset, indexHeader) == NOT_FOUND) return false;
+	if (indexHeader.dataLength != sizeof FreeSpaceIndex) return false;
+	uint64_t bytesRead = storageFile.read(offset + sizeof RecordHeader, &freeSpace, sizeof FreeSpaceIndex);
+	return bytesRead == sizeof FreeSpaceIndex;
+}
+
+
+
+/*
+*  @brief Creates free space index of database of previous version: walks
+*  records in physical order, merges runs of adjacent deleted records and
+*  puts them to size classes, trims deleted records at the end of file
+*  @param[in] staleIndex - free space index record of previous version (or NOT_FOUND)
+*  @return true - if succeeded, false - if records chain is corrupt
+*/
+bool RecordFileIO::rebuildFreeSpaceIndex(uint64_t staleIndex) {
+	uint64_t endOfRecords = storageHeader.endOfFile;
+	resetFreeSpaceIndex();
+	storageHeader.totalFreeRecords = 0;
+	storageHeader.reserved = 0;
+	RecordHeader header, runHeader;
+	uint64_t runOffset = NOT_FOUND;
+	uint64_t runCapacity = 0;
+	uint64_t offset = sizeof StorageHeader;
+	while (offset < endOfRecords) {
+		if (getRecordHeader(offset, header) == NOT_FOUND) return false;
+		uint64_t nextOffset = offset + sizeof(RecordHeader) + header.recordCapacity;
+		if (offset == staleIndex || (header.dataLength == 0 && header.dataChecksum == 0)) {
+			// append free record to the run if merged capacity fits
+			if (runOffset != NOT_FOUND && runCapacity + sizeof(RecordHeader) + header.recordCapacity <= UINT32_MAX) {
+				eraseRecordHeader(offset);
+				runCapacity += sizeof(RecordHeader) + header.recordCapacity;
+				offset = nextOffset;
+				continue;
+			}
+			if (runOffset != NOT_FOUND) {
+				runHeader.recordCapacity = uint32_t(runCapacity);
+				insertFreeRecord(runOffset, runHeader);
+			}
+			runOffset = offset;
+			runHeader = header;
+			runCapacity = header.recordCapacity;
+		} else {
+			if (runOffset != NOT_FOUND) {
+				runHeader.recordCapacity = uint32_t(runCapacity);
+				insertFreeRecord(runOffset, runHeader);
+				runOffset = NOT_FOUND;
+			}
+			freeSpace.recordBytes += header.recordCapacity;
+			freeSpace.dataBytes += header.dataLength;
+		}
+		offset = nextOffset;
+	}
+	// free records at the end of file are cut off
+	if (runOffset != NOT_FOUND) {
+		eraseRecordHeader(runOffset);
+		storageHeader.endOfFile = runOffset;
+	}
+	createFreeSpaceIndex();
+	storageHeader.version = BOSONDB_VERSION;
+	return persistStorageHeader();
+}
+
+
+
+/*
+*  @brief Writes field of in memory free space index to the index record
+*  @param[in] field - pointer to the field of freeSpace structure
+*  @param[in] length - field length in bytes
+*/
+void RecordFileIO::persistFreeSpace(const void* field, size_t length) {
+	if (storageHeader.freeSpaceIndex == NOT_FOUND) return;
+	uint64_t fieldOffset = (const uint8_t*)field - (const uint8_t*)&freeSpace;
+	uint64_t dataOffset = storageHeader.freeSpaceIndex + sizeof RecordHeader;
+	storageFile.write(dataOffset + fieldOffset, field, length);
 }
 
 
 
 /**
 *  @brief Read record header at the given file position
+
 *  @param[in] offset - record position in the file
 *  @param[out] result - user buffer to load record header
 *  @return record offset in file or NOT_FOUND if can't read
 */
 uint64_t RecordFileIO::getRecordHeader(uint64_t offset, RecordHeader& result) {
-	// Read header
-	uint64_t bytesRead = cachedFile.read(offset, &result, sizeof RecordHeader);
+	uint32_t headerDataLength = sizeof RecordHeader - sizeof result.headChecksum;
+	// Header within one cache page is checked in place and copied only if consistent
+	PinnedPage pinnedHeader = storageFile.pin(offset, sizeof RecordHeader, accessHint);
+	if (pinnedHeader.isPinned()) {
+		// header of record of previous versions (or boundary tag guess) may be unaligned
+		uint32_t headChecksum;
+		memcpy(&headChecksum, pinnedHeader.data() + headerDataLength, sizeof headChecksum);
+		uint32_t expectedChecksum = checksum(pinnedHeader.data(), headerDataLength);
+		if (expectedChecksum != headChecksum) return NOT_FOUND;
+		memcpy(&result, pinnedHeader.data(), sizeof RecordHeader);
+		return offset;
+	}
+	// Read header crossing page boundary
+	uint64_t bytesRead = storageFile.read(offset, &result, sizeof RecordHeader, accessHint);
 	if (bytesRead != sizeof RecordHeader) return NOT_FOUND;
 	// Check data consistency
-	uint32_t headerDataLength = sizeof RecordHeader - sizeof result.headChecksum;
 	uint32_t expectedChecksum = checksum((uint8_t*)&result, headerDataLength);
 	if (expectedChecksum != result.headChecksum) return NOT_FOUND;
 	return offset;
@@ -540,62 +897,91 @@ uint64_t RecordFileIO::putRecordHeader(uint64_t offset, RecordHeader& header) {
 	uint32_t headerDataLength = sizeof RecordHeader - sizeof header.headChecksum;
 	header.headChecksum = checksum((uint8_t*)&header, headerDataLength);
 	// write data
-	uint64_t bytesWritten = cachedFile.write(offset, &header, sizeof RecordHeader);
+	uint64_t bytesWritten = storageFile.write(offset, &header, sizeof RecordHeader);
 	if (bytesWritten != sizeof RecordHeader) return NOT_FOUND;
 	// return header offset in file
 	return offset;
 }
 
 
+
+/**
+*  @brief Overwrites record header with zeros (fails checksum), so header
+*  of record merged into adjacent free record never looks valid
+*  @param[in] offset - record position in the file
+*/
+void RecordFileIO::eraseRecordHeader(uint64_t offset) {
+	RecordHeader zeroHeader;
+	memset(&zeroHeader, 0, sizeof RecordHeader);
+	storageFile.write(offset, &zeroHeader, sizeof RecordHeader);
+}
+
+
+
+/**
+*  @brief Checks if record is free (free space index record is never free)
+*/
+bool RecordFileIO::isFreeRecord(uint64_t offset, const RecordHeader& header) {
+	return offset != storageHeader.freeSpaceIndex && header.dataLength == 0 && header.dataChecksum == 0;
+}
+
+
+
+/**
+*  @brief Finds free record that physically precedes given record by the
+*  boundary tag (offset of free record in its last 8 bytes)
+*  @param[in] offset - record position in the file
+*  @param[out] result - header of preceding free record
+*  @return offset of preceding free record or NOT_FOUND
+*/
+uint64_t RecordFileIO::getPreviousFreeRecord(uint64_t offset, RecordHeader& result) {
+	if (offset < sizeof StorageHeader + sizeof RecordHeader + sizeof(uint64_t)) return NOT_FOUND;
+	uint64_t tag = NOT_FOUND;
+	uint64_t bytesRead = storageFile.read(offset - sizeof(uint64_t), &tag, sizeof(uint64_t), accessHint);
+	if (bytesRead != sizeof(uint64_t)) return NOT_FOUND;
+	// tag of live record is arbitrary data, so tagged record must be free and end here
+	if (tag < sizeof StorageHeader || tag >= offset) return NOT_FOUND;
+	if (getRecordHeader(tag, result) == NOT_FOUND || !isFreeRecord(tag, result)) return NOT_FOUND;
+	if (tag + sizeof(RecordHeader) + result.recordCapacity != offset) return NOT_FOUND;
+	return tag;
+}
+
+
 /*
 * 
-*  @brief Allocates new record from free records list or appends to the ond of file
+*  @brief Allocates record space from free lists or appends it to the end of file,
+*  record is not linked to records list
 *  @param[in] capacity - requested capacity of record
-*  @param[out] result  - record header of created new record
+*  @param[out] result  - record header of allocated record
 *  @return offset of record in the storage file
 */
 uint64_t RecordFileIO::allocateRecord(uint32_t capacity, RecordHeader& result) {
-
-	// if there is no free records yet
-	if (storageHeader.firstFreeRecord == NOT_FOUND && storageHeader.lastRecord == NOT_FOUND) {
-		// if there is no records at all create first record
-		return createFirstRecord(capacity, result);
-	} else {
-		// look up free list for record of suitable capacity
-		uint64_t offset = getFromFreeList(capacity, result);
-		// if found, then just return it
-		if (offset != NOT_FOUND) return offset;
-	}
-
+	capacity = alignCapacity(capacity);
+	// look up free lists for record of suitable capacity
+	uint64_t offset = getFromFreeList(capacity, result);
+	// if found, then just return it
+	if (offset != NOT_FOUND) return offset;
 	// if there is no free records, append to the end of file	
 	return appendNewRecord(capacity, result);
-
 }
 
 
+
 /*
 *
-*  @brief Creates first record in database
+*  @brief Allocates record space in the end of storage file
 *  @param[in] capacity - requested capacity of record
-*  @param[out] result  - record header of created new record
+*  @param[out] result  - record header of allocated record
 *  @return offset of record in the storage file
 */
-uint64_t RecordFileIO::createFirstRecord(uint32_t capacity, RecordHeader& result) {
-	// clear record header
-	memset(&result, 0, sizeof RecordHeader);
-	// set value to capacity
+uint64_t RecordFileIO::appendNewRecord(uint32_t capacity, RecordHeader& result) {
+	uint64_t offset = storageHeader.endOfFile;
 	result.next = NOT_FOUND;
 	result.previous = NOT_FOUND;
 	result.recordCapacity = capacity;
 	result.dataLength = 0;
-	// calculate offset right after Storage header
-	uint64_t offset = sizeof StorageHeader;
-	storageHeader.firstRecord = offset;
-    storageHeader.lastRecord = offset;
+	result.dataChecksum = 0;
 	storageHeader.endOfFile += sizeof(RecordHeader) + capacity;
-	storageHeader.totalRecords++;
-	persistStorageHeader();
-	
 	return offset;
 }
 
@@ -603,189 +989,537 @@ uint64_t RecordFileIO::createFirstRecord(uint32_t capacity, RecordHeader& result
 
 /*
 *
-*  @brief Creates record in the end of storage file
+*  @brief Allocates record space from free lists (previously deleted records):
+*  takes the tightest fitting record of requested capacity size class, if
+*  there is no such record, the smallest record of next non empty size class
 *  @param[in] capacity - requested capacity of record
-*  @param[out] result  - record header of created new record
-*  @return offset of record in the storage file
+*  @param[out] result  - record header of allocated record
+*  @return offset of record in the storage file or NOT_FOUND
 */
-uint64_t RecordFileIO::appendNewRecord(uint32_t capacity, RecordHeader& result) {
+uint64_t RecordFileIO::getFromFreeList(uint32_t capacity, RecordHeader& result) {
+
+	if (storageHeader.totalFreeRecords == 0) return NOT_FOUND;
+
+	uint32_t sizeClass = getSizeClass(capacity);
+	uint64_t offset = NOT_FOUND;
+
+	// first record of size class not less than requested capacity
+	if (freeSpace.classHead[sizeClass] != NOT_FOUND) {
+		uint64_t preds[FREE_SKIP_LEVELS];
+		RecordHeader predHeaders[FREE_SKIP_LEVELS];
+		findFreePredecessors(sizeClass, capacity, 0, preds, predHeaders);
+		offset = getFreeLink(sizeClass, preds[0], predHeaders[0], 0);
+	}
+
+	// find next non empty size class in bitmap, its first record is the smallest
+	uint32_t nextClass = sizeClass + 1;
+	for (uint32_t word = nextClass / 64; word < FREE_CLASS_WORDS && offset == NOT_FOUND; word++) {
+		uint64_t bits = freeSpace.nonEmptyClasses[word];
+		if (word == nextClass / 64) bits &= ~0ull << (nextClass % 64);
+		if (bits == 0) continue;
+		uint32_t bit = 0;
+		while ((bits & 1) == 0) { bits >>= 1; bit++; }
+		offset = freeSpace.classHead[word * 64 + bit];
+	}
+	if (offset == NOT_FOUND) return NOT_FOUND;
+	return takeFreeRecord(offset, capacity, result);
+}
+
+
+
+/*
+*
+*  @brief Looks up free record of requested capacity that starts below the
+*  limit offset: tightest fitting records of own size class, heads of larger
+*  size classes, then first fit of physical scan from the last scan position
+*  up to the limit. Lookup reads up to COMPACT_CLASS_DEPTH plus
+*  COMPACT_LOOKUP_DEPTH record headers.
+*  @param[in] capacity - requested aligned capacity
+*  @param[in] limit - free record must start below this offset
+*  @return offset of free record or NOT_FOUND
+*/
+uint64_t RecordFileIO::findFreeRecordBelow(uint32_t capacity, uint64_t limit) {
+	if (storageHeader.totalFreeRecords == 0) return NOT_FOUND;
+
+	uint32_t sizeClass = getSizeClass(capacity);
+	uint64_t offset = NOT_FOUND;
+	RecordHeader header;
+
+	// records of own size class not less than requested capacity
+	if (freeSpace.classHead[sizeClass] != NOT_FOUND) {
+		uint64_t preds[FREE_SKIP_LEVELS];
+		RecordHeader predHeaders[FREE_SKIP_LEVELS];
+		findFreePredecessors(sizeClass, capacity, 0, preds, predHeaders);
+		offset = getFreeLink(sizeClass, preds[0], predHeaders[0], 0);
+	}
+	for (uint32_t i = 0; offset != NOT_FOUND && i < COMPACT_CLASS_DEPTH; i++) {
+		if (offset < limit) return offset;
+		if (getRecordHeader(offset, header) == NOT_FOUND) return NOT_FOUND;
+		offset = header.next;
+	}
+
+	// any record of larger size class fits, heads are known without I/O
+	for (uint32_t c = sizeClass + 1; c < FREE_SIZE_CLASSES; c++) {
+		offset = freeSpace.classHead[c];
+		if (offset != NOT_FOUND && offset < limit) return offset;
+	}
+
+	// free lists are ordered by capacity, so scan file from the beginning
+	// (resumed by next lookups) for the first free record that fits
+	offset = compactScanOffset;
+	if (offset < sizeof(StorageHeader) || offset >= limit) offset = sizeof(StorageHeader);
+	for (uint32_t i = 0; i < COMPACT_LOOKUP_DEPTH && offset < limit; i++) {
+		if (getRecordHeader(offset, header) == NOT_FOUND) {
+			compactScanOffset = NOT_FOUND;
+			return NOT_FOUND;
+		}
+		if (header.recordCapacity >= capacity && isFreeRecord(offset, header)) {
+			compactScanOffset = offset;
+			return offset;
+		}
+		offset += sizeof(RecordHeader) + header.recordCapacity;
+	}
+	compactScanOffset = offset;
+	return NOT_FOUND;
+}
+
+
+
+/*
+*
+*  @brief Get free record of the largest non empty size class that is
+*  larger than size class of requested capacity
+*  @param[in] capacity - requested aligned capacity
+*  @return offset of free record or NOT_FOUND
+*/
+uint64_t RecordFileIO::getLargestFreeRecord(uint32_t capacity) {
+	uint32_t sizeClass = getSizeClass(capacity);
+	for (uint32_t c = FREE_SIZE_CLASSES - 1; c > sizeClass; c--) {
+		if (freeSpace.classHead[c] != NOT_FOUND) return freeSpace.classHead[c];
+	}
+	return NOT_FOUND;
+}
 
-	if (capacity == 0) return NOT_FOUND;
-		
-	// update previous free record
-	RecordHeader lastRecord;
-	uint64_t freeRecordOffset;
 
-	getRecordHeader(storageHeader.lastRecord, lastRecord);
-	lastRecord.next = freeRecordOffset = storageHeader.endOfFile;
-	putRecordHeader(storageHeader.lastRecord, lastRecord);
+
+/*
+*
+*  @brief Takes free record out of its free list and splits off the rest
+*  of capacity exceeding requested capacity
+*  @param[in] offset - free record offset
+*  @param[in] capacity - requested aligned capacity
+*  @param[out] result  - record header of allocated record
+*  @return offset of record in the storage file or NOT_FOUND
+*/
+uint64_t RecordFileIO::takeFreeRecord(uint64_t offset, uint32_t capacity, RecordHeader& result) {
+	// Remove free record from its free list
+	RecordHeader freeRecord;
+	if (getRecordHeader(offset, freeRecord) == NOT_FOUND) return NOT_FOUND;
+	removeFromFreeList(offset, freeRecord);
+
+	// split off the rest of oversized free record and release it
+	splitRecord(offset, freeRecord, capacity);
 
 	result.next = NOT_FOUND;
-	result.previous = storageHeader.lastRecord;
-	result.recordCapacity = capacity;
+	result.previous = NOT_FOUND;
+	result.recordCapacity = freeRecord.recordCapacity;
 	result.dataLength = 0;
+	result.dataChecksum = 0;
+	return offset;
+}
 
-	storageHeader.lastRecord = freeRecordOffset;
-	storageHeader.endOfFile += sizeof(RecordHeader) + capacity;
+
+
+/*
+*
+*  @brief Links allocated record as the last record and writes its header
+*  @param[in] offset - record offset in the storage file
+*  @param[in] header - header of allocated record with data length and checksum
+*
+*/
+void RecordFileIO::linkRecord(uint64_t offset, RecordHeader& header) {
+	header.next = NOT_FOUND;
+	header.previous = storageHeader.lastRecord;
+	if (storageHeader.lastRecord != NOT_FOUND) {
+		RecordHeader lastRecord;
+		getRecordHeader(storageHeader.lastRecord, lastRecord);
+		lastRecord.next = offset;
+		putRecordHeader(storageHeader.lastRecord, lastRecord);
+	} else storageHeader.firstRecord = offset;
+	putRecordHeader(offset, header);
+	storageHeader.lastRecord = offset;
 	storageHeader.totalRecords++;
+	freeSpace.recordBytes += header.recordCapacity;
+	freeSpace.dataBytes += header.dataLength;
 	persistStorageHeader();
-
-	return freeRecordOffset;
 }
 
 
+
 /*
 *
-*  @brief Creates record from the free list (previously deleted records)
-*  @param[in] capacity - requested capacity of record
-*  @param[out] result  - record header of created new record
-*  @return offset of record in the storage file
+*  @brief Links siblings of the record (or storage header) to new position
+*  @param[in] header - record header with siblings
+*  @param[in] offset - new record offset
+*
 */
-uint64_t RecordFileIO::getFromFreeList(uint32_t capacity, RecordHeader& result) {
+void RecordFileIO::relinkRecord(const RecordHeader& header, uint64_t offset) {
+	RecordHeader siblingHeader;
+	if (header.previous != NOT_FOUND) {
+		getRecordHeader(header.previous, siblingHeader);
+		siblingHeader.next = offset;
+		putRecordHeader(header.previous, siblingHeader);
+	} else storageHeader.firstRecord = offset;
+	if (header.next != NOT_FOUND) {
+		getRecordHeader(header.next, siblingHeader);
+		siblingHeader.previous = offset;
+		putRecordHeader(header.next, siblingHeader);
+	} else storageHeader.lastRecord = offset;
+}
 
-	if (storageHeader.totalFreeRecords == 0) return NOT_FOUND;
 
-	// If there are free records
-	RecordHeader freeRecord;
-	
-	freeRecord.next = storageHeader.firstFreeRecord;
-	uint64_t offset = freeRecord.next;
-	uint64_t maximumIterations = std::min(storageHeader.totalFreeRecords, freeLookupDepth);
-	uint64_t iterationCounter = 0;
-	// iterate through free list and check iterations counter
-	while (freeRecord.next != NOT_FOUND && iterationCounter < maximumIterations) {
-		// Read next free record header
-		getRecordHeader(offset, freeRecord);
-		// if record with requested capacity found
-		if (freeRecord.recordCapacity >= capacity) {
-			// Remove free record from the free list
-			removeFromFreeList(freeRecord);			
-			// update last record to point to new record
-			RecordHeader lastRecord;
-			getRecordHeader(storageHeader.lastRecord, lastRecord);
-			lastRecord.next = offset;			
-			putRecordHeader(storageHeader.lastRecord, lastRecord);
-			// connect new record with previous
-			result.next = NOT_FOUND;
-			result.previous = storageHeader.lastRecord;
-			result.recordCapacity = freeRecord.recordCapacity;
-			result.dataLength = 0;
-
-			// update storage header last record to new record
-			storageHeader.lastRecord = offset;
-			storageHeader.totalRecords++;
-			persistStorageHeader();
-			return offset;
-		}
-		offset = freeRecord.next;
-		iterationCounter++;
+
+/*
+*
+*  @brief Copies record data to other record by COMPACT_COPY_BUFFER chunks
+*  @param[in] from - source record offset
+*  @param[in] to - destination record offset
+*  @param[in] length - data length in bytes
+*  @return true - if data copied, false - if read or write failed
+*
+*/
+bool RecordFileIO::copyRecordData(uint64_t from, uint64_t to, uint32_t length) {
+	constexpr uint64_t HEADER_SIZE = sizeof RecordHeader;
+	std::vector<uint8_t> buffer(std::min<size_t>(length, COMPACT_COPY_BUFFER));
+	uint64_t copied = 0;
+	while (copied < length) {
+		size_t chunk = size_t(std::min<uint64_t>(buffer.size(), length - copied));
+		if (storageFile.read(from + HEADER_SIZE + copied, buffer.data(), chunk) != chunk) return false;
+		if (storageFile.write(to + HEADER_SIZE + copied, buffer.data(), chunk) != chunk) return false;
+		copied += chunk;
 	}
-	return NOT_FOUND;
+	return true;
 }
 
 
 
 /*
-*  @brief Put record to the free list
-*  @return true - if record added to the free list, false - if not found
+*  @brief Splits off the rest of record capacity if the rest is not less than
+*  FREE_SPLIT_MINIMUM and releases it, record header is not written
+*  @param[in] offset - record position in the file
+*  @param[in,out] header - record header, capacity is reduced if split
+*  @param[in] capacity - aligned capacity to keep
+*  @return true - if record split, false - if rest is too small
+*/
+bool RecordFileIO::splitRecord(uint64_t offset, RecordHeader& header, uint32_t capacity) {
+	if (header.recordCapacity < capacity) return false;
+	uint64_t restLength = uint64_t(header.recordCapacity) - capacity;
+	if (restLength < sizeof(RecordHeader) + FREE_SPLIT_MINIMUM) return false;
+	uint64_t restOffset = offset + sizeof(RecordHeader) + capacity;
+	RecordHeader restRecord;
+	restRecord.next = NOT_FOUND;
+	restRecord.previous = NOT_FOUND;
+	restRecord.recordCapacity = uint32_t(restLength - sizeof(RecordHeader));
+	restRecord.dataLength = 0;
+	restRecord.dataChecksum = 0;
+	putRecordHeader(restOffset, restRecord);
+	header.recordCapacity = capacity;
+	return putToFreeList(restOffset);
+}
+
+
+
+/*
+*  @brief Put record to the free list of its size class: merges it with
+*  physically adjacent free records, cuts it off if it ends at end of file
+*  @return true - if record released, false - if not found
 */
 bool RecordFileIO::putToFreeList(uint64_t offset) {
-	
-	RecordHeader newFreeRecord;
-	RecordHeader previousFreeRecord;
-	
+	RecordHeader newFreeRecord, neighbour;
 	if (getRecordHeader(offset, newFreeRecord) == NOT_FOUND) return false;
+	uint64_t capacity = newFreeRecord.recordCapacity;
+
+	// merge with the next free record
+	uint64_t nextOffset = offset + sizeof(RecordHeader) + capacity;
+	if (nextOffset < storageHeader.endOfFile &&
+		getRecordHeader(nextOffset, neighbour) != NOT_FOUND &&
+		isFreeRecord(nextOffset, neighbour) &&
+		capacity + sizeof(RecordHeader) + neighbour.recordCapacity <= UINT32_MAX) {
+		removeFromFreeList(nextOffset, neighbour);
+		eraseRecordHeader(nextOffset);
+		capacity += sizeof(RecordHeader) + neighbour.recordCapacity;
+	}
 
-	// Update previous free record to reference next new free record
-	size_t previousFreeRecordOffset = storageHeader.lastFreeRecord;
-	// if free records list is not empty
-	if (previousFreeRecordOffset != NOT_FOUND) {
-		// load previous last record
-		getRecordHeader(previousFreeRecordOffset, previousFreeRecord);
-		// set last recrod next value to recently deleted free record
-		previousFreeRecord.next = offset;
-		// save previous last record
-		putRecordHeader(previousFreeRecordOffset, previousFreeRecord);
-	}
-		
-	// Update new free record fields	
-	newFreeRecord.next = NOT_FOUND;
-	// Point to the previous free record position
-	newFreeRecord.previous = previousFreeRecordOffset;
-	// Set data length and data checksum to zero, because it doesn't matter
-	newFreeRecord.dataLength = 0;
-	newFreeRecord.dataChecksum = 0;
-	// Save record header
-	putRecordHeader(offset, newFreeRecord);
-
-	// if its first free record, save its offset to the storage header	
-	if (storageHeader.firstFreeRecord == NOT_FOUND) {
-		storageHeader.firstFreeRecord = offset;
-	}
-
-	// save it as last added free record
-	storageHeader.lastFreeRecord = offset;
-	storageHeader.totalFreeRecords++;
+	// merge with the previous free record
+	uint64_t prevOffset = getPreviousFreeRecord(offset, neighbour);
+	if (prevOffset != NOT_FOUND &&
+		capacity + sizeof(RecordHeader) + neighbour.recordCapacity <= UINT32_MAX) {
+		removeFromFreeList(prevOffset, neighbour);
+		eraseRecordHeader(offset);
+		capacity += sizeof(RecordHeader) + neighbour.recordCapacity;
+		offset = prevOffset;
+		newFreeRecord = neighbour;
+	}
 
-	// save storage header
+	// trim free space at the end of file or index merged free record
+	if (offset + sizeof(RecordHeader) + capacity == storageHeader.endOfFile) {
+		eraseRecordHeader(offset);
+		storageHeader.endOfFile = offset;
+	} else {
+		newFreeRecord.recordCapacity = uint32_t(capacity);
+		insertFreeRecord(offset, newFreeRecord);
+	}
 	persistStorageHeader();
 	return true;
 }
 
 
+
 /*
-*  @brief Remove record from free list and update siblings interlinks
-*  @param[in] freeRecord - header of record to remove from free list
+*  @brief Marks record as free and inserts it to the skip list of its size
+*  class ordered by capacity and offset. Level 0 links are next/previous of
+*  record header, links of upper levels are at the beginning of record data.
+*  @param[in] offset - record offset in the storage file
+*  @param[in] freeRecord - header of the record
 */
-void RecordFileIO::removeFromFreeList(RecordHeader& freeRecord) {
-	// Simplify namings and check
-	uint64_t leftSiblingOffset = freeRecord.previous;
-	uint64_t rightSiblingOffset = freeRecord.next;
-	bool leftSiblingExists = (leftSiblingOffset != NOT_FOUND);
-	bool rightSiblingExists = (rightSiblingOffset != NOT_FOUND);
+void RecordFileIO::insertFreeRecord(uint64_t offset, RecordHeader& freeRecord) {
+	uint32_t sizeClass = getSizeClass(freeRecord.recordCapacity);
+	uint64_t preds[FREE_SKIP_LEVELS];
+	RecordHeader predHeaders[FREE_SKIP_LEVELS];
+	findFreePredecessors(sizeClass, freeRecord.recordCapacity, offset, preds, predHeaders);
+
+	// link level 0 successor back to the new free record
+	uint64_t nextOffset = getFreeLink(sizeClass, preds[0], predHeaders[0], 0);
+	if (nextOffset != NOT_FOUND) {
+		RecordHeader nextRecord;
+		getRecordHeader(nextOffset, nextRecord);
+		nextRecord.previous = offset;
+		putRecordHeader(nextOffset, nextRecord);
+	}
+	freeRecord.next = nextOffset;
+	freeRecord.previous = preds[0];
+	// Set data length and data checksum to zero - it marks free record
+	freeRecord.dataLength = 0;
+	freeRecord.dataChecksum = 0;
+	putRecordHeader(offset, freeRecord);
+	setFreeLink(sizeClass, preds[0], predHeaders[0], 0, offset);
+	// boundary tag for the next record to find this one
+	if (freeRecord.recordCapacity >= sizeof(uint64_t)) {
+		uint64_t tagOffset = offset + sizeof(RecordHeader) + freeRecord.recordCapacity - sizeof(uint64_t);
+		storageFile.write(tagOffset, &offset, sizeof(uint64_t));
+	}
 
+	// link upper levels after predecessors
+	uint32_t levels = getSkipLevels(offset, freeRecord.recordCapacity);
+	for (uint32_t level = 1; level < levels; level++) {
+		uint64_t levelNext = getFreeLink(sizeClass, preds[level], predHeaders[level], level);
+		setFreeLink(sizeClass, offset, freeRecord, level, levelNext);
+		setFreeLink(sizeClass, preds[level], predHeaders[level], level, offset);
+	}
+	storageHeader.totalFreeRecords++;
+	freeSpace.freeBytes += freeRecord.recordCapacity;
+}
 
-	RecordHeader leftSiblingHeader;
-	RecordHeader rightSiblingHeader;
 
-	// If both of siblings exists then we removing record in the middle
-	if (leftSiblingExists && rightSiblingExists) {		               
-		// If removing in the middle
-		getRecordHeader(freeRecord.previous, leftSiblingHeader);
-		getRecordHeader(freeRecord.next, rightSiblingHeader);
-		leftSiblingHeader.next = rightSiblingOffset;
-		rightSiblingHeader.previous = leftSiblingOffset;
-		putRecordHeader(leftSiblingOffset, leftSiblingHeader);
-		putRecordHeader(rightSiblingOffset, rightSiblingHeader);
-	}   // if left sibling exists and right is not
-	else if (leftSiblingExists) {                                    
-		// if removing last free record
-		getRecordHeader(freeRecord.previous, leftSiblingHeader);
-		leftSiblingHeader.next = NOT_FOUND;
-		putRecordHeader(leftSiblingOffset, leftSiblingHeader);
-		storageHeader.lastFreeRecord = leftSiblingOffset;
-	}   // if right sibling exists and left is not
-	else if (rightSiblingExists) {                                   
-		// if removing first free record
-		getRecordHeader(freeRecord.next, rightSiblingHeader);
-		rightSiblingHeader.previous = NOT_FOUND;
-		putRecordHeader(rightSiblingOffset, rightSiblingHeader);
-		storageHeader.firstFreeRecord = rightSiblingOffset;
-	} else {                                                           
-		// If removing last free record
-		storageHeader.firstFreeRecord = NOT_FOUND;
-		storageHeader.lastFreeRecord = NOT_FOUND;
+
+/*
+*  @brief Remove record from skip list of its size class and update siblings interlinks
+*  @param[in] offset - record offset in the storage file
+*  @param[in] freeRecord - header of record to remove from free list
+*/
+void RecordFileIO::removeFromFreeList(uint64_t offset, RecordHeader& freeRecord) {
+	uint32_t sizeClass = getSizeClass(freeRecord.recordCapacity);
+	uint64_t preds[FREE_SKIP_LEVELS];
+	RecordHeader predHeaders[FREE_SKIP_LEVELS];
+	findFreePredecessors(sizeClass, freeRecord.recordCapacity, offset, preds, predHeaders);
+
+	// unlink level 0 (doubly linked)
+	setFreeLink(sizeClass, preds[0], predHeaders[0], 0, freeRecord.next);
+	if (freeRecord.next != NOT_FOUND) {
+		RecordHeader nextRecord;
+		getRecordHeader(freeRecord.next, nextRecord);
+		nextRecord.previous = preds[0];
+		putRecordHeader(freeRecord.next, nextRecord);
+	}
+	// unlink upper levels up to the record height
+	for (uint32_t level = 1; level < FREE_SKIP_LEVELS; level++) {
+		if (getFreeLink(sizeClass, preds[level], predHeaders[level], level) != offset) break;
+		uint64_t levelNext = getFreeLink(sizeClass, offset, freeRecord, level);
+		setFreeLink(sizeClass, preds[level], predHeaders[level], level, levelNext);
 	}
 	// Decrement total free records
 	storageHeader.totalFreeRecords--;
-	// Persist storage header
-	persistStorageHeader();
+	freeSpace.freeBytes -= freeRecord.recordCapacity;
+}
+
+
+
+/*
+*  @brief Finds the last free record before (capacity, offset) on every level
+*  of size class skip list
+*  @param[in] sizeClass - size class
+*  @param[in] capacity - capacity of looked up position
+*  @param[in] offset - offset of looked up position (among equal capacities)
+*  @param[out] preds - predecessor offsets by level (NOT_FOUND - size class head)
+*  @param[out] predHeaders - predecessor headers by level
+*/
+void RecordFileIO::findFreePredecessors(uint32_t sizeClass, uint32_t capacity, uint64_t offset, uint64_t* preds, RecordHeader* predHeaders) {
+	uint64_t node = NOT_FOUND;
+	RecordHeader nodeHeader, nextHeader;
+	memset(&nodeHeader, 0, sizeof RecordHeader);
+	for (int32_t level = FREE_SKIP_LEVELS - 1; level >= 0; level--) {
+		uint64_t next = getFreeLink(sizeClass, node, nodeHeader, level);
+		// move forward while next record is before looked up position
+		while (next != NOT_FOUND && getRecordHeader(next, nextHeader) != NOT_FOUND) {
+			if (nextHeader.recordCapacity > capacity) break;
+			if (nextHeader.recordCapacity == capacity && next >= offset) break;
+			node = next;
+			nodeHeader = nextHeader;
+			next = getFreeLink(sizeClass, node, nodeHeader, level);
+		}
+		preds[level] = node;
+		predHeaders[level] = nodeHeader;
+	}
+}
+
+
+
+/*
+*  @brief Returns next free record on skip list level
+*  @param[in] sizeClass - size class
+*  @param[in] offset - free record offset (NOT_FOUND - size class head)
+*  @param[in] header - free record header
+*  @param[in] level - skip list level
+*  @return next free record offset or NOT_FOUND
+*/
+uint64_t RecordFileIO::getFreeLink(uint32_t sizeClass, uint64_t offset, const RecordHeader& header, uint32_t level) {
+	if (offset == NOT_FOUND) {
+		if (level == 0) return freeSpace.classHead[sizeClass];
+		return freeSpace.classTower[sizeClass][level - 1];
+	}
+	if (level == 0) return header.next;
+	uint64_t link = NOT_FOUND;
+	uint64_t linkOffset = offset + sizeof(RecordHeader) + (level - 1) * sizeof(uint64_t);
+	storageFile.read(linkOffset, &link, sizeof(uint64_t));
+	return link;
+}
+
+
+
+/*
+*  @brief Sets and persists next free record on skip list level
+*  @param[in] sizeClass - size class
+*  @param[in] offset - free record offset (NOT_FOUND - size class head)
+*  @param[in] header - free record header (level 0 link is written to it)
+*  @param[in] level - skip list level
+*  @param[in] link - next free record offset or NOT_FOUND
+*/
+void RecordFileIO::setFreeLink(uint32_t sizeClass, uint64_t offset, RecordHeader& header, uint32_t level, uint64_t link) {
+	if (offset == NOT_FOUND) {
+		if (level == 0) {
+			setClassHead(sizeClass, link);
+		} else {
+			freeSpace.classTower[sizeClass][level - 1] = link;
+			persistFreeSpace(&freeSpace.classTower[sizeClass][level - 1], sizeof(uint64_t));
+		}
+	} else if (level == 0) {
+		header.next = link;
+		putRecordHeader(offset, header);
+	} else {
+		uint64_t linkOffset = offset + sizeof(RecordHeader) + (level - 1) * sizeof(uint64_t);
+		storageFile.write(linkOffset, &link, sizeof(uint64_t));
+	}
+}
+
+
+
+/*
+*  @brief Sets first free record of size class and persists it
+
+*  @param[in] sizeClass - size class
+*  @param[in] offset - first free record offset or NOT_FOUND if class is empty
+*/
+void RecordFileIO::setClassHead(uint32_t sizeClass, uint64_t offset) {
+	uint64_t& word = freeSpace.nonEmptyClasses[sizeClass / 64];
+	uint64_t bit = 1ull << (sizeClass % 64);
+	freeSpace.classHead[sizeClass] = offset;
+	word = (offset == NOT_FOUND) ? (word & ~bit) : (word | bit);
+	persistFreeSpace(&freeSpace.classHead[sizeClass], sizeof(uint64_t));
+	persistFreeSpace(&word, sizeof(uint64_t));
+}
+
+
+
+/**
+*  @brief Rounds record capacity up to RECORD_ALIGNMENT (keeps headers aligned)
+*  @param[in] length - requested data length in bytes
+*  @return record capacity in bytes
+*/
+uint32_t RecordFileIO::alignCapacity(uint32_t length) {
+	if (length > UINT32_MAX - RECORD_ALIGNMENT) return length;
+	uint32_t capacity = (length + RECORD_ALIGNMENT - 1) & ~(RECORD_ALIGNMENT - 1);
+	return std::max(capacity, RECORD_ALIGNMENT);
+}
+
+
+
+/**
+*  @brief Returns free size class of record capacity
+*  @param[in] capacity - record capacity in bytes
+*/
+uint32_t RecordFileIO::getSizeClass(uint32_t capacity) {
+	constexpr uint32_t linearLimit = 2u << FREE_CLASS_SUB_BITS;
+	if (capacity < linearLimit) return capacity;
+	// Position of the highest bit
+	uint32_t exponent = 0;
+	for (uint32_t bits = capacity; bits > 1; bits >>= 1) exponent++;
+	uint32_t subClass = (capacity >> (exponent - FREE_CLASS_SUB_BITS)) & ((1u << FREE_CLASS_SUB_BITS) - 1);
+	return linearLimit + ((exponent - FREE_CLASS_SUB_BITS - 1) << FREE_CLASS_SUB_BITS) + subClass;
+}
+
+
+
+/**
+*  @brief Returns the smallest record capacity of free size class
+*  @param[in] sizeClass - free size class
+*/
+uint32_t RecordFileIO::getSizeClassMinimum(uint32_t sizeClass) {
+	constexpr uint32_t linearLimit = 2u << FREE_CLASS_SUB_BITS;
+	if (sizeClass < linearLimit) return sizeClass;
+	uint32_t exponent = ((sizeClass - linearLimit) >> FREE_CLASS_SUB_BITS) + FREE_CLASS_SUB_BITS + 1;
+	uint32_t subClass = (sizeClass - linearLimit) & ((1u << FREE_CLASS_SUB_BITS) - 1);
+	return ((1u << FREE_CLASS_SUB_BITS) + subClass) << (exponent - FREE_CLASS_SUB_BITS);
+}
+
+
+
+/**
+*  @brief Returns skip list levels of free record: 1 of 4 records goes to
+*  the next level by hash of offset, upper level links and boundary tag
+*  must fit in capacity
+*  @param[in] offset - record offset in the storage file
+*  @param[in] capacity - record capacity in bytes
+*/
+uint32_t RecordFileIO::getSkipLevels(uint64_t offset, uint32_t capacity) {
+	uint32_t maxLevels = std::min(FREE_SKIP_LEVELS, std::max(1u, uint32_t(capacity / sizeof(uint64_t))));
+	// splitmix64 finalizer
+	uint64_t hash = offset + 0x9E3779B97F4A7C15ull;
+	hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+	hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+	hash ^= hash >> 31;
+	uint32_t levels = 1;
+	while (levels < maxLevels && (hash & 3) == 0) {
+		hash >>= 2;
+		levels++;
+	}
+	return levels;
 }
 
 
 
 /**
-*  @brief Adler-32 checksum algoritm (strightforward and not efficent, but its okay)
+*  @brief Adler-32 checksum algoritm
+ (strightforward and not efficent, but its okay)
 *  @param[in] data - byte array of data to be checksummed
 *  @param[in] length - length of data in bytes
 *  @return 32-bit checksum of given data
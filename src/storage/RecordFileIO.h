@@ -5,15 +5,20 @@
 *  RecordFileIO is designed for seamless storage of binary records of
 *  arbitary size (max record size limited to 4Gb), accessing records as
 *  linked list and reuse space of deleted records. RecordFileIO uses
-*  CachedFileIO to cache frequently accessed data and win IO performance.
+*  CachedFileIO to cache frequently accessed data and win IO performance
+*  (or MappedFileIO, any FileIO storage implementation).
 *
 *  Features:
 *    - create/read/update/delete records of arbitrary size
 *    - navigate records: first, last, next, previous, exact position
-*    - reuse space of deleted records
+*    - reuse space of deleted records (best fit from size class skip lists)
+*    - merge adjacent deleted records, trim deleted records at end of file
+*    - split oversized deleted records on reuse
+*    - move records to free space below given offset, shrink file (compaction)
 *    - data consistency check (checksum)
+*    - zero-copy access to records that fit in one cache page
 *
-*  (C) Boson Database, Bolat Basheyev 2022-2023
+*  (C) Boson Database, Bolat Basheyev 2022-2024
 *
 ******************************************************************************/
 #pragma once
@@ -29,14 +34,30 @@ namespace Boson {
 	// Boson storage header signature and version
 	//----------------------------------------------------------------------------
 	constexpr uint32_t BOSONDB_SIGNATURE = 0x42445342; // BSDB signature
-	constexpr uint32_t BOSONDB_VERSION   = 0x00000001; // Version 1
-	
+	constexpr uint16_t BOSONDB_VERSION   = 0x0005;     // Version 5 (coalesced free records with boundary tags)
+
+	//----------------------------------------------------------------------------
+	// Free space size classes: capacities below 8 bytes have own class, larger
+	// capacities have 2^FREE_CLASS_SUB_BITS classes per power of 2
+	//----------------------------------------------------------------------------
+	constexpr uint32_t RECORD_ALIGNMENT    = 8;        // Record capacity granularity
+	constexpr uint32_t FREE_CLASS_SUB_BITS = 2;        // Free size classes per power of 2 (log2)
+	constexpr uint32_t FREE_SIZE_CLASSES   =           // Free size classes count (up to 4Gb)
+		(2u << FREE_CLASS_SUB_BITS) + (32 - FREE_CLASS_SUB_BITS - 1) * (1u << FREE_CLASS_SUB_BITS);
+	constexpr uint32_t FREE_CLASS_WORDS    = (FREE_SIZE_CLASSES + 63) / 64;
+	constexpr uint32_t FREE_SKIP_LEVELS    = 10;       // Skip list levels of size class (1 of 4 goes up)
+	constexpr uint32_t FREE_SPLIT_MINIMUM  = 64;       // Minimum capacity of free record split off on reuse
+	constexpr uint32_t COMPACT_CLASS_DEPTH = 8;        // Free records of size class examined to find space below offset
+	constexpr uint32_t COMPACT_LOOKUP_DEPTH = 128;     // Records scanned to find free space below offset
+	constexpr uint64_t COMPACT_COPY_BUFFER = 65536;    // Data copy chunk of moved record
+
 	//----------------------------------------------------------------------------
 	// Boson storage header structure (64 bytes)
 	//----------------------------------------------------------------------------
 	typedef struct {
 		uint32_t      signature;           // BSDB signature
-		uint32_t      version;             // Format version		
+		uint16_t      version;             // Format version
+		uint16_t      pageSizeKb;          // Page size in Kb (0 in version 1 - default)
 		uint64_t      endOfFile;           // Size of file
 
 		uint64_t      totalRecords;        // Total number of records
@@ -44,11 +65,24 @@ namespace Boson {
 		uint64_t      lastRecord;          // Last record offset
 
 		uint64_t      totalFreeRecords;    // Total number of free records
-		uint64_t      firstFreeRecord;     // First free record offset
-		uint64_t      lastFreeRecord;      // Last free record offset
+		uint64_t      freeSpaceIndex;      // Free space index record offset (version 2: first free record)
+		uint64_t      reserved;            // Reserved (version 2: last free record)
 	} StorageHeader;
 
 
+	//----------------------------------------------------------------------------
+	// Free space index (data of the record referenced by storage header)
+	//----------------------------------------------------------------------------
+	typedef struct {
+		uint64_t      freeBytes;           // Total capacity of free records
+		uint64_t      recordBytes;         // Total capacity of live records
+		uint64_t      dataBytes;           // Total data length of live records
+		uint64_t      nonEmptyClasses[FREE_CLASS_WORDS];  // Bit per non empty size class
+		uint64_t      classHead[FREE_SIZE_CLASSES];       // First free record of size class
+		uint64_t      classTower[FREE_SIZE_CLASSES][FREE_SKIP_LEVELS - 1]; // First free record of upper levels
+	} FreeSpaceIndex;
+
+
 	//----------------------------------------------------------------------------
 	// Record header structure (32 bytes)
 	//----------------------------------------------------------------------------
@@ -56,8 +90,8 @@ namespace Boson {
 		uint64_t    next;              // Next record position in data file
 		uint64_t    previous;          // Previous record position in data file				
 		uint32_t    recordCapacity;    // Record capacity in bytes
-		uint32_t    dataLength;        // Data length in bytes (or if deleted)				
-		uint32_t    dataChecksum;      // Checksum for data consistency check		
+		uint32_t    dataLength;        // Data length in bytes (0 if deleted)
+		uint32_t    dataChecksum;      // Checksum for data consistency check (0 if deleted)
 		uint32_t    headChecksum;      // Checksum for header consistency check
 	} RecordHeader;
 
@@ -67,12 +101,17 @@ namespace Boson {
 	//----------------------------------------------------------------------------
 	class RecordFileIO {
 	public:
-		RecordFileIO(CachedFileIO& cachedFile, size_t freeDepth = NOT_FOUND);
+		RecordFileIO(FileIO& storageFile);
 		~RecordFileIO();
 		bool     isOpen();
 		uint64_t getTotalRecords();
 		uint64_t getTotalFreeRecords();
-		void     setFreeRecordLookupDepth(uint64_t maxDepth) { freeLookupDepth = maxDepth; }
+		uint64_t getFreeSpaceBytes();
+		uint64_t getDataBytes();
+		uint64_t getRecordBytes();
+		double   getInternalFragmentation();
+		uint64_t getEndOfFile();
+		void     setAccessHint(AccessHint hint) { accessHint = hint; }
 
 		// records navigation
 		bool     setPosition(uint64_t offset);
@@ -90,27 +129,59 @@ namespace Boson {
 		uint64_t getNextPosition();
 		uint64_t getPrevPosition();
 		uint64_t getRecordData(void* data, uint32_t length);
+		PinnedPage pinRecordData();
 		uint64_t setRecordData(const void* data, uint32_t length);
 
+		// compaction
+		uint64_t moveRecord(uint64_t offset, uint64_t limit);
+		uint64_t getCompactSize();
+		uint64_t shrinkFile();
+
 	private:
-		CachedFileIO& cachedFile;
+		FileIO&       storageFile;
 		StorageHeader storageHeader;
+		FreeSpaceIndex freeSpace;
 		RecordHeader  recordHeader;
 		size_t        currentPosition;
-		size_t        freeLookupDepth;
+		AccessHint    accessHint;
+		uint64_t      compactScanOffset;
 
 		void     initStorageHeader();
 		bool     persistStorageHeader();
 		bool     loadStorageHeader();
+		void     resetFreeSpaceIndex();
+		uint64_t createFreeSpaceIndex();
+		bool     loadFreeSpaceIndex();
+		bool     rebuildFreeSpaceIndex(uint64_t staleIndex);
+		void     persistFreeSpace(const void* field, size_t length);
 		uint64_t getRecordHeader(uint64_t offset, RecordHeader& result);
 		uint64_t putRecordHeader(uint64_t offset, RecordHeader& header);
+		void     eraseRecordHeader(uint64_t offset);
+		bool     isFreeRecord(uint64_t offset, const RecordHeader& header);
+		uint64_t getPreviousFreeRecord(uint64_t offset, RecordHeader& result);
 		uint64_t allocateRecord(uint32_t capacity, RecordHeader& result);
-		uint64_t createFirstRecord(uint32_t capacity, RecordHeader& result);
 		uint64_t appendNewRecord(uint32_t capacity, RecordHeader& result);
 		uint64_t getFromFreeList(uint32_t capacity, RecordHeader& result);
+		uint64_t findFreeRecordBelow(uint32_t capacity, uint64_t limit);
+		uint64_t getLargestFreeRecord(uint32_t capacity);
+		uint64_t takeFreeRecord(uint64_t offset, uint32_t capacity, RecordHeader& result);
+		void     linkRecord(uint64_t offset, RecordHeader& header);
+		void     relinkRecord(const RecordHeader& header, uint64_t offset);
+		bool     copyRecordData(uint64_t from, uint64_t to, uint32_t length);
+		bool     splitRecord(uint64_t offset, RecordHeader& header, uint32_t capacity);
 		bool     putToFreeList(uint64_t offset);
-		void     removeFromFreeList(RecordHeader& freeRecord);
+		void     insertFreeRecord(uint64_t offset, RecordHeader& freeRecord);
+		void     removeFromFreeList(uint64_t offset, RecordHeader& freeRecord);
+		void     findFreePredecessors(uint32_t sizeClass, uint32_t capacity, uint64_t offset, uint64_t* preds, RecordHeader* predHeaders);
+		uint64_t getFreeLink(uint32_t sizeClass, uint64_t offset, const RecordHeader& header, uint32_t level);
+		void     setFreeLink(uint32_t sizeClass, uint64_t offset, RecordHeader& header, uint32_t level, uint64_t link);
+		void     setClassHead(uint32_t sizeClass, uint64_t offset);
 		uint32_t checksum(const uint8_t* data, uint64_t length);
+
+		static uint32_t alignCapacity(uint32_t length);
+		static uint32_t getSizeClass(uint32_t capacity);
+		static uint32_t getSizeClassMinimum(uint32_t sizeClass);
+		static uint32_t getSkipLevels(uint64_t offset, uint32_t capacity);
 	};
 
 
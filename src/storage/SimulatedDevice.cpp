@@ -0,0 +1,161 @@
+/******************************************************************************
+*
+*  SimulatedDevice class implementation
+*
+*  Every call to underlying device is stretched to the latency of modeled
+*  device plus transfer time at its bandwidth. Time spent by underlying
+*  device counts toward modeled latency, so memory device (or file cached
+*  by OS) gives timings of modeled device. Delays of concurrent calls
+*  overlap, modeled device serves any number of requests in parallel.
+*
+*  Sleep granularity of OS is too coarse for microsecond latencies, so
+*  the last DELAY_SPIN_NS of delay are spent yielding in loop.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "StorageDevice.h"
+#include "IOStats.h"
+
+#include <thread>
+#include <chrono>
+
+using namespace Boson;
+
+
+/**
+*
+*  @brief Constructor
+*
+*  @param device - underlying device (must outlive simulated device)
+*  @param profile - latencies and bandwidth of modeled device
+*
+*/
+SimulatedDevice::SimulatedDevice(StorageDevice& device, const DeviceProfile& profile) : device(device) {
+	this->profile = profile;
+	this->injectedTime = 0;
+}
+
+
+/**
+* @brief Opens underlying device
+*/
+bool SimulatedDevice::open(const char* path, bool readOnly) {
+	return device.open(path, readOnly);
+}
+
+
+/**
+* @brief Closes underlying device
+*/
+void SimulatedDevice::close() {
+	device.close();
+}
+
+
+/**
+* @brief Returns true if underlying device is open
+*/
+bool SimulatedDevice::isOpen() {
+	return device.isOpen();
+}
+
+
+/**
+* @brief Reads range of underlying device with read latency of modeled device
+*/
+size_t SimulatedDevice::read(size_t offset, const AsyncBuffer* buffers, size_t count) {
+	uint64_t startTime = getTimeNs();
+	size_t bytesRead = device.read(offset, buffers, count);
+	delay(startTime, profile.readLatencyNs, bytesRead);
+	return bytesRead;
+}
+
+
+/**
+* @brief Writes range of underlying device with write latency of modeled device
+*/
+size_t SimulatedDevice::write(size_t offset, const AsyncBuffer* buffers, size_t count) {
+	uint64_t startTime = getTimeNs();
+	size_t bytesWritten = device.write(offset, buffers, count);
+	delay(startTime, profile.writeLatencyNs, bytesWritten);
+	return bytesWritten;
+}
+
+
+/**
+* @brief Syncs underlying device with sync latency of modeled device
+*/
+bool SimulatedDevice::sync() {
+	uint64_t startTime = getTimeNs();
+	bool synced = device.sync();
+	delay(startTime, profile.syncLatencyNs, 0);
+	return synced;
+}
+
+
+/**
+* @brief Returns underlying device size in bytes
+*/
+size_t SimulatedDevice::getSize() {
+	return device.getSize();
+}
+
+
+/**
+* @brief Truncates underlying device with write latency of modeled device
+*/
+bool SimulatedDevice::truncate(size_t size) {
+	uint64_t startTime = getTimeNs();
+	bool truncated = device.truncate(size);
+	delay(startTime, profile.writeLatencyNs, 0);
+	return truncated;
+}
+
+
+/**
+* @brief Sets direct I/O mode of underlying device
+*/
+bool SimulatedDevice::setDirectIO(bool enabled) {
+	return device.setDirectIO(enabled);
+}
+
+
+/**
+* @brief Returns true if underlying device data outlives the process
+*/
+bool SimulatedDevice::isPersistent() {
+	return device.isPersistent();
+}
+
+
+/**
+* @brief Returns total delay injected to calls of all threads (ns)
+*/
+uint64_t SimulatedDevice::getInjectedTimeNs() {
+	return injectedTime;
+}
+
+
+/**
+*
+*  @brief Waits until modeled device would complete the call
+*
+*  @param startTime - call start time (ns)
+*  @param latencyNs - modeled call latency (ns)
+*  @param bytes - bytes transferred by the call
+*
+*/
+void SimulatedDevice::delay(uint64_t startTime, uint64_t latencyNs, size_t bytes) {
+	uint64_t transferTime = 0;
+	if (profile.bandwidth > 0) transferTime = uint64_t(double(bytes) * 1000000000.0 / double(profile.bandwidth));
+	uint64_t deadline = startTime + latencyNs + transferTime;
+	uint64_t now = getTimeNs();
+	if (now >= deadline) return;
+	this->injectedTime += deadline - now;
+	if (deadline - now > DELAY_SPIN_NS) {
+		std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now - DELAY_SPIN_NS));
+	}
+	while (getTimeNs() < deadline) std::this_thread::yield();
+}
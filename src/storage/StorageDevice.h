@@ -0,0 +1,168 @@
+/******************************************************************************
+*
+*  Storage devices header
+*
+*  StorageDevice is random access byte storage under CachedFileIO: cache
+*  misses read pages from the device, flushes and dirty evictions write
+*  pages to it. Devices:
+*    - FileDevice      - OS file (default), positional I/O on POSIX systems
+*    - MemoryDevice    - growable memory of fixed size chunks, no system
+*                        calls, data lives until device is cleared or
+*                        destroyed (tests, ephemeral databases)
+*    - SimulatedDevice - injects latency and bandwidth limit of modeled
+*                        device (NVMe, network disk) to I/O of other device
+*
+*  Reads and writes are vectored: one call transfers consecutive device
+*  range from/to several buffers. Calls of different threads to different
+*  ranges may run concurrently.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+
+#include "AsyncIO.h"
+
+namespace Boson {
+
+	//-------------------------------------------------------------------------
+	constexpr uint64_t MAX_DEVICE_BUFFERS = 64;       // Maximum buffers of one read/write call
+	constexpr uint64_t MEMORY_CHUNK_SIZE = 1024 * 1024; // Memory device chunk size (1Mb)
+	constexpr uint64_t DELAY_SPIN_NS  = 200000;       // Simulated delay spin (not sleep) tail (ns)
+	//-------------------------------------------------------------------------
+
+	typedef struct {                            // Simulated device profile
+		uint64_t  readLatencyNs;                // Latency of read call (ns)
+		uint64_t  writeLatencyNs;               // Latency of write call (ns)
+		uint64_t  syncLatencyNs;                // Latency of sync call (ns)
+		uint64_t  bandwidth;                    // Transfer rate (bytes/sec, 0 - unlimited)
+	} DeviceProfile;
+
+	constexpr DeviceProfile NVME_DEVICE     = { 80000, 20000, 500000, 3000ull * 1024 * 1024 };
+	constexpr DeviceProfile SATA_SSD_DEVICE = { 150000, 60000, 2000000, 500ull * 1024 * 1024 };
+	constexpr DeviceProfile NETWORK_DEVICE  = { 1000000, 1500000, 3000000, 200ull * 1024 * 1024 };
+
+
+	//-------------------------------------------------------------------------
+	// Storage device interface
+	//-------------------------------------------------------------------------
+	class StorageDevice {
+	public:
+		virtual ~StorageDevice() {}
+		virtual bool   open(const char* path, bool readOnly) = 0;
+		virtual void   close() = 0;
+		virtual bool   isOpen() = 0;
+		virtual size_t read(size_t offset, const AsyncBuffer* buffers, size_t count) = 0;
+		virtual size_t write(size_t offset, const AsyncBuffer* buffers, size_t count) = 0;
+		virtual bool   sync() = 0;
+		virtual size_t getSize() = 0;
+		virtual bool   truncate(size_t size) = 0;
+		virtual bool   setDirectIO(bool enabled) { return false; }
+		virtual int    getDescriptor() { return -1; }
+		virtual bool   isPersistent() { return true; }
+	};
+
+
+	//-------------------------------------------------------------------------
+	// OS file device
+	//-------------------------------------------------------------------------
+	class FileDevice : public StorageDevice {
+	public:
+		FileDevice();
+		FileDevice(const FileDevice&) = delete;
+		void operator=(const FileDevice&) = delete;
+		~FileDevice();
+
+		bool   open(const char* path, bool readOnly);
+		void   close();
+		bool   isOpen();
+		size_t read(size_t offset, const AsyncBuffer* buffers, size_t count);
+		size_t write(size_t offset, const AsyncBuffer* buffers, size_t count);
+		bool   sync();
+		size_t getSize();
+		bool   truncate(size_t size);
+		bool   setDirectIO(bool enabled);
+		int    getDescriptor();
+
+	private:
+#ifndef _WIN32
+		size_t transfer(size_t offset, const AsyncBuffer* buffers, size_t count, bool write);
+#endif
+
+		int             fileDescriptor;          // OS file descriptor (-1 if closed)
+		std::mutex      fileLatch;               // Seek and read/write latch (Windows)
+		std::vector<uint8_t> stagingBuffer;      // Vectored I/O staging buffer (Windows)
+	};
+
+
+	//-------------------------------------------------------------------------
+	// Growable in-memory device
+	//-------------------------------------------------------------------------
+	class MemoryDevice : public StorageDevice {
+	public:
+		MemoryDevice();
+		MemoryDevice(const MemoryDevice&) = delete;
+		void operator=(const MemoryDevice&) = delete;
+		~MemoryDevice();
+
+		bool   open(const char* path, bool readOnly);
+		void   close();
+		bool   isOpen();
+		size_t read(size_t offset, const AsyncBuffer* buffers, size_t count);
+		size_t write(size_t offset, const AsyncBuffer* buffers, size_t count);
+		bool   sync();
+		size_t getSize();
+		bool   truncate(size_t size);
+		bool   isPersistent();
+		void   clear();
+		size_t getMemorySize();
+
+	private:
+		void   growChunks(size_t endOffset);
+
+		std::vector<uint8_t*> chunks;            // Memory chunks
+		std::shared_mutex chunksLatch;           // Chunks list latch (exclusive to grow)
+		std::atomic<uint64_t> size;              // Device data size
+		bool            opened;                  // Device is open
+		bool            readOnly;                // Read only flag
+	};
+
+
+	//-------------------------------------------------------------------------
+	// Latency injecting device over other device
+	//-------------------------------------------------------------------------
+	class SimulatedDevice : public StorageDevice {
+	public:
+		SimulatedDevice(StorageDevice& device, const DeviceProfile& profile = NVME_DEVICE);
+		SimulatedDevice(const SimulatedDevice&) = delete;
+		void operator=(const SimulatedDevice&) = delete;
+
+		bool   open(const char* path, bool readOnly);
+		void   close();
+		bool   isOpen();
+		size_t read(size_t offset, const AsyncBuffer* buffers, size_t count);
+		size_t write(size_t offset, const AsyncBuffer* buffers, size_t count);
+		bool   sync();
+		size_t getSize();
+		bool   truncate(size_t size);
+		bool   setDirectIO(bool enabled);
+		bool   isPersistent();
+		uint64_t getInjectedTimeNs();
+
+	private:
+		void   delay(uint64_t startTime, uint64_t latencyNs, size_t bytes);
+
+		StorageDevice&  device;                  // Underlying device
+		DeviceProfile   profile;                 // Modeled device profile
+		std::atomic<uint64_t> injectedTime;      // Total injected delay (ns)
+	};
+
+}
@@ -0,0 +1,193 @@
+/******************************************************************************
+*
+*  2Q cache replacement policy implementation
+*
+*  Loaded pages are put to probationary FIFO queue (A1in). Repeated hits
+*  during probation are considered correlated and do not promote page.
+*  Evicted probationary pages are remembered in ghost queue (A1out), and
+*  if ghost page is requested again, it is loaded directly to main LRU
+*  queue (Am). So pages touched only once (full traversals, reports) pass
+*  through the probationary queue and never flush hot pages of main queue.
+*
+*  Pages of sequential scan are not remembered as ghosts and are evicted
+*  first, even if probationary queue is below its target size.
+*
+*  (C) Boson Database, Bolat Basheyev 2022-2024
+*
+******************************************************************************/
+
+#include "CachedFileIO.h"
+
+#include <algorithm>
+
+using namespace Boson;
+
+
+/**
+* @brief 2Q policy constructor (queue targets are set by setCapacity)
+*/
+TwoQueuePolicy::TwoQueuePolicy() {
+	this->inTarget = 1;
+	this->outTarget = 1;
+}
+
+
+/**
+* @brief Page is loaded: to main queue if it is a ghost, otherwise to probation
+* @param page - loaded cache page
+* @param hint - access hint
+*/
+void TwoQueuePolicy::insert(CachePage* page, AccessHint hint) {
+	auto ghostPage = ghostPagesMap.find(getPageKey(page->fileId, page->filePageNo));
+	if (hint == AccessHint::NORMAL && ghostPage != ghostPagesMap.end()) {
+		// Page is requested again after probation: it is hot
+		ghostPages.erase(ghostPage->second);
+		ghostPagesMap.erase(ghostPage);
+		mainQueue.push_front(page);
+		page->it = mainQueue.begin();
+		page->hot = true;
+		page->inTest = false;
+	} else {
+		inQueue.push_front(page);
+		page->it = inQueue.begin();
+		page->hot = false;
+		page->inTest = (hint == AccessHint::NORMAL);
+	}
+}
+
+
+/**
+* @brief Page is accessed: moves main queue page to the front
+* @param page - accessed cache page
+* @param hint - access hint
+*/
+void TwoQueuePolicy::access(CachePage* page, AccessHint hint) {
+	if (hint == AccessHint::SEQUENTIAL) return;
+	if (page->hot) {
+		mainQueue.erase(page->it);
+		mainQueue.push_front(page);
+		page->it = mainQueue.begin();
+	} else page->inTest = true;  // scan page requested by point access is remembered
+}
+
+
+/**
+* @brief Takes victim from probationary queue if it exceeds target or
+* its oldest page is scan page, otherwise from the back of main queue
+* (pinned pages are skipped)
+* @return victim cache page or nullptr if there are no unpinned pages
+*/
+CachePage* TwoQueuePolicy::evict() {
+	CachePage* probation = lastUnpinned(inQueue);
+	CachePage* victim = nullptr;
+	if (probation != nullptr && (inQueue.size() > inTarget || mainQueue.empty() || !probation->inTest)) {
+		victim = probation;
+	} else {
+		victim = lastUnpinned(mainQueue);
+		if (victim == nullptr) victim = probation;
+	}
+	if (victim == nullptr) return nullptr;
+	if (victim->hot) mainQueue.erase(victim->it);
+	else {
+		inQueue.erase(victim->it);
+		if (victim->inTest) addGhostPage(getPageKey(victim->fileId, victim->filePageNo));
+	}
+	victim->hot = false;
+	victim->inTest = false;
+	return victim;
+}
+
+
+/**
+* @brief Clears policy state
+*/
+void TwoQueuePolicy::clear() {
+	inQueue.clear();
+	mainQueue.clear();
+	ghostPages.clear();
+	ghostPagesMap.clear();
+}
+
+
+/**
+* @brief Remembers evicted probationary page in ghost queue
+* @param pageKey - pool page key of evicted page
+*/
+void TwoQueuePolicy::addGhostPage(uint64_t pageKey) {
+	ghostPages.push_front(pageKey);
+	ghostPagesMap[pageKey] = ghostPages.begin();
+	if (ghostPages.size() > outTarget) {
+		ghostPagesMap.erase(ghostPages.back());
+		ghostPages.pop_back();
+	}
+}
+
+
+/**
+* @brief New pages are added to shard pool (queues hold resident pages only)
+* @param pages - added free pages
+* @param count - pages count
+*/
+void TwoQueuePolicy::addPages(CachePage** pages, uint64_t count) {
+}
+
+
+/**
+* @brief Free pages are removed from shard pool (queues hold resident pages only)
+* @param pages - removed free pages
+* @param count - pages count
+*/
+void TwoQueuePolicy::removePages(CachePage** pages, uint64_t count) {
+}
+
+
+/**
+* @brief Resident page is moved to another pool page keeping its queue position
+* @param from - current cache page
+* @param to - free cache page that takes place of the page
+*/
+void TwoQueuePolicy::movePage(CachePage* from, CachePage* to) {
+	to->it = from->it;
+	to->hot = from->hot;
+	to->inTest = from->inTest;
+	*to->it = to;
+	from->hot = false;
+	from->inTest = false;
+}
+
+
+/**
+* @brief Shard capacity is changed: queue targets follow the capacity
+* @param pagesCount - new shard capacity
+*/
+void TwoQueuePolicy::setCapacity(uint64_t pagesCount) {
+	this->inTarget = std::max(uint64_t(1), pagesCount / 4);
+	this->outTarget = std::max(uint64_t(1), pagesCount / 2);
+	while (ghostPages.size() > outTarget) {
+		ghostPagesMap.erase(ghostPages.back());
+		ghostPages.pop_back();
+	}
+}
+
+
+/**
+* @brief Page leaves the cache without eviction (file is detached from pool)
+* @param page - resident cache page
+*/
+void TwoQueuePolicy::erase(CachePage* page) {
+	if (page->hot) mainQueue.erase(page->it);
+	else inQueue.erase(page->it);
+	page->hot = false;
+	page->inTest = false;
+}
+
+
+/**
+* @brief Lists resident pages from the hottest to the coldest: main queue
+* in LRU order, then probationary queue from the newest page
+* @param resident - pages are appended to the vector
+*/
+void TwoQueuePolicy::getResidentPages(std::vector<CachePage*>& resident) {
+	resident.insert(resident.end(), mainQueue.begin(), mainQueue.end());
+	resident.insert(resident.end(), inQueue.begin(), inQueue.end());
+}
@@ -1,5 +1,8 @@
 #include "BalancedIndexTest.h"
 
+#include <chrono>
+#include <random>
+
 
 using namespace Boson;
 
@@ -189,3 +192,46 @@ void BalancedIndexTest::removeRecords(BalancedIndex* bi) {
 
 }
 
+
+/*
+*  @brief Random key searches (BosonAPI::get) benchmark: bytes copied from
+*  cache and bytes accessed in place (pinned) per search, time per search
+*  @param entriesCount - entries to insert
+*  @param samplesCount - random searches count
+*/
+void BalancedIndexTest::runSearchBenchmark(size_t entriesCount, size_t samplesCount) {
+
+	std::remove(filename);
+
+	CachedFileIO cf;
+	if (!cf.open(filename, 16 * 1024 * 1024)) return;
+
+	RecordFileIO* rf = new RecordFileIO(cf);
+	BalancedIndex* bi = new BalancedIndex(*rf);
+
+	std::string value = "{ \"name\":\"Bolat Basheyev\", \"birthDate\": \"1985.04.15\", "
+		"\"city\":\"Astana\", \"occupation\":\"software developer\" }";
+
+	std::cout << "[TEST]  Inserting " << entriesCount << " entries of " << value.length() << " bytes...\n";
+	for (size_t i = 0; i < entriesCount; i++) bi->insert(i, value);
+
+	std::cout << "[TEST]  Random search of " << samplesCount << " keys...\n\t";
+	std::mt19937_64 rng(1);
+	size_t found = 0;
+	cf.resetStats();
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < samplesCount; i++) {
+		if (bi->search(rng() % entriesCount) != nullptr) found++;
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+	double duration = double(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+
+	std::cout << "Found: " << found << ", ";
+	std::cout << "Search time: " << duration / samplesCount << " ns/op\n\t";
+	std::cout << "Bytes copied from cache: " << cf.getStats(CachedFileStats::TOTAL_BYTES_READ) / samplesCount << " per get, ";
+	std::cout << "bytes pinned: " << cf.getStats(CachedFileStats::TOTAL_BYTES_PINNED) / samplesCount << " per get\n\n";
+
+	delete bi;
+	delete rf;
+	cf.close();
+}
@@ -13,6 +13,7 @@ namespace Boson {
 		bool run(bool clearFile = false);
 		void insertRecords(BalancedIndex* bi);
 		void removeRecords(BalancedIndex* bi);
+		void runSearchBenchmark(size_t entriesCount = 100000, size_t samplesCount = 100000);
 	private:
 		const char* filename;
 	};
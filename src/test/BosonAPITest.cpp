@@ -68,6 +68,66 @@ void BosonAPITest::eraseData() {
 }
 
 
+void BosonAPITest::compactData() {
+
+	std::cout << "============================================================================================" << std::endl;
+	std::cout << "COMPACTING\n";
+	std::cout << "============================================================================================" << std::endl;
+
+	// Erase every second entry to leave free space all over the file
+	std::vector<uint64_t> allRecords;
+	std::map<uint64_t, std::string> expected;
+	auto pair = db.first();
+	while (pair.second != nullptr) {
+		allRecords.push_back(pair.first);
+		expected[pair.first] = *pair.second;
+		pair = db.next();
+	}
+	for (size_t i = 0; i < allRecords.size(); i += 2) {
+		db.erase(allRecords[i]);
+		expected.erase(allRecords[i]);
+	}
+
+	// Compact in small steps interleaved with reads
+	uint64_t steps = 0;
+	uint64_t mismatches = 0;
+	bool isComplete = false;
+	while (!isComplete) {
+		isComplete = db.compact(16);
+		auto value = db.get(expected.rbegin()->first);
+		if (value == nullptr || *value != expected.rbegin()->second) mismatches++;
+		steps++;
+		if (steps % 10 == 0) std::cout << "Step " << steps << " progress: " << db.getCompactionProgress() * 100 << "%" << std::endl;
+	}
+
+	// Every surviving entry must be readable by key with its original value
+	for (auto& entry : expected) {
+		auto value = db.get(entry.first);
+		if (value == nullptr || *value != entry.second) mismatches++;
+	}
+
+	// Traversal must return exactly surviving keys in ascending order
+	auto it = expected.begin();
+	pair = db.first();
+	while (pair.second != nullptr) {
+		if (it == expected.end() || pair.first != it->first || *pair.second != it->second) mismatches++;
+		if (it != expected.end()) it++;
+		pair = db.next();
+	}
+	if (it != expected.end()) mismatches++;
+
+	bool passed = mismatches == 0 &&
+		db.size() == expected.size() &&
+		db.getCompactionProgress() == 1.0 &&
+		db.getReclaimedBytes() > 0;
+
+	std::cout << "Compaction steps: " << steps << std::endl;
+	std::cout << "Entries left: " << db.size() << std::endl;
+	std::cout << "Bytes reclaimed: " << db.getReclaimedBytes();
+	std::cout << " - [" << (passed ? "OK]\n" : "FAILED!]\n");
+}
+
+
 void BosonAPITest::traverseEntries(bool descendingOrder) {
 
 
@@ -106,6 +166,11 @@ void BosonAPITest::run() {
 	db.printTreeState();
 	//traverseEntries(true);
 	eraseData();
+
+	insertData();
+	compactData();
+	traverseEntries();
+	eraseData();
 	
 	//db.printTreeState();
 }
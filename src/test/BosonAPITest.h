@@ -2,6 +2,9 @@
 
 #include "../api/BosonAPI.h"
 #include <iostream>
+#include <map>
+#include <string>
+#include <vector>
 
 
 using namespace Boson;
@@ -16,6 +19,7 @@ namespace Boson {
 	private:
 		void insertData();
 		void eraseData();
+		void compactData();
 		void traverseEntries(bool descendingOrder = false);
 		BosonAPI db;
 	};
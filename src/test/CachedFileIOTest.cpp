@@ -73,6 +73,121 @@ bool CachedFileIOTest::run(size_t samples, size_t jsonSize, double cacheRatio, d
 
 	double stdioPageThroughput = stdioRandomPageReads();
 
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double mappedThroughput = mappedRandomReads();
+	double mappedPageThroughput = mappedRandomPageReads();
+	std::cout << "[RESULT] Read throughput ratio (MAPPED/CACHED): ";
+	std::cout << std::setprecision(4) << mappedThroughput / cachedThroughput << "x random offset, ";
+	std::cout << mappedPageThroughput / cachedPageThroughput << "x page aligned\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double singleThreadThroughput = cachedConcurrentReads(1);
+	for (size_t threads = 2; threads <= 32; threads *= 2) {
+		double concurrentThroughput = cachedConcurrentReads(threads);
+		std::cout << "[RESULT] Concurrent read scaling (" << threads << " threads / 1 thread): ";
+		std::cout << std::setprecision(4) << concurrentThroughput / singleThreadThroughput << "x\n\n";
+	}
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	comparePolicies();
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	compareScanResistance();
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	comparePageSizes();
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double syncThroughput = cachedMixedReadWrites(false);
+	double writeBackThroughput = cachedMixedReadWrites(true);
+	std::cout << "[RESULT] Mixed read/write throughput ratio (WRITE-BACK/SYNC): ";
+	std::cout << std::setprecision(4) << writeBackThroughput / syncThroughput << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	cachedCheckpoint(0.01);
+	cachedCheckpoint(0.10);
+	cachedCheckpoint(0.50);
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double amplification = cachedSmallUpdates(32);
+	std::cout << "[RESULT] Write amplification of 32 byte updates (STORAGE/LOGICAL): ";
+	std::cout << std::setprecision(4) << amplification << "x (whole pages: " << PAGE_SIZE / 32 << "x)\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	for (size_t cacheSize = 8 * 1024 * 1024; cacheSize <= 512 * 1024 * 1024; cacheSize *= 4) {
+		cachedFlushLatency(cacheSize);
+	}
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double reopenHits = cachedCacheResize(false);
+	double onlineHits = cachedCacheResize(true);
+	std::cout << "[RESULT] Cache hit rate after resize (ONLINE/REOPEN): ";
+	std::cout << std::setprecision(4) << onlineHits / reopenHits << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double privateThroughput = cachedSharedPool(false);
+	double sharedThroughput = cachedSharedPool(true);
+	std::cout << "[RESULT] Skewed reads of 50 databases throughput ratio (SHARED/PRIVATE pools): ";
+	std::cout << std::setprecision(4) << sharedThroughput / privateThroughput << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	cachedSharedPoolFlush();
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double coldHits = cachedWarmRestart(false);
+	double warmHits = cachedWarmRestart(true);
+	std::cout << "[RESULT] Cache hit rate after restart (WARM-UP/COLD): ";
+	std::cout << std::setprecision(4) << warmHits / coldHits << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	cachedLatencyHistograms();
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double fileThroughput = cachedStorageDevice(FILE_STORAGE);
+	double memoryThroughput = cachedStorageDevice(MEMORY_STORAGE);
+	double simulatedThroughput = cachedStorageDevice(SIMULATED_STORAGE);
+	std::cout << "[RESULT] Random read throughput ratio (MEMORY/FILE): ";
+	std::cout << std::setprecision(4) << memoryThroughput / fileThroughput << "x, ";
+	std::cout << "simulated NVMe: " << simulatedThroughput / fileThroughput << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double syncReadThroughput = cachedLargeReads(false);
+	double groupReadThroughput = cachedLargeReads(true);
+	std::cout << "[RESULT] Large reads throughput ratio (GROUP/SYNC): ";
+	std::cout << std::setprecision(4) << groupReadThroughput / syncReadThroughput << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double bufferedThroughput = cachedDirectReads(false, false);
+	double directThroughput = cachedDirectReads(true, false);
+	double directHugeThroughput = cachedDirectReads(true, true);
+	std::cout << "[RESULT] Random read throughput ratio (DIRECT/BUFFERED): ";
+	std::cout << std::setprecision(4) << directThroughput / bufferedThroughput << "x, ";
+	std::cout << "with huge pages pool: " << directHugeThroughput / bufferedThroughput << "x\n\n";
+
+	std::this_thread::sleep_for(std::chrono::seconds(1));
+
+	double scanThroughput = cachedSequentialScan(false);
+	double readAheadThroughput = cachedSequentialScan(true);
+	std::cout << "[RESULT] Sequential scan throughput ratio (READ-AHEAD/NO READ-AHEAD): ";
+	std::cout << std::setprecision(4) << readAheadThroughput / scanThroughput << "x\n\n";
+
 	std::this_thread::sleep_for(std::chrono::seconds(1));
 		
 	double ratio = cachedThroughput / stdioThroughput; 
@@ -178,7 +293,9 @@ double CachedFileIOTest::cachedRandomWrites() {
 	double cachedDuration = cf.getStats(CachedFileStats::TOTAL_WRITE_TIME_NS) / 1000000.0;
 	double throughput = cf.getStats(CachedFileStats::WRITE_THROUGHPUT);
 	std::cout << pos << " bytes (" << cachedDuration << "ms), ";
-	std::cout << "Write: " << throughput << " Mb/sec\n\n";
+	std::cout << "Write: " << throughput << " Mb/sec, ";
+	std::cout << "Storage read: " << cf.getStats(CachedFileStats::STORAGE_BYTES_READ) << " bytes, ";
+	std::cout << "Fetches skipped: " << cf.getStats(CachedFileStats::SKIPPED_FETCHES) << "\n\n";
 
 	return throughput;
 }
@@ -219,10 +336,11 @@ double CachedFileIOTest::randNormal(double mean, double stddev)
 /**
 * 
 *  @brief Random reads using cache as 10% size of file
+*  @param policy - cache replacement policy
 *  @return random read throughput in Mb/s
 * 
 */
-double CachedFileIOTest::cachedRandomReads() {
+double CachedFileIOTest::cachedRandomReads(CachePolicyType policy) {
 
 	CachedFileIO cachedFile;
 
@@ -231,7 +349,7 @@ double CachedFileIOTest::cachedRandomReads() {
 	size_t offset;
 
 
-	cf.open(this->fileName);
+	cf.open(this->fileName, DEFAULT_CACHE, false, policy);
 	size_t fileSize = cf.getFileSize();
 	cf.setCacheSize(size_t(fileSize * cacheRatio));
 		
@@ -256,10 +374,147 @@ double CachedFileIOTest::cachedRandomReads() {
 	double throughput = cf.getStats(CachedFileStats::READ_THROUGHPUT);
 	std::cout << bytesRead << " bytes (" << readTime << "ms), ";
 	std::cout << "Read: " << throughput << " Mb/sec, \n\t";
-	std::cout << "Cache Hit: " << cf.getStats(CachedFileStats::CACHE_HITS_RATE) << "%\n\n";
+	std::cout << "Cache Hit: " << cf.getStats(CachedFileStats::CACHE_HITS_RATE) << "%, ";
+	std::cout << "Read time: " << cf.getStats(CachedFileStats::TOTAL_READ_TIME_NS) / samplesCount << " ns/op\n\n";
+
+	cf.close();
+
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Compares cache replacement policies on the same normal distribution workload
+*
+*/
+void CachedFileIOTest::comparePolicies() {
+	const CachePolicyType policies[] = { CachePolicyType::LRU, CachePolicyType::CLOCK, CachePolicyType::CLOCK_PRO, CachePolicyType::TWO_QUEUE };
+	const char* names[] = { "LRU", "CLOCK", "CLOCK-Pro", "2Q" };
+	for (size_t i = 0; i < 4; i++) {
+		std::cout << "[POLICY] " << names[i] << std::endl;
+		// same random sequence for every policy
+		std::srand(1);
+		cachedRandomReads(policies[i]);
+	}
+}
+
+
+
+/**
+*
+*  @brief Point reads hit rate after full sequential scan of the file:
+*  warms up cache by point reads, scans whole file page by page and
+*  measures cache hits of the same point reads workload after the scan
+*  @param policy - cache replacement policy
+*  @param scanHint - access hint passed by sequential scan
+*  @return point reads cache hit rate after the scan (0-100%)
+*
+*/
+double CachedFileIOTest::scanResistance(CachePolicyType policy, AccessHint scanHint) {
+
+	char* buf = new char[PAGE_SIZE];
+	size_t offset, length = docSize;
+
+	cf.open(this->fileName, DEFAULT_CACHE, false, policy);
+	size_t fileSize = cf.getFileSize();
+	size_t maxPages = fileSize / PAGE_SIZE;
+	cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	// Warm up cache by point reads
+	std::srand(1);
+	for (size_t i = 0; i < samplesCount / 2; i++) {
+		offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - length));
+		if (offset < fileSize) cf.read(offset, buf, length);
+	}
+
+	// Full traversal of the file
+	for (size_t pageNo = 0; pageNo < maxPages; pageNo++) {
+		cf.read(pageNo * PAGE_SIZE, buf, PAGE_SIZE, scanHint);
+	}
+
+	// Measure point reads after the scan
+	cf.resetStats();
+	for (size_t i = 0; i < samplesCount / 100; i++) {
+		offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - length));
+		if (offset < fileSize) cf.read(offset, buf, length);
+	}
+	double hitRate = cf.getStats(CachedFileStats::CACHE_HITS_RATE);
+	std::cout << "\tPoint reads cache hit after full scan: " << hitRate << "%\n\n";
 
 	cf.close();
+	delete[] buf;
+
+	return hitRate;
+}
+
+
+
+/**
+*
+*  @brief Compares point reads hit rate after full scan for replacement policies
+*
+*/
+void CachedFileIOTest::compareScanResistance() {
+	const CachePolicyType policies[] = { CachePolicyType::LRU, CachePolicyType::LRU, CachePolicyType::CLOCK_PRO, CachePolicyType::TWO_QUEUE, CachePolicyType::TWO_QUEUE };
+	const AccessHint hints[] = { AccessHint::NORMAL, AccessHint::SEQUENTIAL, AccessHint::SEQUENTIAL, AccessHint::NORMAL, AccessHint::SEQUENTIAL };
+	const char* names[] = { "LRU", "LRU + scan hint", "CLOCK-Pro + scan hint", "2Q", "2Q + scan hint" };
+	for (size_t i = 0; i < 5; i++) {
+		std::cout << "[SCAN]  " << names[i] << std::endl;
+		scanResistance(policies[i], hints[i]);
+	}
+}
+
+
+/**
+*
+*  @brief Runs workload on cached file with specified page size
+*  @param pageSize - cache page size
+*  @param workload - 0: point lookups, 1: sequential scan, 2: random updates
+*  @return throughput in Mb/s (updates include flush time)
+*
+*/
+double CachedFileIOTest::cachedPageSizeWorkload(size_t pageSize, int workload) {
+
+	char* buf = new char[docSize];
+	memset(buf, 'P', docSize);
+
+	cf.setPageSize(pageSize);
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::srand(1);
+	size_t bytesCount = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	if (workload == 0) {
+		for (size_t i = 0; i < samplesCount; i++) {
+			size_t offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - docSize));
+			if (offset < fileSize) bytesCount += cf.read(offset, buf, docSize);
+		}
+	} else if (workload == 1) {
+		for (size_t offset = 0; offset < fileSize; offset += docSize) {
+			bytesCount += cf.read(offset, buf, docSize, AccessHint::SEQUENTIAL);
+		}
+	} else {
+		for (size_t i = 0; i < samplesCount / 4; i++) {
+			size_t offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - docSize));
+			if (offset < fileSize - docSize) bytesCount += cf.write(offset, buf, docSize);
+		}
+		cf.flush();
+	}
+	auto endTime = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	double throughput = double(bytesCount) / (1024 * 1024) / seconds;
 
+	std::cout << std::setw(12) << std::setprecision(5) << throughput << " Mb/s ";
+	std::cout << "(" << std::setw(5) << std::setprecision(4) << cf.getStats(CachedFileStats::CACHE_HITS_RATE) << "%)";
+
+	cf.close();
+	cf.setPageSize(PAGE_SIZE);
 	delete[] buf;
 
 	return throughput;
@@ -267,6 +522,28 @@ double CachedFileIOTest::cachedRandomReads() {
 
 
 
+/**
+*
+*  @brief Prints throughput matrix of page sizes and workloads with the same
+*  cache size in bytes (cache hits rate in brackets)
+*
+*/
+void CachedFileIOTest::comparePageSizes() {
+	const char* workloads[] = { "POINT LOOKUPS", "SEQUENTIAL SCAN", "RANDOM UPDATES" };
+	std::cout << "[TEST]  CACHED page size x workload matrix (" << docSize << " byte blocks):\n";
+	std::cout << "\tPage size";
+	for (size_t w = 0; w < 3; w++) std::cout << std::setw(27) << workloads[w];
+	std::cout << "\n";
+	for (size_t pageSize = MIN_PAGE_SIZE; pageSize <= MAX_PAGE_SIZE; pageSize *= 2) {
+		std::cout << "\t" << std::setw(9) << pageSize;
+		for (int w = 0; w < 3; w++) cachedPageSizeWorkload(pageSize, w);
+		std::cout << "\n";
+	}
+	std::cout << "\n";
+}
+
+
+
 /**
 *
 *  @brief Random reads using STDIO
@@ -373,6 +650,102 @@ double CachedFileIOTest::cachedRandomPageReads() {
 }
 
 
+/**
+*
+*  @brief Random reads of memory mapped file (same distribution as cached)
+*  @return random read throughput in Mb/s
+*
+*/
+double CachedFileIOTest::mappedRandomReads() {
+
+	MappedFileIO mf;
+
+	char* buf = new char[PAGE_SIZE * 4];
+	size_t length = docSize, bytesRead = 0;
+	size_t offset;
+
+	if (!mf.open(this->fileName, true)) {
+		std::cout << "[TEST]  MAPPED random read: memory mapping is not supported\n\n";
+		delete[] buf;
+		return 0;
+	}
+	size_t fileSize = mf.getFileSize();
+
+	std::cout << "[TEST]  MAPPED random read " << samplesCount;
+	std::cout << " of " << docSize << " byte blocks...\n\t";
+
+	for (size_t i = 0; i < samplesCount; i++) {
+		// generate random
+		offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - length));
+		// offset always positive because its size_t
+		if (offset < fileSize) {
+			mf.read(offset, buf, length);
+			bytesRead += length;
+		}
+	}
+
+	double readTime = (mf.getStats(CachedFileStats::TOTAL_READ_TIME_NS) / 1000000.0);
+	double throughput = mf.getStats(CachedFileStats::READ_THROUGHPUT);
+	std::cout << bytesRead << " bytes (" << readTime << "ms), ";
+	std::cout << "Read: " << throughput << " Mb/sec, \n\t";
+	std::cout << "Read time: " << mf.getStats(CachedFileStats::TOTAL_READ_TIME_NS) / samplesCount << " ns/op\n\n";
+
+	mf.close();
+
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Random page reads of memory mapped file (same distribution as cached)
+*  @return random read throughput in Mb/s
+*
+*/
+double CachedFileIOTest::mappedRandomPageReads() {
+
+	MappedFileIO mf;
+
+	char* buf = new char[PAGE_SIZE];
+	size_t bytesRead = 0;
+	size_t pageNo;
+
+	if (!mf.open(this->fileName, true)) {
+		std::cout << "[TEST]  MAPPED random PAGE ALIGNED read: memory mapping is not supported\n\n";
+		delete[] buf;
+		return 0;
+	}
+	size_t maxPages = mf.getFileSize() / PAGE_SIZE;
+
+	std::cout << "[TEST]  MAPPED random PAGE ALIGNED read " << samplesCount;
+	std::cout << " of " << PAGE_SIZE << " byte blocks...\n\t";
+
+	for (size_t i = 0; i < samplesCount; i++) {
+		// generate random page number
+		pageNo = size_t(randNormal(0.5, this->sigma) * double(maxPages));
+		// offset always positive because its size_t
+		if (pageNo < maxPages) {
+			bytesRead += mf.readPage(pageNo, buf);
+		}
+	}
+
+	double readTime = (mf.getStats(CachedFileStats::TOTAL_READ_TIME_NS) / 1000000.0);
+	double throughput = mf.getStats(CachedFileStats::READ_THROUGHPUT);
+	std::cout << bytesRead << " bytes (" << readTime << "ms), ";
+	std::cout << "Read: " << throughput << " Mb/sec\n\n";
+
+	mf.close();
+
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
 /**
 *
 *  @brief Random page reads using STDIO
@@ -430,3 +803,789 @@ double CachedFileIOTest::stdioRandomPageReads() {
 
 	return throughput;
 }
+
+
+
+/**
+*
+*  @brief Random reads from multiple threads sharing one cache as 10% size of file
+*  @param threadsCount - number of concurrent reader threads
+*  @return random read throughput in Mb/s (wall clock)
+*
+*/
+double CachedFileIOTest::cachedConcurrentReads(size_t threadsCount) {
+
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED concurrent random read " << samplesCount;
+	std::cout << " of " << docSize << " byte blocks by " << threadsCount << " threads...\n\t";
+
+	size_t length = docSize;
+	size_t samplesPerThread = samplesCount / threadsCount;
+	std::vector<std::thread> threads;
+	std::atomic<size_t> bytesRead = 0;
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	for (size_t t = 0; t < threadsCount; t++) {
+		threads.emplace_back([&, t]() {
+			// randNormal() keeps static state, so each thread has its own generator
+			std::mt19937_64 generator(t);
+			std::normal_distribution<double> distribution(0.5, this->sigma);
+			char* buf = new char[PAGE_SIZE * 4];
+			size_t offset, threadBytesRead = 0;
+			for (size_t i = 0; i < samplesPerThread; i++) {
+				offset = size_t(distribution(generator) * double(fileSize - length));
+				// offset always positive because its size_t
+				if (offset < fileSize) {
+					threadBytesRead += cf.read(offset, buf, length);
+				}
+			}
+			bytesRead += threadBytesRead;
+			delete[] buf;
+		});
+	}
+	for (std::thread& thread : threads) thread.join();
+
+	auto endTime = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	double throughput = (bytesRead / 1024.0 / 1024.0) / seconds;
+
+	std::cout << bytesRead << " bytes (" << seconds * 1000.0 << "ms), ";
+	std::cout << "Read: " << throughput << " Mb/sec, \n\t";
+	std::cout << "Cache Hit: " << cf.getStats(CachedFileStats::CACHE_HITS_RATE) << "%\n\n";
+
+	cf.close();
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Random reads and writes (70% / 30%) using cache as 10% size of file,
+*  counts dirty pages persisted by cache misses on the caller's thread
+*  @param writeBack - enable background write-back thread
+*  @return read/write throughput in Mb/s
+*
+*/
+double CachedFileIOTest::cachedMixedReadWrites(bool writeBack) {
+
+	char* buf = new char[PAGE_SIZE];
+	memset(buf, 'W', PAGE_SIZE);
+	size_t offset, length = docSize, bytesTransferred = 0;
+
+	cf.setWriteBack(writeBack);
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED random read/write " << samplesCount;
+	std::cout << " of " << docSize << " byte blocks (write-back " << (writeBack ? "ON" : "OFF") << ")...\n\t";
+
+	std::srand(1);
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < samplesCount; i++) {
+		offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - length));
+		if (offset >= fileSize) continue;
+		if (std::rand() % 10 < 3) bytesTransferred += cf.write(offset, buf, length);
+		else bytesTransferred += cf.read(offset, buf, length);
+	}
+	auto endTime = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	double throughput = (bytesTransferred / 1024.0 / 1024.0) / seconds;
+
+	std::cout << bytesTransferred << " bytes (" << seconds * 1000.0 << "ms), ";
+	std::cout << "Read/Write: " << throughput << " Mb/sec, \n\t";
+	std::cout << "Dirty evictions: " << cf.getStats(CachedFileStats::TOTAL_DIRTY_EVICTIONS) << ", ";
+	std::cout << "Write-back pages: " << cf.getStats(CachedFileStats::TOTAL_WRITEBACK_PAGES) << "\n\n";
+
+	cf.close();
+	cf.setWriteBack(false);
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Checkpoint: whole file is cached, random runs of pages are
+*  rewritten and flushed, reports storage write calls and bytes per flush
+*  @param dirtyRatio - share of cached pages rewritten before flush
+*  @return flush duration in ms
+*
+*/
+double CachedFileIOTest::cachedCheckpoint(double dirtyRatio) {
+
+	char* buf = new char[PAGE_SIZE];
+	memset(buf, 'C', PAGE_SIZE);
+
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	size_t maxPages = fileSize / PAGE_SIZE;
+	cf.setCacheSize(fileSize + PAGE_SIZE * MAX_SHARDS);
+
+	// Load whole file to cache
+	for (size_t pageNo = 0; pageNo < maxPages; pageNo++) cf.readPage(pageNo, buf);
+
+	std::cout << "[TEST]  CACHED checkpoint of " << dirtyRatio * 100 << "% dirty pages";
+	std::cout << " (" << maxPages << " cached pages)...\n\t";
+
+	// Rewrite random runs of 1-16 pages
+	std::mt19937_64 generator(1);
+	size_t dirtyPages = size_t(maxPages * dirtyRatio);
+	for (size_t written = 0; written < dirtyPages; ) {
+		size_t runLength = 1 + generator() % 16;
+		size_t pageNo = generator() % maxPages;
+		for (size_t i = 0; i < runLength && pageNo + i < maxPages; i++, written++) {
+			cf.write((pageNo + i) * PAGE_SIZE, buf, 64);
+		}
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	cf.flush();
+	auto endTime = std::chrono::steady_clock::now();
+	double duration = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+	double flushes = cf.getStats(CachedFileStats::TOTAL_FLUSHES);
+	std::cout << "Flush: " << duration << "ms, ";
+	std::cout << "write calls: " << cf.getStats(CachedFileStats::FLUSH_WRITE_CALLS) / flushes << ", ";
+	std::cout << "bytes: " << cf.getStats(CachedFileStats::FLUSH_BYTES_WRITTEN) / flushes << " per flush\n\n";
+
+	cf.close();
+	delete[] buf;
+
+	return duration;
+}
+
+
+/**
+*
+*  @brief Small in-place updates of cached file (like record header updates)
+*  and flush, compares bytes written to storage with bytes written by user
+*  @param updateSize - bytes of every update
+*  @return write amplification (storage bytes / logical bytes)
+*
+*/
+double CachedFileIOTest::cachedSmallUpdates(size_t updateSize) {
+
+	char* buf = new char[PAGE_SIZE];
+	memset(buf, 'U', PAGE_SIZE);
+
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	size_t maxPages = fileSize / PAGE_SIZE;
+	cf.setCacheSize(fileSize + PAGE_SIZE * MAX_SHARDS);
+
+	// Load whole file to cache
+	for (size_t pageNo = 0; pageNo < maxPages; pageNo++) cf.readPage(pageNo, buf);
+	cf.resetStats();
+
+	size_t updates = maxPages / 4;
+	std::cout << "[TEST]  CACHED " << updates << " random updates of " << updateSize << " bytes and flush...\n\t";
+
+	// Update random offsets of random pages
+	std::mt19937_64 generator(1);
+	for (size_t i = 0; i < updates; i++) {
+		size_t position = (generator() % maxPages) * PAGE_SIZE + generator() % (PAGE_SIZE - updateSize);
+		cf.write(position, buf, updateSize);
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	cf.flush();
+	auto endTime = std::chrono::steady_clock::now();
+	double duration = std::chrono::duration<double, std::milli>(endTime - startTime).count();
+
+	double logicalBytes = cf.getStats(CachedFileStats::TOTAL_BYTES_WRITTEN);
+	double storageBytes = cf.getStats(CachedFileStats::STORAGE_BYTES_WRITTEN);
+	std::cout << "Flush: " << duration << "ms, ";
+	std::cout << "logical bytes: " << logicalBytes << ", ";
+	std::cout << "storage bytes: " << storageBytes << ", ";
+	std::cout << "write calls: " << cf.getStats(CachedFileStats::FLUSH_WRITE_CALLS) << "\n\n";
+
+	cf.close();
+	delete[] buf;
+
+	return storageBytes / logicalBytes;
+}
+
+
+
+/**
+*
+*  @brief Flush latency for cache of given size with fixed dirty pages count:
+*  cache is filled with pages, then random pages are rewritten and flushed
+*  @param cacheSize - cache size in bytes
+*  @param dirtyPages - pages rewritten before every flush
+*  @return average flush duration in ms
+*
+*/
+double CachedFileIOTest::cachedFlushLatency(size_t cacheSize, size_t dirtyPages) {
+
+	const size_t rounds = 20;
+	char* buf = new char[PAGE_SIZE];
+	memset(buf, 'F', PAGE_SIZE);
+
+	cf.open(this->fileName, cacheSize);
+	size_t maxPages = cf.getFileSize() / PAGE_SIZE;
+	size_t cachePages = cf.getCacheSize() / PAGE_SIZE;
+
+	// Fill cache (pages beyond end of file are cached empty)
+	for (size_t pageNo = 0; pageNo < cachePages; pageNo++) cf.readPage(pageNo, buf);
+
+	std::cout << "[TEST]  CACHED flush of " << dirtyPages << " dirty pages";
+	std::cout << " (" << cachePages << " cached pages)...\n\t";
+
+	std::mt19937_64 generator(1);
+	size_t dirtyRange = std::min(maxPages, cachePages);
+	double duration = 0;
+	for (size_t round = 0; round < rounds; round++) {
+		for (size_t i = 0; i < dirtyPages; i++) {
+			cf.write((generator() % dirtyRange) * PAGE_SIZE, buf, 64);
+		}
+		auto startTime = std::chrono::steady_clock::now();
+		cf.flush();
+		auto endTime = std::chrono::steady_clock::now();
+		duration += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	}
+
+	std::cout << "Flush: " << duration / rounds << " ms/flush\n\n";
+
+	cf.close();
+	delete[] buf;
+
+	return duration / rounds;
+}
+
+
+
+/**
+*
+*  @brief Normal distribution reads while cache grows twice and shrinks back
+*  to half of its size. Online resize keeps cached pages, reopen emulates
+*  resize that persists and releases whole cache.
+*  @param online - resize cache of open file, otherwise close and reopen file
+*  @return average cache hit rate of reads after resize (0-100%)
+*
+*/
+double CachedFileIOTest::cachedCacheResize(bool online) {
+
+	char* buf = new char[docSize];
+
+	cf.open(this->fileName, DEFAULT_CACHE);
+	size_t fileSize = cf.getFileSize();
+	size_t cacheSize = cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED " << (online ? "online resize" : "reopen");
+	std::cout << " of " << cacheSize / 1024 << "Kb cache during random reads...\n\t";
+
+	auto randomReads = [&](size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			size_t offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - docSize));
+			if (offset < fileSize) cf.read(offset, buf, docSize);
+		}
+	};
+
+	// Warm up cache
+	randomReads(samplesCount / 2);
+
+	size_t newSizes[] = { cacheSize * 2, cacheSize / 2 };
+	double resizeTime = 0, hitRate = 0;
+	for (size_t newSize : newSizes) {
+		auto startTime = std::chrono::steady_clock::now();
+		if (online) cf.setCacheSize(newSize);
+		else {
+			cf.close();
+			cf.open(this->fileName, newSize);
+		}
+		auto endTime = std::chrono::steady_clock::now();
+		resizeTime += std::chrono::duration<double, std::milli>(endTime - startTime).count();
+		cf.resetStats();
+		randomReads(samplesCount / 50);
+		double hits = cf.getStats(CachedFileStats::CACHE_HITS_RATE);
+		std::cout << newSize / 1024 << "Kb cache hit: " << hits << "%, ";
+		hitRate += hits;
+	}
+	std::cout << "Resize: " << resizeTime / 2 << " ms\n\n";
+
+	cf.close();
+	delete[] buf;
+
+	return hitRate / 2;
+}
+
+
+
+/**
+*
+*  @brief Skewed reads of many databases with the same total cache memory:
+*  every file has private cache of equal size or all files draw pages from
+*  one shared pool. Files are chosen by Zipf distribution (file i gets
+*  traffic proportional to 1/i), offsets within file are normal distributed.
+*  @param shared - files share one pool, otherwise memory is split statically
+*  @param filesCount - databases count
+*  @return read throughput in Mb/s
+*
+*/
+double CachedFileIOTest::cachedSharedPool(bool shared, size_t filesCount) {
+
+	const size_t fileSize = 2 * 1024 * 1024;
+	const size_t fileCache = MINIMAL_CACHE;
+	char* buf = new char[fileSize];
+	memset(buf, 0, fileSize);
+
+	// Create files and open them with private caches or shared pool
+	BufferPool pool;
+	if (shared) pool.allocate(fileCache * filesCount);
+	std::vector<std::string> paths(filesCount);
+	std::vector<CachedFileIO*> files(filesCount);
+	std::vector<double> weights(filesCount);
+	for (size_t i = 0; i < filesCount; i++) {
+		paths[i] = std::string(this->fileName) + ".pool" + std::to_string(i);
+		if (std::filesystem::exists(paths[i])) std::filesystem::remove(paths[i]);
+		files[i] = new CachedFileIO();
+		if (shared) files[i]->open(paths[i].c_str(), pool);
+		else files[i]->open(paths[i].c_str(), fileCache);
+		files[i]->write(0, buf, fileSize);
+		files[i]->flush();
+		weights[i] = 1.0 / double(i + 1);
+	}
+
+	std::cout << "[TEST]  CACHED skewed reads of " << filesCount << " files of " << fileSize / 1024 << "Kb";
+	std::cout << (shared ? " (SHARED pool of " : " (PRIVATE caches of ");
+	std::cout << (shared ? fileCache * filesCount : fileCache) / 1024 << "Kb)...\n\t";
+
+	std::mt19937_64 generator(1);
+	std::discrete_distribution<size_t> fileDistribution(weights.begin(), weights.end());
+	auto randomReads = [&](size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			size_t offset = size_t(randNormal(0.5, 0.15) * double(fileSize - docSize));
+			if (offset < fileSize - docSize) files[fileDistribution(generator)]->read(offset, buf, docSize);
+		}
+	};
+
+	// Warm up caches
+	randomReads(samplesCount / 2);
+	for (CachedFileIO* file : files) file->resetStats();
+
+	auto startTime = std::chrono::steady_clock::now();
+	randomReads(samplesCount);
+	auto endTime = std::chrono::steady_clock::now();
+	double duration = std::chrono::duration<double>(endTime - startTime).count();
+	double throughput = double(samplesCount * docSize) / (1024.0 * 1024.0) / duration;
+
+	double requests = 0, hits = 0;
+	for (CachedFileIO* file : files) {
+		requests += file->getStats(CachedFileStats::TOTAL_REQUESTS);
+		hits += file->getStats(CachedFileStats::TOTAL_CACHE_HITS);
+	}
+	std::cout << "Read: " << throughput << " Mb/sec, ";
+	std::cout << "Cache Hit: " << (requests > 0 ? hits / requests * 100.0 : 0) << "%, ";
+	std::cout << "hottest file: " << files[0]->getStats(CachedFileStats::CACHE_HITS_RATE) << "%, ";
+	std::cout << "coldest file: " << files[filesCount - 1]->getStats(CachedFileStats::CACHE_HITS_RATE) << "%\n\n";
+
+	// Close files before pool is released
+	for (size_t i = 0; i < filesCount; i++) {
+		files[i]->close();
+		delete files[i];
+		std::filesystem::remove(paths[i]);
+	}
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Reads cached pages of one file while other file of the same
+*  shared pool is flushed to device with slow sync. Sync runs without
+*  shard latches, so reads of other databases must not wait for it.
+*  @return the longest read latency in milliseconds
+*
+*/
+double CachedFileIOTest::cachedSharedPoolFlush() {
+
+	const size_t fileSize = 2 * 1024 * 1024;
+	const size_t flushesCount = 20;
+	const DeviceProfile slowSyncDevice = { 0, 0, 20000000, 0 };
+	char* buf = new char[fileSize];
+	memset(buf, 0, fileSize);
+
+	// Flushed file lives on simulated device with 20ms sync latency
+	BufferPool pool;
+	pool.allocate(4 * fileSize);
+	MemoryDevice memoryDevice;
+	SimulatedDevice simulatedDevice(memoryDevice, slowSyncDevice);
+	std::string readPath = std::string(this->fileName) + ".pool-read";
+	if (std::filesystem::exists(readPath)) std::filesystem::remove(readPath);
+	CachedFileIO flushedFile, readFile;
+	flushedFile.setStorageDevice(&simulatedDevice);
+	flushedFile.open(this->fileName, pool);
+	readFile.open(readPath.c_str(), pool);
+	flushedFile.write(0, buf, fileSize);
+	readFile.write(0, buf, fileSize);
+	readFile.flush();
+
+	std::cout << "[TEST]  CACHED reads of one file while " << flushesCount;
+	std::cout << " flushes with " << slowSyncDevice.syncLatencyNs / 1000000 << "ms sync of other file (SHARED pool)...\n\t";
+
+	// Keep dirtying and flushing one file in background
+	std::atomic<bool> isFlushing(true);
+	std::thread flusher([&]() {
+		for (size_t i = 0; i < flushesCount; i++) {
+			flushedFile.write((i * PAGE_SIZE) % fileSize, buf, docSize);
+			flushedFile.flush();
+		}
+		isFlushing = false;
+	});
+
+	// Read cached pages of other file until flushes are over
+	uint64_t readsCount = 0;
+	double maxLatency = 0;
+	while (isFlushing) {
+		size_t offset = (readsCount * docSize) % (fileSize - docSize);
+		auto startTime = std::chrono::steady_clock::now();
+		readFile.read(offset, buf, docSize);
+		auto endTime = std::chrono::steady_clock::now();
+		maxLatency = std::max(maxLatency, std::chrono::duration<double, std::milli>(endTime - startTime).count());
+		readsCount++;
+	}
+	flusher.join();
+
+	bool passed = maxLatency < double(slowSyncDevice.syncLatencyNs) / 2000000.0;
+	std::cout << "Reads: " << readsCount << ", longest read: " << std::setprecision(4) << maxLatency << " ms";
+	std::cout << " - [" << (passed ? "OK]\n\n" : "FAILED!]\n\n");
+
+	// Close files before pool is released
+	flushedFile.close();
+	flushedFile.setStorageDevice(nullptr);
+	readFile.close();
+	std::filesystem::remove(readPath);
+	delete[] buf;
+
+	return maxLatency;
+}
+
+
+
+/**
+*
+*  @brief Normal distribution reads before and right after restart. With
+*  warm-up resident pages are saved to manifest on close and restored by
+*  background thread on open while reads go on.
+*  @param warmUp - save and restore resident pages on restart
+*  @return cache hit rate of reads right after restart (0-100%)
+*
+*/
+double CachedFileIOTest::cachedWarmRestart(bool warmUp) {
+
+	char* buf = new char[docSize];
+	std::string manifestPath = std::string(this->fileName) + WARM_UP_SUFFIX;
+	if (std::filesystem::exists(manifestPath)) std::filesystem::remove(manifestPath);
+
+	cf.setWarmUp(warmUp);
+	cf.open(this->fileName, DEFAULT_CACHE);
+	size_t fileSize = cf.getFileSize();
+	size_t cacheSize = cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED random reads after restart " << (warmUp ? "with" : "without");
+	std::cout << " warm-up of " << cacheSize / 1024 << "Kb cache...\n\t";
+
+	auto randomReads = [&](size_t count) {
+		for (size_t i = 0; i < count; i++) {
+			size_t offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - docSize));
+			if (offset < fileSize) cf.read(offset, buf, docSize);
+		}
+	};
+
+	// Reach steady state hit rate and restart
+	randomReads(samplesCount / 2);
+	cf.close();
+	cf.open(this->fileName, cacheSize);
+	randomReads(samplesCount / 500);
+	double hits = cf.getStats(CachedFileStats::CACHE_HITS_RATE);
+	while (cf.isWarmingUp()) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+	std::cout << "Cache hit: " << hits << "%, ";
+	std::cout << "restored: " << cf.getStats(CachedFileStats::WARM_UP_PAGES) << " pages ";
+	std::cout << "in " << cf.getStats(CachedFileStats::WARM_UP_TIME_NS) / 1000000.0 << " ms\n\n";
+
+	cf.close();
+	cf.setWarmUp(false);
+	if (std::filesystem::exists(manifestPath)) std::filesystem::remove(manifestPath);
+	delete[] buf;
+
+	return hits;
+}
+
+
+
+/**
+*
+*  @brief Random read/write workload with periodic flushes, prints latency
+*  percentiles of cache hits, misses, dirty evictions and flushes taken
+*  from stats snapshot
+*
+*/
+void CachedFileIOTest::cachedLatencyHistograms() {
+
+	char* buf = new char[docSize];
+	memset(buf, 'L', docSize);
+
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	size_t cacheSize = cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED latency percentiles of random read/write " << samplesCount;
+	std::cout << " of " << docSize << " byte blocks (" << cacheSize / 1024 << "Kb cache)...\n";
+
+	std::srand(1);
+	for (size_t i = 0; i < samplesCount; i++) {
+		size_t offset = size_t(randNormal(0.5, this->sigma * 4) * double(fileSize - docSize));
+		if (offset >= fileSize - docSize) continue;
+		if (std::rand() % 10 < 3) cf.write(offset, buf, docSize);
+		else cf.read(offset, buf, docSize);
+		if (i % 10000 == 0) cf.flush();
+	}
+
+	FileIOStats stats;
+	cf.getStatsSnapshot(stats);
+	printLatency("Hits", stats.hitLatency);
+	printLatency("Misses", stats.missLatency);
+	printLatency("Evictions", stats.evictionLatency);
+	printLatency("Flushes", stats.flushLatency);
+	std::cout << "\n";
+
+	cf.close();
+	delete[] buf;
+}
+
+
+/**
+*
+*  @brief Normal distribution reads of the first part of the file (64Mb)
+*  stored on OS file, memory device or simulated NVMe device over memory
+*  device (device data copied from the file)
+*  @param deviceType - storage device type
+*  @return read throughput MB/sec
+*
+*/
+double CachedFileIOTest::cachedStorageDevice(TestStorageDevice deviceType) {
+
+	const char* deviceNames[] = { "FILE", "MEMORY", "SIMULATED NVMe" };
+	const size_t readsCount = samplesCount / 10;
+	const size_t chunkSize = 1024 * 1024;
+	char* buf = new char[chunkSize];
+
+	FileDevice sourceFile;
+	MemoryDevice memoryDevice;
+	SimulatedDevice simulatedDevice(memoryDevice, NVME_DEVICE);
+	if (!sourceFile.open(this->fileName, true)) {
+		delete[] buf;
+		return 0;
+	}
+	size_t deviceSize = std::min(sourceFile.getSize(), size_t(64 * 1024 * 1024));
+	if (deviceType != FILE_STORAGE) {
+		// Copy the first part of the file to memory device
+		memoryDevice.open(this->fileName, false);
+		for (size_t offset = 0; offset < deviceSize; offset += chunkSize) {
+			AsyncBuffer buffer = { buf, std::min(chunkSize, deviceSize - offset) };
+			sourceFile.read(offset, &buffer, 1);
+			memoryDevice.write(offset, &buffer, 1);
+		}
+		memoryDevice.close();
+		cf.setStorageDevice(deviceType == MEMORY_STORAGE ? (StorageDevice*) &memoryDevice : &simulatedDevice);
+	}
+	sourceFile.close();
+
+	cf.open(this->fileName, size_t(deviceSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED random read " << readsCount << " of " << docSize;
+	std::cout << " byte blocks from " << deviceNames[deviceType] << " device...\n\t";
+
+	std::srand(1);
+	size_t totalBytes = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < readsCount; i++) {
+		size_t offset = size_t(randNormal(0.5, this->sigma * 4) * double(deviceSize - docSize));
+		if (offset >= deviceSize - docSize) continue;
+		totalBytes += cf.read(offset, buf, docSize);
+	}
+	auto endTime = std::chrono::steady_clock::now();
+	double duration = std::chrono::duration<double>(endTime - startTime).count();
+	double throughput = double(totalBytes) / (1024.0 * 1024.0) / duration;
+
+	std::cout << "Hits: " << std::setprecision(4) << cf.getStats(CACHE_HITS_RATE) << "%, ";
+	std::cout << "Read throughput: " << throughput << " Mb/sec";
+	if (deviceType == SIMULATED_STORAGE) {
+		std::cout << ", injected delay: " << double(simulatedDevice.getInjectedTimeNs()) / 1000000.0 << " ms";
+	}
+	std::cout << "\n\n";
+
+	cf.close();
+	cf.setStorageDevice(nullptr);
+	delete[] buf;
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Prints latency summary of operations type
+*  @param name - operations type name
+*  @param latency - latency summary (ns)
+*
+*/
+void CachedFileIOTest::printLatency(const char* name, const LatencySummary& latency) {
+	std::cout << "\t" << std::setw(10) << std::left << name << std::right;
+	std::cout << "samples: " << std::setw(7) << latency.count << ", ";
+	std::cout << "p50: " << latency.p50 << " ns, ";
+	std::cout << "p99: " << latency.p99 << " ns, ";
+	std::cout << "p999: " << latency.p999 << " ns, ";
+	std::cout << "max: " << latency.max << " ns\n";
+}
+
+
+
+/**
+*
+*  @brief Large multi-page reads at random offsets with small cache, so most
+*  pages of every read are cache misses
+*  @param asyncIO - load missing pages with group read submission
+*  @param readSize - bytes per read
+*  @return read throughput MB/sec
+*
+*/
+double CachedFileIOTest::cachedLargeReads(bool asyncIO, size_t readSize) {
+
+	const size_t readsCount = 2000;
+	char* buf = new char[readSize];
+
+	cf.setAsyncIO(asyncIO);
+	cf.open(this->fileName, DEFAULT_CACHE);
+	size_t fileSize = cf.getFileSize();
+
+	std::cout << "[TEST]  CACHED large reads of " << readSize / 1024 << "Kb";
+	std::cout << (cf.isAsyncIO() ? " (GROUP submission)" : " (SYNC)") << "...\n\t";
+
+	std::mt19937_64 generator(1);
+	size_t totalBytes = 0;
+	auto startTime = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < readsCount; i++) {
+		size_t position = generator() % (fileSize - readSize);
+		totalBytes += cf.read(position, buf, readSize);
+	}
+	auto endTime = std::chrono::steady_clock::now();
+	double duration = std::chrono::duration<double>(endTime - startTime).count();
+	double throughput = double(totalBytes) / (1024.0 * 1024.0) / duration;
+
+	std::cout << "Read throughput: " << throughput << " Mb/sec, ";
+	std::cout << "batched pages: " << cf.getStats(CachedFileStats::BATCHED_READ_PAGES) << ", ";
+	std::cout << "submit calls: " << cf.getStats(CachedFileStats::ASYNC_SUBMIT_CALLS) << "\n\n";
+
+	cf.close();
+	cf.setAsyncIO(true);
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Random reads with direct I/O (OS page cache bypassed) or buffered
+*  I/O, reports pages pool memory
+*  @param directIO - open file for direct I/O
+*  @param hugePages - back pages pool with huge pages
+*  @return random read throughput in Mb/s
+*
+*/
+double CachedFileIOTest::cachedDirectReads(bool directIO, bool hugePages) {
+
+	char* buf = new char[PAGE_SIZE * 4];
+	size_t length = docSize, bytesRead = 0;
+	size_t offset;
+
+	cf.setDirectIO(directIO);
+	cf.setHugePages(hugePages);
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED random read " << samplesCount << " of " << docSize << " byte blocks";
+	std::cout << (cf.isDirectIO() ? " (DIRECT I/O" : " (BUFFERED I/O");
+	std::cout << (cf.isHugePages() ? ", HUGE PAGES pool)" : ")") << "...\n\t";
+
+	for (size_t i = 0; i < samplesCount; i++) {
+		// generate random
+		offset = size_t(randNormal(0.5, this->sigma) * double(fileSize - length));
+		// offset always positive because its size_t
+		if (offset < fileSize) {
+			cf.read(offset, buf, length);
+			bytesRead += length;
+		}
+	}
+
+	double throughput = cf.getStats(CachedFileStats::READ_THROUGHPUT);
+	std::cout << "Read: " << throughput << " Mb/sec, ";
+	std::cout << "Cache Hit: " << cf.getStats(CachedFileStats::CACHE_HITS_RATE) << "%, ";
+	std::cout << "Pool memory: " << cf.getStats(CachedFileStats::POOL_MEMORY_BYTES) / (1024 * 1024) << " Mb\n\n";
+
+	cf.close();
+	cf.setDirectIO(false);
+	cf.setHugePages(false);
+
+	delete[] buf;
+
+	return throughput;
+}
+
+
+
+/**
+*
+*  @brief Full file scan by document sized reads with cache as 10% size of file
+*  @param readAhead - prefetch next pages of sequential stream
+*  @return scan throughput in Mb/s
+*
+*/
+double CachedFileIOTest::cachedSequentialScan(bool readAhead) {
+
+	char* buf = new char[docSize];
+	size_t bytesRead = 0;
+
+	cf.setReadAhead(readAhead);
+	cf.open(this->fileName);
+	size_t fileSize = cf.getFileSize();
+	cf.setCacheSize(size_t(fileSize * cacheRatio));
+
+	std::cout << "[TEST]  CACHED sequential scan of " << fileSize << " bytes by " << docSize << " byte blocks";
+	std::cout << (readAhead ? " (READ-AHEAD)" : " (NO READ-AHEAD)") << "...\n\t";
+
+	for (size_t offset = 0; offset < fileSize; offset += docSize) {
+		bytesRead += cf.read(offset, buf, docSize);
+	}
+
+	double throughput = cf.getStats(CachedFileStats::READ_THROUGHPUT);
+	std::cout << "Read: " << throughput << " Mb/sec, ";
+	std::cout << "Cache Hit: " << cf.getStats(CachedFileStats::CACHE_HITS_RATE) << "%, ";
+	std::cout << "Prefetched: " << cf.getStats(CachedFileStats::READ_AHEAD_PAGES) << ", ";
+	std::cout << "hits: " << cf.getStats(CachedFileStats::READ_AHEAD_HITS) << ", ";
+	std::cout << "wasted: " << cf.getStats(CachedFileStats::READ_AHEAD_WASTED) << "\n\n";
+
+	cf.close();
+	cf.setReadAhead(true);
+
+	delete[] buf;
+
+	return throughput;
+}
@@ -10,15 +10,26 @@
 
 #include <cstdio>
 #include <iostream>
+#include <iomanip>
 #include <locale>
 #include <chrono>
 #include <thread>
 #include <filesystem>
+#include <vector>
+#include <random>
+#include <atomic>
 
 #include "CachedFileIO.h"
+#include "MappedFileIO.h"
 
 namespace Boson {
 
+	typedef enum {                              // Storage device of device benchmark
+		FILE_STORAGE = 0,                       // OS file
+		MEMORY_STORAGE = 1,                     // Memory device
+		SIMULATED_STORAGE = 2                   // Simulated NVMe over memory device
+	} TestStorageDevice;
+
 	class CachedFileIOTest {
 	public:
 		CachedFileIOTest(char* path);
@@ -35,10 +46,32 @@ namespace Boson {
 		double cachedRandomPageWrites();
 		double cachedRandomWrites();
 		double randNormal(double mean, double stddev);
-		double cachedRandomReads();
+		double cachedRandomReads(CachePolicyType policy = CachePolicyType::LRU);
 		double stdioRandomReads();
 		double cachedRandomPageReads();
+		double mappedRandomReads();
+		double mappedRandomPageReads();
 		double stdioRandomPageReads();
+		double cachedConcurrentReads(size_t threadsCount);
+		void   comparePolicies();
+		double scanResistance(CachePolicyType policy, AccessHint scanHint);
+		void   compareScanResistance();
+		double cachedPageSizeWorkload(size_t pageSize, int workload);
+		void   comparePageSizes();
+		double cachedMixedReadWrites(bool writeBack);
+		double cachedCheckpoint(double dirtyRatio);
+		double cachedSmallUpdates(size_t updateSize);
+		double cachedFlushLatency(size_t cacheSize, size_t dirtyPages = 256);
+		double cachedCacheResize(bool online);
+		double cachedSharedPool(bool shared, size_t filesCount = 50);
+		double cachedSharedPoolFlush();
+		double cachedWarmRestart(bool warmUp);
+		void   cachedLatencyHistograms();
+		void   printLatency(const char* name, const LatencySummary& latency);
+		double cachedStorageDevice(TestStorageDevice deviceType);
+		double cachedLargeReads(bool asyncIO, size_t readSize = 256 * 1024);
+		double cachedDirectReads(bool directIO, bool hugePages);
+		double cachedSequentialScan(bool readAhead);
 	};
 
 }
@@ -10,8 +10,11 @@
 #include "RecordFileIOTest.h"
 
 #include <iostream>
+#include <iomanip>
 #include <sstream>
 #include <filesystem>
+#include <vector>
+#include <algorithm>
 
 
 using namespace Boson;
@@ -203,6 +206,103 @@ bool RecordFileIOTest::insertNewRecords(const char* filename, size_t recordsCoun
 }
 
 
+/*
+*  @brief Random updates, deletes and inserts of 200-5000 bytes JSON documents,
+*  reports allocation latency, storage file growth and space efficiency
+*  @param[in] filename - path to file
+*  @param[in] recordsCount - documents count before churn
+*  @param[in] operations - total churn operations
+*  @param[in] mixedSizes - 80% of 100-1000 bytes and 20% of 1000-16000 bytes documents
+*/
+bool RecordFileIOTest::churnRecords(const char* filename, size_t recordsCount, size_t operations, bool mixedSizes) {
+	std::filesystem::remove(filename);
+	CachedFileIO cachedFile;
+	if (!cachedFile.open(filename)) {
+		std::cout << "ERROR: Can't open file '" << filename << "' in write mode.\n";
+		return false;
+	}
+
+	RecordFileIO storage(cachedFile);
+	std::vector<uint64_t> offsets;
+	std::string document;
+	std::srand(1);
+	for (size_t i = 0; i < recordsCount; i++) {
+		generateDocument(document, i, randomDocumentLength(mixedSizes));
+		offsets.push_back(storage.createRecord(document.c_str(), (uint32_t)document.length()));
+	}
+	uint64_t initialSize = storage.getEndOfFile();
+
+	std::cout << "[TEST] Churn of " << recordsCount << " JSON documents (";
+	std::cout << (mixedSizes ? "100-1000 and 1000-16000" : "200-5000") << " bytes), ";
+	std::cout << operations << " random updates/deletes/inserts...\n";
+
+	// allocating operations are inserts and updates to larger documents
+	std::vector<uint64_t> latencies;
+	latencies.reserve(operations);
+	auto startTime = std::chrono::high_resolution_clock::now();
+	for (size_t i = 0; i < operations; i++) {
+		size_t action = std::rand() % 10;
+		generateDocument(document, recordsCount + i, randomDocumentLength(mixedSizes));
+		uint32_t length = (uint32_t)document.length();
+		if (action < 3 && !offsets.empty()) {
+			size_t index = std::rand() % offsets.size();
+			storage.setPosition(offsets[index]);
+			storage.removeRecord();
+			offsets[index] = offsets.back();
+			offsets.pop_back();
+			continue;
+		}
+		auto opStartTime = std::chrono::high_resolution_clock::now();
+		if (action < 7 && !offsets.empty()) {
+			size_t index = std::rand() % offsets.size();
+			storage.setPosition(offsets[index]);
+			bool allocating = length > storage.getRecordCapacity();
+			offsets[index] = storage.setRecordData(document.c_str(), length);
+			if (!allocating) continue;
+		} else {
+			offsets.push_back(storage.createRecord(document.c_str(), length));
+		}
+		auto opEndTime = std::chrono::high_resolution_clock::now();
+		latencies.push_back((opEndTime - opStartTime).count());
+	}
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	// check consistency of every document
+	size_t corrupted = 0;
+	char* buffer = new char[16384];
+	for (uint64_t offset : offsets) {
+		if (!storage.setPosition(offset) ||
+			storage.getRecordData(buffer, storage.getDataLength()) == NOT_FOUND) corrupted++;
+	}
+	delete[] buffer;
+
+	std::sort(latencies.begin(), latencies.end());
+	double average = 0;
+	for (uint64_t latency : latencies) average += double(latency);
+	if (!latencies.empty()) average /= double(latencies.size());
+	double p99 = latencies.empty() ? 0 : double(latencies[latencies.size() * 99 / 100]);
+	double maximum = latencies.empty() ? 0 : double(latencies.back());
+	uint64_t finalSize = storage.getEndOfFile();
+	constexpr double MB = 1024.0 * 1024.0;
+
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout << "Completed in " << (endTime - startTime).count() / 1000000000.0 << "s, ";
+	std::cout << latencies.size() << " allocations - latency avg " << average / 1000.0 << "us, ";
+	std::cout << "p99 " << p99 / 1000.0 << "us, max " << maximum / 1000.0 << "us\n";
+	std::cout << "[RESULT] File growth: " << initialSize / MB << "Mb -> " << finalSize / MB << "Mb (";
+	std::cout << (double(finalSize) / double(initialSize) - 1.0) * 100.0 << "%), ";
+	std::cout << storage.getTotalFreeRecords() << " free records of " << storage.getFreeSpaceBytes() / MB << "Mb\n";
+	std::cout << "[RESULT] Internal fragmentation: " << storage.getInternalFragmentation() << " bytes per record (";
+	std::cout << double(storage.getRecordBytes() - storage.getDataBytes()) / double(storage.getRecordBytes()) * 100.0;
+	std::cout << "% of records capacity)\n";
+	std::cout << "[RESULT] Space efficiency (live data / file): " << storage.getDataBytes() / MB << "Mb / ";
+	std::cout << finalSize / MB << "Mb = " << double(storage.getDataBytes()) / double(finalSize) * 100.0 << "%";
+	std::cout << " - [" << ((corrupted == 0 && storage.getTotalRecords() == offsets.size()) ? "OK]\n\n" : "FAILED!]\n\n");
+	std::cout << std::defaultfloat;
+	return corrupted == 0;
+}
+
+
 void RecordFileIOTest::run(const char* filename) {
 	std::filesystem::remove(filename);
 	generateData(filename, 10);
@@ -221,4 +321,33 @@ void RecordFileIOTest::runLoadTest(const char* filename, size_t amount) {
 	removeEvenRecords(filename, false);
 	insertNewRecords(filename, amount / 2);
 	readAscending(filename, false);
+	churnRecords(filename, amount / 10, amount);
+	churnRecords(filename, amount / 10, amount, true);
+}
+
+
+/*
+*  @brief Returns random JSON document length
+*  @param[in] mixedSizes - 80% of 100-1000 bytes and 20% of 1000-16000 bytes documents,
+*  otherwise 200-5000 bytes documents
+*/
+size_t RecordFileIOTest::randomDocumentLength(bool mixedSizes) {
+	if (!mixedSizes) return 200 + std::rand() % 4801;
+	if (std::rand() % 5 != 0) return 100 + std::rand() % 901;
+	return 1000 + std::rand() % 15001;
+}
+
+
+/*
+*  @brief Generates JSON document of given length
+*  @param[out] document - generated document
+*  @param[in] id - document id
+*  @param[in] length - document length in bytes
+*/
+void RecordFileIOTest::generateDocument(std::string& document, size_t id, size_t length) {
+	std::stringstream ss;
+	ss << "{\"id\":" << id << ",\"name\":\"document " << id << "\",\"payload\":\"";
+	document = ss.str();
+	if (document.length() + 2 < length) document.append(length - document.length() - 2, 'a' + char(id % 26));
+	document.append("\"}");
 }
\ No newline at end of file
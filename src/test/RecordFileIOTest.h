@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 namespace Boson {
 
 	class RecordFileIOTest {
@@ -9,9 +11,12 @@ namespace Boson {
 		bool readDescending(const char* filename, bool verbose);
 		bool removeEvenRecords(const char* filename, bool verbose);
 		bool insertNewRecords(const char* filename, size_t recordCount);
+		bool churnRecords(const char* filename, size_t recordCount, size_t operations, bool mixedSizes = false);
 		void run(const char* filename);
 		void runLoadTest(const char* filename, size_t amount);
 	private:
+		static void generateDocument(std::string& document, size_t id, size_t length);
+		static size_t randomDocumentLength(bool mixedSizes);
 
 	};
 